@@ -78,6 +78,7 @@ namespace Simulator
         {
             return tag;
         }
+        bool IsPermutation() const { return m_numBanks == 1; }
     };
 
     // DirectSelector: selects bank based on the least significant bits only
@@ -98,6 +99,7 @@ namespace Simulator
         {
             return (tag * m_numBanks) + index;
         }
+        bool IsPermutation() const { return true; }
     };
 
     // Same as above using simple binary arithmetic.
@@ -120,6 +122,7 @@ namespace Simulator
         {
             return (tag << m_bankshift) | index;
         }
+        bool IsPermutation() const { return true; }
     };
 
     // RotationMix4: a naive attempt at randomization
@@ -146,6 +149,8 @@ namespace Simulator
         {
             return tag;
         }
+        // the rotations only mix higher bits into the lowest 4
+        bool IsPermutation() const { return IsPowerOfTwo(m_numBanks) && m_numBanks <= 16; }
     };
 
     // RightXOR: uses a XOR on the two low order blocks of index-sized bits in the address
@@ -165,6 +170,7 @@ namespace Simulator
         {
             return tag;
         }        
+        bool IsPermutation() const { return IsPowerOfTwo(m_numBanks); }
     };
 
     // RightAdd: generalization of RightXOR with integer arithmetic
@@ -183,6 +189,7 @@ namespace Simulator
         {
             return tag;
         }
+        bool IsPermutation() const { return true; }
     };
 
     // XORFold: generalization of RightXOR to use all bits in the address
@@ -209,6 +216,7 @@ namespace Simulator
         {
             return tag;
         }
+        bool IsPermutation() const { return IsPowerOfTwo(m_numBanks); }
     };
 
     // AddFold: generalization of XORFold with integer arithmetic
@@ -234,8 +242,30 @@ namespace Simulator
         {
             return tag;
         }
+        bool IsPermutation() const { return true; }
     };
 
+    size_t IBankSelector::MapInterleaved(MemAddr address, size_t blockSize, MemAddr& local)
+    {
+        const MemAddr block = address / blockSize;
+        MemAddr tag;
+        size_t  index;
+        Map(block, tag, index);
+        if (IsPermutation())
+        {
+            // Each bank gets one block of every aligned group of numBanks
+            // blocks, so the group number tells its blocks apart. This
+            // makes the addresses in a bank dense.
+            local = block / GetNumBanks() * blockSize + address % blockSize;
+        }
+        else
+        {
+            // Blocks of the same group can map to the same bank
+            local = address;
+        }
+        return index;
+    }
+
     IBankSelector* IBankSelector::makeSelector(Object& parent, const std::string& name, size_t numBanks)
     {
         if (numBanks == 1 || name == "ZERO")
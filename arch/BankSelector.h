@@ -17,8 +17,14 @@ namespace Simulator
 
         virtual std::string GetName() const = 0;
         virtual size_t GetNumBanks() const = 0;
+        // does every aligned group of numBanks addresses map to all banks?
+        virtual bool IsPermutation() const = 0;
         virtual ~IBankSelector() {};
 
+        // address to the bank of its interleaving block + address of
+        // the block in the blocks of that bank (e.g. a memory channel)
+        size_t MapInterleaved(MemAddr address, size_t blockSize, MemAddr& local);
+
         static IBankSelector* makeSelector(Object& parent, const std::string& name, size_t numBanks);
     };
 
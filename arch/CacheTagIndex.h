@@ -0,0 +1,135 @@
+#ifndef CACHE_TAG_INDEX_H
+#define CACHE_TAG_INDEX_H
+
+#include "simtypes.h"
+
+#include <cassert>
+#include <vector>
+
+namespace Simulator
+{
+    /// CacheTagIndex: a host-side hash index from the set and tag of the
+    /// present lines of a set-associative structure to their line index,
+    /// for the directories, whose sets have as many ways as all caches
+    /// below them together. A lookup then costs a probe or two instead of
+    /// a scan of every way. The owner keeps the index in sync with the
+    /// lines by inserting a line when it becomes present and erasing it
+    /// when it leaves.
+    /// The table uses open addressing with linear probing and is at most
+    /// half full; erasing shifts the following entries back, so there are
+    /// no tombstones.
+    class CacheTagIndex
+    {
+        struct Entry
+        {
+            MemAddr tag;    ///< Tag of the line
+            size_t  line;   ///< Index of the line, or Empty()
+        };
+
+        std::vector<Entry> m_entries;
+        size_t             m_mask;      ///< Number of entries minus one
+        size_t             m_assoc;     ///< Number of lines in a set
+        size_t             m_numLines;  ///< Number of lines
+
+        static size_t Empty() { return (size_t)-1; }
+
+        size_t Home(size_t set, MemAddr tag) const
+        {
+            // Fibonacci hashing of the tag mixed with the set; the
+            // upper bits of the product are the best mixed
+            const uint64_t h = ((uint64_t)tag ^ ((uint64_t)set << 32) ^ set) * 0x9E3779B97F4A7C15ULL;
+            return (size_t)(h >> 32) & m_mask;
+        }
+
+        bool Matches(const Entry& e, size_t first, MemAddr tag) const
+        {
+            return e.tag == tag && e.line - first < m_assoc;
+        }
+
+    public:
+        /// Returns the index of the line of the set that has the tag,
+        /// or Count() if the set does not contain it
+        size_t Find(size_t set, MemAddr tag) const
+        {
+            const size_t first = set * m_assoc;
+            for (size_t i = Home(set, tag);; i = (i + 1) & m_mask)
+            {
+                const Entry& e = m_entries[i];
+                if (e.line == Empty())
+                {
+                    return m_numLines;
+                }
+                if (Matches(e, first, tag))
+                {
+                    return e.line;
+                }
+            }
+        }
+
+        /// Adds a line that became present; the set must not have the tag yet
+        void Insert(size_t line, MemAddr tag)
+        {
+            assert(line < m_numLines);
+            const size_t set = line / m_assoc;
+            assert(Find(set, tag) == m_numLines);
+
+            size_t i = Home(set, tag);
+            while (m_entries[i].line != Empty())
+            {
+                i = (i + 1) & m_mask;
+            }
+            m_entries[i].tag  = tag;
+            m_entries[i].line = line;
+        }
+
+        /// Removes a line that is no longer present
+        void Erase(size_t line, MemAddr tag)
+        {
+            const size_t set   = line / m_assoc;
+            const size_t first = set * m_assoc;
+
+            size_t i = Home(set, tag);
+            while (!Matches(m_entries[i], first, tag))
+            {
+                assert(m_entries[i].line != Empty());
+                i = (i + 1) & m_mask;
+            }
+            assert(m_entries[i].line == line);
+
+            // Move back the entries of the cluster that can fill the hole,
+            // i.e. those whose home is not between the hole and them
+            for (size_t j = (i + 1) & m_mask; m_entries[j].line != Empty(); j = (j + 1) & m_mask)
+            {
+                const Entry& e = m_entries[j];
+                const size_t home = Home(e.line / m_assoc, e.tag);
+                if (((j - home) & m_mask) >= ((j - i) & m_mask))
+                {
+                    m_entries[i] = e;
+                    i = j;
+                }
+            }
+            m_entries[i].line = Empty();
+        }
+
+        size_t Count() const { return m_numLines; }
+
+        /// Sets the geometry; all lines become absent
+        void Resize(size_t sets, size_t assoc)
+        {
+            size_t size = 1;
+            while (size < 2 * sets * assoc)
+            {
+                size *= 2;
+            }
+            const Entry empty = {0, Empty()};
+            m_entries.assign(size, empty);
+            m_mask     = size - 1;
+            m_assoc    = assoc;
+            m_numLines = sets * assoc;
+        }
+
+        CacheTagIndex() : m_mask(0), m_assoc(0), m_numLines(0) {}
+    };
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef CACHE_TAGS_H
+#define CACHE_TAGS_H
+
+#include "simtypes.h"
+
+#include <cassert>
+#include <vector>
+
+namespace Simulator
+{
+    /// CacheTags: the address tags of the lines of a set-associative
+    /// cache, stored apart from the other line fields so that looking up
+    /// a set only reads the tags of its ways, which are contiguous (e.g.
+    /// 16 ways of 64-bit tags fill two host cache lines).
+    /// Empty lines have the tag INVALID, so the lookup needs not consult
+    /// the line state. No address maps to it, because the tags are
+    /// derived from line addresses, i.e. addresses divided by the line size.
+    class CacheTags
+    {
+        std::vector<MemAddr> m_tags;
+        size_t               m_assoc;
+
+    public:
+        static MemAddr Invalid() { return (MemAddr)-1; }
+
+        /// Returns the index of the line of the set that has the tag,
+        /// or Count() if the set does not contain it
+        size_t Find(size_t set, MemAddr tag) const
+        {
+            const size_t   first = set * m_assoc;
+            const MemAddr* tags  = &m_tags[first];
+            for (size_t i = 0; i < m_assoc; ++i)
+            {
+                if (tags[i] == tag)
+                {
+                    return first + i;
+                }
+            }
+            return m_tags.size();
+        }
+
+        MemAddr Get(size_t line) const { return m_tags[line]; }
+        bool IsEmpty(size_t line) const { return m_tags[line] == Invalid(); }
+        void Set(size_t line, MemAddr tag) { assert(tag != Invalid()); m_tags[line] = tag; }
+        void Clear(size_t line) { m_tags[line] = Invalid(); }
+        size_t Count() const { return m_tags.size(); }
+
+        /// Sets the geometry; all lines become empty
+        void Resize(size_t sets, size_t assoc)
+        {
+            m_tags.assign(sets * assoc, Invalid());
+            m_assoc = assoc;
+        }
+
+        CacheTags() : m_assoc(0) {}
+    };
+}
+
+#endif
@@ -11,8 +11,12 @@ namespace Simulator
 typedef size_t  IODeviceID;     ///< Number of a device on an I/O Bus
 typedef size_t  IONotificationChannelID;  ///< Number of a notification/interrupt channel on an I/O bus
 
-/* maximum size of the data in an I/O request. */
-static const size_t MAX_IO_OPERATION_SIZE = 64;
+/* maximum size of the data in an I/O request. This allows DCA bursts
+   of several cache lines in one bus transaction. Every IOData has room
+   for this much, but I/O requests are only buffered in the I/O
+   interfaces of the cores with EnableIO, and the buffers only hold the
+   requests in flight, so the size costs a few KiB per such core. */
+static const size_t MAX_IO_OPERATION_SIZE = 256;
 
 /* the data for an I/O request. */
 struct IOData
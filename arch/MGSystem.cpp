@@ -1,6 +1,7 @@
 #include "MGSystem.h"
 
 #include "mem/SerialMemory.h"
+#include "mem/FixedLatencyMemory.h"
 #include "mem/ParallelMemory.h"
 #include "mem/BankedMemory.h"
 #include "mem/DDRMemory.h"
@@ -30,6 +31,10 @@
 #include <cxxabi.h>
 #include <fnmatch.h>
 #include <cstring>
+#include <sys/time.h>
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
 
 using namespace Simulator;
 using namespace std;
@@ -433,6 +438,33 @@ void MGSystem::PrintMemoryStatistics(ostream& os) const {
 
 }
 
+void MGSystem::PrintMemoryLatencies(ostream& os) const
+{
+    // The histograms of the cores that made requests, then those of the system
+    LatencyHistogram dreads, dwrites, ireads;
+
+    os << "# core cycles from the request to memory to its completion" << endl;
+    LatencyHistogram::PrintHeader(os);
+    for (size_t i = 0; i < m_procs.size(); ++i)
+    {
+        const Processor::DCache& dcache = m_procs[i]->GetDCache();
+        const Processor::ICache& icache = m_procs[i]->GetICache();
+        if (dcache.GetReadLatency().GetCount() != 0)
+            dcache.GetReadLatency().Print(os, dcache.GetFQN() + ":reads");
+        if (dcache.GetWriteLatency().GetCount() != 0)
+            dcache.GetWriteLatency().Print(os, dcache.GetFQN() + ":writes");
+        if (icache.GetReadLatency().GetCount() != 0)
+            icache.GetReadLatency().Print(os, icache.GetFQN() + ":reads");
+
+        dreads  += dcache.GetReadLatency();
+        dwrites += dcache.GetWriteLatency();
+        ireads  += icache.GetReadLatency();
+    }
+    dreads.Print(os, "dcache:reads");
+    dwrites.Print(os, "dcache:writes");
+    ireads.Print(os, "icache:reads");
+}
+
 void MGSystem::PrintState(const vector<string>& /*unused*/) const
 {
     // This should be all non-idle processes
@@ -500,6 +532,113 @@ void MGSystem::PrintAllStatistics(ostream& os) const
     PrintCoreStats(os);
     os << "## memory statistics:" << endl;
     PrintMemoryStatistics(os);
+    os << "## memory latency statistics:" << endl;
+    PrintMemoryLatencies(os);
+}
+
+namespace {
+    // Startup costs of all components of one kind
+    struct StartupTotal
+    {
+        size_t    count;
+        double    seconds;
+        long long heap;
+        double    max_seconds;
+        long long max_heap;
+    };
+
+    // Measures the wall time and heap growth of one step of the system
+    // construction, for the startup report. The heap size is what malloc
+    // has handed out, so it includes the allocations of the containers
+    // and sample variables that a component registers elsewhere, but not
+    // memory that is mapped without malloc.
+    class StartupProbe
+    {
+        struct timeval m_time;
+        long long      m_heap;
+
+        static long long GetHeapSize()
+        {
+#if defined(HAVE_MALLINFO2)
+            struct mallinfo2 mi = mallinfo2();
+            return (long long)(mi.uordblks + mi.hblkhd);
+#elif defined(HAVE_MALLINFO)
+            // The counters of mallinfo are ints, so this wraps beyond 2GB
+            struct mallinfo mi = mallinfo();
+            return (long long)(unsigned int)mi.uordblks + (unsigned int)mi.hblkhd;
+#else
+            return -1;
+#endif
+        }
+
+    public:
+        void Start()
+        {
+            gettimeofday(&m_time, NULL);
+            m_heap = GetHeapSize();
+        }
+
+        MGSystem::StartupCost Stop(const string& name) const
+        {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            long long heap = GetHeapSize();
+
+            MGSystem::StartupCost c;
+            c.name    = name;
+            c.seconds = (now.tv_sec - m_time.tv_sec) + (now.tv_usec - m_time.tv_usec) / 1e6;
+            c.heap    = (m_heap < 0) ? -1 : heap - m_heap;
+            return c;
+        }
+
+        StartupProbe() { Start(); }
+    };
+}
+
+void MGSystem::PrintStartupReport(ostream& os) const
+{
+    // Totals per kind of component, i.e. the name without its number,
+    // for the kinds that occur more than once
+    vector<pair<string, StartupTotal> > totals;
+
+    const ios::fmtflags flags = os.flags();
+    const streamsize precision = os.precision();
+
+    os << "### begin startup report" << endl
+       << "# component\tseconds\theap bytes" << endl;
+    for (size_t i = 0; i < m_startupCosts.size(); ++i)
+    {
+        const StartupCost& c = m_startupCosts[i];
+        os << c.name << '\t' << fixed << setprecision(6) << c.seconds << '\t' << c.heap << endl;
+
+        string kind = c.name.substr(0, c.name.find_last_not_of("0123456789") + 1);
+        size_t k = 0;
+        while (k < totals.size() && totals[k].first != kind) ++k;
+        if (k == totals.size())
+        {
+            StartupTotal t = {0, 0, 0, 0, 0};
+            totals.push_back(make_pair(kind, t));
+        }
+        StartupTotal& t = totals[k].second;
+        t.count++;
+        t.seconds += c.seconds;
+        t.heap = (t.heap < 0 || c.heap < 0) ? -1 : t.heap + c.heap;
+        t.max_seconds = max(t.max_seconds, c.seconds);
+        t.max_heap = max(t.max_heap, c.heap);
+    }
+
+    os << "# kind\tcount\tseconds\theap bytes\tmax seconds\tmax heap bytes" << endl;
+    for (size_t k = 0; k < totals.size(); ++k)
+    {
+        const StartupTotal& t = totals[k].second;
+        if (t.count == 1)
+            continue;
+        os << "# " << totals[k].first << '\t' << t.count << '\t' << fixed << setprecision(6) << t.seconds << '\t' << t.heap
+           << '\t' << t.max_seconds << '\t' << t.max_heap << endl;
+    }
+    os << "### end startup report" << endl;
+    os.flags(flags);
+    os.precision(precision);
 }
 
 // Steps the entire system this many cycles
@@ -627,8 +766,10 @@ MGSystem::MGSystem(Config& config,
       m_root("", m_clock),
       m_breakpoints(m_kernel),
       m_config(config),
-      m_bootrom(NULL)
+      m_bootrom(NULL),
+      m_timeline(NULL)
 {
+    StartupProbe total, probe;
 
     if (!quiet)
     {
@@ -646,9 +787,13 @@ MGSystem::MGSystem(Config& config,
 
     Clock& memclock = m_kernel.CreateClock(config.getValue<size_t>("MemoryFreq"));
 
+    probe.Start();
     if (memory_type == "SERIAL") {
         SerialMemory* memory = new SerialMemory("memory", m_root, memclock, config);
         m_memory = memory;
+    } else if (memory_type == "FIXEDLATENCY") {
+        FixedLatencyMemory* memory = new FixedLatencyMemory("memory", m_root, memclock, config);
+        m_memory = memory;
     } else if (memory_type == "PARALLEL") {
         ParallelMemory* memory = new ParallelMemory("memory", m_root, memclock, config);
         m_memory = memory;
@@ -676,6 +821,7 @@ MGSystem::MGSystem(Config& config,
     } else {
         throw runtime_error("Unknown memory type: " + memory_type);
     }
+    m_startupCosts.push_back(probe.Stop("memory"));
     if (!quiet)
     {
         clog << "memory: " << memory_type << endl;
@@ -683,7 +829,9 @@ MGSystem::MGSystem(Config& config,
 
     // Create the event selector
     Clock& selclock = m_kernel.CreateClock(config.getValue<unsigned long>("EventCheckFreq"));
+    probe.Start();
     m_selector = new Selector("selector", m_root, selclock, config);
+    m_startupCosts.push_back(probe.Stop("selector"));
 
     // Create the I/O Buses
     const size_t numIOBuses = config.getValue<size_t>("NumIOBuses");
@@ -697,6 +845,7 @@ MGSystem::MGSystem(Config& config,
         string bus_type = config.getValue<string>(m_root, name, "Type");
         Clock& ioclock = m_kernel.CreateClock(config.getValue<unsigned long>(m_root, name, "Freq"));
 
+        probe.Start();
         if (bus_type == "NULLIO") {
             NullIO* bus = new NullIO(name, m_root, ioclock);
             m_iobuses[b] = bus;
@@ -705,6 +854,7 @@ MGSystem::MGSystem(Config& config,
         } else {
             throw runtime_error("Unknown I/O bus type for " + name + ": " + bus_type);
         }
+        m_startupCosts.push_back(probe.Stop(name));
 
         if (!quiet)
         {
@@ -718,7 +868,9 @@ MGSystem::MGSystem(Config& config,
     {
         stringstream name;
         name << "fpu" << f;
+        probe.Start();
         m_fpus[f] = new FPU(name.str(), m_root, m_clock, config, numProcessorsPerFPU);
+        m_startupCosts.push_back(probe.Stop(name.str()));
 
         config.registerObject(*m_fpus[f], "fpu");
         config.registerProperty(*m_fpus[f], "freq", (uint32_t)m_clock.GetFrequency());
@@ -728,6 +880,14 @@ MGSystem::MGSystem(Config& config,
         clog << numFPUs << " FPUs instantiated." << endl;
     }
 
+    // The timeline of the families and threads is only kept when it is
+    // written at the end of the simulation
+    m_timelineFile = config.getValueOrDefault<string>("TimelineFile", "");
+    if (!m_timelineFile.empty())
+    {
+        m_timeline = new Timeline(m_clock.GetFrequency());
+    }
+
     // Create processor grid
     m_procs.resize(numProcessors);
     for (size_t i = 0; i < numProcessors; ++i)
@@ -756,12 +916,30 @@ MGSystem::MGSystem(Config& config,
             }
         }
 
+        probe.Start();
         m_procs[i]   = new Processor(name, m_root, m_clock, i, m_procs, *m_memory, *m_memory, fpu, iobus, config);
+        m_procs[i]->SetTimeline(m_timeline);
+        m_startupCosts.push_back(probe.Stop(name));
     }
     if (!quiet)
     {
         clog << numProcessors << " cores instantiated." << endl;
     }
+
+    // The cores with EnableProfiler set have a profiler, whose costs are
+    // written at the end of the simulation
+    for (size_t i = 0; i < numProcessors; ++i)
+    {
+        if (m_procs[i]->GetProfiler() != NULL)
+        {
+            m_profileFile = config.getValueOrDefault<string>("ProfileFile", "callgrind.out.mgsim");
+            break;
+        }
+    }
+    if (!m_profileFile.empty() || m_timeline != NULL)
+    {
+        RegisterFinalOutputs(*this);
+    }
     
     // Create the I/O devices
     vector<string> dev_names = extradevs;
@@ -772,7 +950,9 @@ MGSystem::MGSystem(Config& config,
     m_devices.resize(numIODevices);
     vector<ActiveROM*> aroms;
 
+    probe.Start();
     UnixInterface *uif = new UnixInterface("unix_if", m_root);
+    m_startupCosts.push_back(probe.Stop("unix_if"));
     m_devices.push_back(uif);
 
     for (size_t i = 0; i < numIODevices; ++i)
@@ -801,6 +981,7 @@ MGSystem::MGSystem(Config& config,
             clog << name << ": connected to " << dynamic_cast<Object&>(iobus).GetName() << " (type " << dev_type << ", devid " << dec << devid << ')' << endl;
         }
 
+        probe.Start();
         if (dev_type == "LCD") {
             LCD *lcd = new LCD(name, m_root, iobus, devid, config);
             m_devices[i] = lcd;
@@ -835,6 +1016,7 @@ MGSystem::MGSystem(Config& config,
         } else {
             throw runtime_error("Unknown I/O device type: " + dev_type);
         }
+        m_startupCosts.push_back(probe.Stop(name));
 
         config.registerBidiRelation(iobus, *m_devices[i], "client", (uint32_t)devid);
     }
@@ -858,9 +1040,12 @@ MGSystem::MGSystem(Config& config,
     }
 
     // Initialize the memory
+    probe.Start();
     m_memory->Initialize();
+    m_startupCosts.push_back(probe.Stop("memory.init"));
 
     // Connect processors in the link
+    probe.Start();
     for (size_t i = 0; i < numProcessors; ++i)
     {
         Processor* prev = (i == 0)                 ? NULL : m_procs[i - 1];
@@ -870,11 +1055,15 @@ MGSystem::MGSystem(Config& config,
             config.registerRelation(*m_procs[i], *next, "link", true);
     }
 
+    m_startupCosts.push_back(probe.Stop("cpus.init"));
+
     // Initialize the buses. This initializes the devices as well.
+    probe.Start();
     for (size_t i = 0; i < m_iobuses.size(); ++i)
     {
         m_iobuses[i]->Initialize();
     }
+    m_startupCosts.push_back(probe.Stop("iobuses.init"));
 
     // Check for bootable ROMs. This must happen after I/O bus
     // initialization because the ROM contents are loaded then.
@@ -930,8 +1119,10 @@ MGSystem::MGSystem(Config& config,
     // Load symbol table
     if (doload && !symtable.empty())
     {
+        probe.Start();
         ifstream in(symtable.c_str(), ios::in);
         m_symtable.Read(in, quiet);
+        m_startupCosts.push_back(probe.Stop("symtable"));
     }
 
     // Find objdump command
@@ -947,6 +1138,8 @@ MGSystem::MGSystem(Config& config,
     if (!v) v = default_objdump;
     m_objdump_cmd = v;
 
+    m_startupCosts.push_back(total.Stop("total"));
+
     if (!quiet)
     {
         static char const qual[] = {'M', 'G', 'T', 'P', 'E', 'Z', 'Y'};
@@ -959,8 +1152,89 @@ MGSystem::MGSystem(Config& config,
     }
 }
 
+/// The system whose profile and timeline are yet to be written. The
+/// program can end the simulation with exit(), which skips the
+/// destructor, so they are also written by an exit handler.
+static MGSystem* final_outputs_system = NULL;
+
+static void WriteFinalOutputsAtExit()
+{
+    if (final_outputs_system != NULL)
+    {
+        final_outputs_system->WriteFinalOutputs();
+        final_outputs_system = NULL;
+    }
+}
+
+void MGSystem::RegisterFinalOutputs(MGSystem& system)
+{
+    static bool registered = false;
+    if (!registered)
+    {
+        atexit(WriteFinalOutputsAtExit);
+        registered = true;
+    }
+    final_outputs_system = &system;
+}
+
+void MGSystem::WriteFinalOutputs() const
+{
+    if (!m_profileFile.empty())
+    {
+        WriteProfile();
+    }
+    if (m_timeline != NULL)
+    {
+        WriteTimeline();
+    }
+}
+
+void MGSystem::WriteTimeline() const
+{
+    ofstream out(m_timelineFile.c_str(), ios::out);
+    if (!out)
+    {
+        cerr << "Warning: unable to write the timeline to " << m_timelineFile << endl;
+        return;
+    }
+    m_timeline->Write(out, m_procs.size(), m_symtable);
+}
+
+void MGSystem::WriteProfile() const
+{
+    ofstream out(m_profileFile.c_str(), ios::out);
+    if (!out)
+    {
+        cerr << "Warning: unable to write the profile to " << m_profileFile << endl;
+        return;
+    }
+
+    Processor::Profiler::Costs totals;
+    for (size_t i = 0; i < m_procs.size(); ++i)
+    {
+        if (const Processor::Profiler* profiler = m_procs[i]->GetProfiler())
+        {
+            totals += profiler->GetTotals();
+        }
+    }
+
+    Processor::Profiler::WriteHeader(out, totals);
+    for (size_t i = 0; i < m_procs.size(); ++i)
+    {
+        if (const Processor::Profiler* profiler = m_procs[i]->GetProfiler())
+        {
+            profiler->Write(out, m_symtable);
+        }
+    }
+}
+
 MGSystem::~MGSystem()
 {
+    if (final_outputs_system == this)
+    {
+        WriteFinalOutputs();
+        final_outputs_system = NULL;
+    }
     for (size_t i = 0; i < m_iobuses.size(); ++i)
     {
         delete m_iobuses[i];
@@ -979,4 +1253,5 @@ MGSystem::~MGSystem()
     }
     delete m_selector;
     delete m_memory;
+    delete m_timeline;
 }
@@ -20,6 +20,16 @@ namespace Simulator {
 
     class MGSystem
     {
+    public:
+        // Construction cost of a top-level component, for the startup report
+        struct StartupCost
+        {
+            std::string name;
+            double      seconds;  ///< Wall time to construct the component
+            long long   heap;     ///< Heap bytes allocated meanwhile, or -1 if unknown
+        };
+
+    private:
         Kernel                      m_kernel;
         Clock&                      m_clock;    ///< Master clock for the system
         Object                      m_root;     ///< Root object for the system
@@ -36,6 +46,12 @@ namespace Simulator {
         Config&            m_config;
         ActiveROM*         m_bootrom;
         Selector*          m_selector;
+        std::vector<StartupCost> m_startupCosts;
+        std::string        m_profileFile;   ///< Where the profile goes, if any core has a profiler
+        Timeline*          m_timeline;      ///< The timeline of the cores, if enabled
+        std::string        m_timelineFile;
+
+        static void RegisterFinalOutputs(MGSystem& system);
 
         // Writes the current configuration into memory and returns its address
         MemAddr WriteConfiguration();
@@ -75,12 +91,24 @@ namespace Simulator {
         void DumpArea(std::ostream& os, unsigned int tech) const;
 
         void PrintMemoryStatistics(std::ostream& os) const;
+        void PrintMemoryLatencies(std::ostream& os) const;
         void PrintState(const std::vector<std::string>& arguments) const;
         void PrintRegFileAsyncPortActivity(std::ostream& os) const;
         void PrintAllFamilyCompletions(std::ostream& os) const;
         void PrintFamilyCompletions(std::ostream& os) const;
         void PrintCoreStats(std::ostream& os) const;
         void PrintAllStatistics(std::ostream& os) const;
+        void PrintStartupReport(std::ostream& os) const;
+
+        // Writes the costs of the profiled cores in the callgrind format
+        void WriteProfile() const;
+
+        // Writes the timeline of the families and threads
+        void WriteTimeline() const;
+
+        // Writes the profile and timeline, if enabled; done at the end of
+        // the simulation
+        void WriteFinalOutputs() const;
 
         const Kernel& GetKernel() const { return m_kernel; }
         Kernel& GetKernel()       { return m_kernel; }
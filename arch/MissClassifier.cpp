@@ -0,0 +1,76 @@
+#include "MissClassifier.h"
+#include "sim/kernel.h"
+#include "sim/sampling.h"
+
+#include <iomanip>
+
+using namespace std;
+
+namespace Simulator
+{
+
+// Makes the line the most recently used one of the shadow cache,
+// evicting the least recently used one if the line was not in it
+void MissClassifier::Touch(MemAddr address)
+{
+    LineMap::iterator p = m_lines.find(address);
+    if (p != m_lines.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, p->second);
+        return;
+    }
+
+    if (m_lru.size() == m_numLines)
+    {
+        m_lines.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+    m_lru.push_front(address);
+    m_lines.insert(make_pair(address, m_lru.begin()));
+}
+
+void MissClassifier::Miss(MemAddr address)
+{
+    if (m_seen.insert(address).second)
+    {
+        ++m_numCompulsoryMisses;
+    }
+    else if (m_lines.find(address) == m_lines.end())
+    {
+        ++m_numCapacityMisses;
+    }
+    else
+    {
+        ++m_numConflictMisses;
+    }
+    Touch(address);
+}
+
+void MissClassifier::Print(ostream& out) const
+{
+    const uint64_t numMisses = GetNumMisses();
+    const float    factor    = 100.0f / numMisses;
+
+    out << "Classification of " << numMisses << " misses against a fully associative LRU cache:" << endl;
+    if (numMisses != 0)
+    {
+#define PRINTVAL(X, q) dec << (X) << " (" << setprecision(2) << fixed << (X) * q << "%)"
+        out << "- compulsory (first access to the line): " << PRINTVAL(m_numCompulsoryMisses, factor) << endl
+            << "- capacity (fully associative miss):     " << PRINTVAL(m_numCapacityMisses, factor) << endl
+            << "- conflict (fully associative hit):      " << PRINTVAL(m_numConflictMisses, factor) << endl;
+    }
+    out << endl;
+}
+
+MissClassifier::MissClassifier(Object& cache, size_t numLines)
+    : m_numLines(numLines),
+      m_numCompulsoryMisses(0),
+      m_numCapacityMisses(0),
+      m_numConflictMisses(0)
+{
+    RegisterSampleVariable(m_numCompulsoryMisses, cache.GetFQN() + ":numCompulsoryMisses", SVC_CUMULATIVE);
+    RegisterSampleVariable(m_numCapacityMisses,   cache.GetFQN() + ":numCapacityMisses",   SVC_CUMULATIVE);
+    RegisterSampleVariable(m_numConflictMisses,   cache.GetFQN() + ":numConflictMisses",   SVC_CUMULATIVE);
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef MISS_CLASSIFIER_H
+#define MISS_CLASSIFIER_H
+
+#include "simtypes.h"
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+
+namespace Simulator
+{
+    class Object;
+
+    /// MissClassifier: sorts the misses of a cache into compulsory,
+    /// capacity and conflict misses. It keeps the set of lines that the
+    /// cache ever accessed and the tags of a fully associative LRU cache
+    /// with as many lines. A miss on a line that was never accessed is
+    /// compulsory; a miss that the fully associative cache would also
+    /// have is a capacity miss; the other misses are conflict misses.
+    /// Misses on lines that another cache invalidated are not told apart,
+    /// and count as one of the three.
+    /// The set of accessed lines grows with the footprint of the program,
+    /// so caches only have a classifier when ClassifyMisses is set.
+    class MissClassifier
+    {
+        typedef std::list<MemAddr>                          LRUList;
+        typedef std::map<MemAddr, LRUList::iterator>        LineMap;
+
+        size_t            m_numLines;
+        LRUList           m_lru;      ///< Lines of the shadow cache, most recently used first
+        LineMap           m_lines;    ///< Position of the lines in m_lru
+        std::set<MemAddr> m_seen;     ///< All lines ever accessed
+
+        uint64_t          m_numCompulsoryMisses;
+        uint64_t          m_numCapacityMisses;
+        uint64_t          m_numConflictMisses;
+
+        void Touch(MemAddr address);
+
+    public:
+        /// The cache hit on, or is loading, the line of the address
+        void Hit(MemAddr address) { Touch(address); }
+
+        /// The cache missed on the line of the address, and loads it
+        void Miss(MemAddr address);
+
+        uint64_t GetNumMisses() const { return m_numCompulsoryMisses + m_numCapacityMisses + m_numConflictMisses; }
+
+        /// Prints the counts for the statistics of the cache
+        void Print(std::ostream& out) const;
+
+        MissClassifier(Object& cache, size_t numLines);
+    };
+}
+
+#endif
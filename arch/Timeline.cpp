@@ -0,0 +1,97 @@
+#include "Timeline.h"
+#include "symtable.h"
+
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace Simulator
+{
+
+// Quotes a string for JSON; symbols need not be plain identifiers
+static string Quote(const string& s)
+{
+    string q = "\"";
+    for (string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+        if (*p == '"' || *p == '\\') {
+            q += '\\';
+        }
+        q += *p;
+    }
+    return q + "\"";
+}
+
+// Names a family, thread or core, e.g. F2
+static string Name(const char* prefix, uint64_t n)
+{
+    ostringstream s;
+    s << prefix << n;
+    return s.str();
+}
+
+void Timeline::Write(ostream& out, size_t numCores, const SymbolTable& symtable) const
+{
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << endl;
+
+    // Name the cores and keep them in order
+    for (size_t i = 0; i < numCores; ++i)
+    {
+        out << "{\"ph\":\"M\",\"pid\":" << i << ",\"name\":\"process_name\",\"args\":{\"name\":\"cpu" << i << "\"}}," << endl
+            << "{\"ph\":\"M\",\"pid\":" << i << ",\"name\":\"process_sort_index\",\"args\":{\"sort_index\":" << i << "}}";
+        if (i + 1 < numCores || !m_events.empty())
+        {
+            out << ",";
+        }
+        out << endl;
+    }
+
+    // The timestamps are in microseconds of simulated time
+    out << fixed << setprecision(6);
+    for (vector<Event>::const_iterator p = m_events.begin(); p != m_events.end(); ++p)
+    {
+        const bool  thread = (p->type >= THREAD_ALLOCATE && p->type <= THREAD_KILL);
+        const char* phase  = "n";
+        string      name   = "";
+        string      args   = "";
+
+        // The slices of a family or thread are nested in the slice of
+        // its lifetime, which has its name
+        switch (p->type)
+        {
+        case FAMILY_ALLOCATE:  phase = "b"; break;
+        case FAMILY_RELEASE:   phase = "e"; break;
+        case FAMILY_CREATE:    phase = "b"; name = "active"; args = "\"pc\":" + Quote(symtable[p->arg]); break;
+        case FAMILY_TERMINATE: phase = "e"; name = "active"; break;
+        case FAMILY_SYNC:      name = "synchronized"; break;
+        case THREAD_ALLOCATE:  phase = "b"; args = "\"family\":" + Quote(Name("F", p->arg)); break;
+        case THREAD_KILL:      phase = "e"; break;
+        case THREAD_SUSPEND:   phase = "b"; name = "suspended"; break;
+        case THREAD_ACTIVATE:  phase = "e"; name = "suspended"; break;
+        case SYNC_REQUEST:     name = "sync request";   args = "\"from\":" + Quote(Name("cpu", p->arg)); break;
+        case SYNC_WRITEBACK:   name = "sync writeback"; args = "\"to\":"   + Quote(Name("cpu", p->arg)); break;
+        }
+
+        const string id = Name(thread ? "T" : "F", p->id);
+        if (name.empty())
+        {
+            name = id;
+        }
+
+        out << "{\"ph\":\"" << phase << "\",\"cat\":\"" << (thread ? "thread" : "family") << "\""
+            << ",\"name\":" << Quote(name)
+            << ",\"id\":\"cpu" << p->core << "/" << id << "\""
+            << ",\"pid\":" << p->core << ",\"tid\":0"
+            << ",\"ts\":" << (double)p->cycle / m_frequency;
+
+        if (!args.empty())
+        {
+            out << ",\"args\":{" << args << "}";
+        }
+        out << "}" << (p + 1 != m_events.end() ? "," : "") << endl;
+    }
+    out << "]}" << endl;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "sim/kernel.h"
+#include "simtypes.h"
+
+#include <iostream>
+#include <vector>
+
+class SymbolTable;
+
+namespace Simulator
+{
+
+/// Timeline: a trace of when the families and threads of each core are
+/// allocated, run, wait, synchronize and are released, for viewing the
+/// concurrency of a program. The cores record the events in a buffer in
+/// memory, which is written at the end of the simulation in the Chrome
+/// trace-event format, as read by chrome://tracing and Perfetto. Each
+/// core is a process in the trace; its families and threads are async
+/// slices, so that the viewers put them on rows below the core.
+class Timeline
+{
+public:
+    enum EventType
+    {
+        FAMILY_ALLOCATE,    ///< Family table entry allocated
+        FAMILY_CREATE,      ///< Family created; its threads start; arg is the PC
+        FAMILY_TERMINATE,   ///< All threads of the family on the core have ended
+        FAMILY_SYNC,        ///< Family synchronized on the core
+        FAMILY_RELEASE,     ///< Family table entry released
+        THREAD_ALLOCATE,    ///< Thread started; arg is its family
+        THREAD_SUSPEND,     ///< Thread suspended
+        THREAD_ACTIVATE,    ///< Suspended thread is ready again
+        THREAD_KILL,        ///< Thread ended
+        SYNC_REQUEST,       ///< Sync request for the family received; arg is the core to reply to
+        SYNC_WRITEBACK,     ///< Sync writeback for the family sent; arg is its core
+    };
+
+    void Record(CycleNo cycle, PID core, EventType type, unsigned int id, uint64_t arg = 0)
+    {
+        const Event event = {cycle, arg, core, id, type};
+        m_events.push_back(event);
+    }
+
+    /// Writes the trace, with the cores named as in the system
+    void Write(std::ostream& out, size_t numCores, const SymbolTable& symtable) const;
+
+    /// frequency is that of the clock of the cores, in MHz
+    Timeline(unsigned long long frequency) : m_frequency(frequency) {}
+
+private:
+    struct Event
+    {
+        CycleNo      cycle;
+        uint64_t     arg;
+        PID          core;
+        unsigned int id;    ///< Family or thread on the core
+        EventType    type;
+    };
+
+    std::vector<Event>  m_events;
+    unsigned long long  m_frequency;
+};
+
+}
+#endif
@@ -166,6 +166,10 @@ namespace Simulator
         {
             throw exceptf<InvalidArgumentException>(*this, "ROMLineSize cannot be zero");
         }
+        if (m_lineSize > MAX_IO_OPERATION_SIZE)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "ROMLineSize cannot be larger than %u", (unsigned)MAX_IO_OPERATION_SIZE);
+        }
     }
 
     void ActiveROM::Initialize()
@@ -1,7 +1,9 @@
 #include "Display.h"
+#include "FrameCapture.h"
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
 
 #ifdef USE_SDL
 #include <SDL.h>
@@ -53,6 +55,7 @@ namespace Simulator
 
         COMMIT {
             memcpy(&disp.m_framebuffer[address], iodata.data, iodata.size);
+            disp.MarkDirty(address, iodata.size);
         }
 
         DebugIOWrite("FB write: %#016llx/%u", (unsigned long long)address, (unsigned)iodata.size);
@@ -164,6 +167,9 @@ namespace Simulator
         {
             COMMIT {
                 disp.m_palette[word - 0x100] = value;
+                disp.m_redraw = true;
+                if (disp.m_capture != NULL)
+                    disp.m_capture->MarkChanged();
             }
         }
         return true;
@@ -254,6 +260,11 @@ namespace Simulator
           m_screen(NULL),
           m_max_screen_h(1024), m_max_screen_w(1280),
           m_enabled(false),
+          m_dirtyRows(m_height, 0),
+          m_dirty(false),
+          m_redraw(true),
+          m_nConvertedRows(0),
+          m_capture(NULL),
           m_ctlinterface("ctl", *this, iobus, ctldevid),
           m_fbinterface("fb", *this, iobus, fbdevid)
     {
@@ -266,6 +277,12 @@ namespace Simulator
         RegisterSampleVariableInObject(m_scaley, SVC_LEVEL);
         RegisterSampleVariableInObject(m_refreshDelay, SVC_LEVEL);
         RegisterSampleVariableInObject(m_lastUpdate, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nConvertedRows, SVC_CUMULATIVE);
+
+        if (config.getValueOrDefault<std::string>(*this, "GfxCaptureMode", "NONE") != "NONE")
+        {
+            m_capture = new FrameCapture("capture", *this, config);
+        }
 
 #ifdef USE_SDL
         if (config.getValue<bool>(*this, "GfxEnableSDLOutput"))
@@ -274,6 +291,8 @@ namespace Simulator
                 throw InvalidArgumentException(*this, "Only one Display device can output to SDL.");
             m_singleton = this;
 
+            GetKernel()->RegisterHostHook(*this, std::max(1U, m_refreshDelay), 0);
+
             if (SDL_Init(SDL_INIT_VIDEO) < 0) {
                 std::cerr << "Unable to initialize SDL: " << SDL_GetError() << std::endl;
             } else {
@@ -322,6 +341,7 @@ namespace Simulator
             m_scaley = (float)m_height / (float)m_screen->h;
             // std::cerr << "DEBUG: after scale " << m_scalex << " " << m_scaley << std::endl;
             ResetCaption();
+            m_redraw = true;
             Refresh();
         }
 #endif
@@ -329,7 +349,12 @@ namespace Simulator
 
     Display::~Display()
     {
-        m_singleton = NULL;
+        delete m_capture;
+        if (m_singleton == this)
+        {
+            GetKernel()->UnregisterHostHook(*this);
+            m_singleton = NULL;
+        }
 #ifdef USE_SDL
         if (m_enabled)
             SDL_Quit();
@@ -384,7 +409,210 @@ namespace Simulator
             delete os;
     }
 
-    void Display::Refresh() const
+    PixelConverter::PixelConverter()
+        : m_bpp(0), m_indexed(false), m_width(0),
+          m_Rshift(16), m_Gshift(8), m_Bshift(0),
+          m_direct(true), m_unscaled(true)
+    {
+    }
+
+    void PixelConverter::SetFormat(unsigned int bpp, bool indexed, const std::vector<uint32_t>& palette,
+                                   unsigned int Rshift, unsigned int Gshift, unsigned int Bshift)
+    {
+        m_bpp     = bpp;
+        m_indexed = indexed;
+        m_Rshift  = Rshift;
+        m_Gshift  = Gshift;
+        m_Bshift  = Bshift;
+        m_direct  = (Rshift == 16 && Gshift == 8 && Bshift == 0);
+        m_table.clear();
+
+        // The tables hold the same values as the per-pixel conversion
+        // of each format, including its float scaling.
+        if (indexed)
+        {
+            /*** 1 byte per pixel, palette lookup ***/
+            m_table.resize(256);
+            for (unsigned int i = 0; i < 256; ++i)
+            {
+                uint32_t color = palette[i];
+                m_table[i] = (((color & 0xff0000) >> 16) << Rshift)
+                    | (((color & 0x00ff00) >> 8) << Gshift)
+                    | (((color & 0x0000ff)     ) << Bshift);
+            }
+        }
+        else if (bpp == 8)
+        {
+            /*** 1 bytes per pixel, 3-3-2 RGB ***/
+            static const float Rf = 0xff / (float)0xe0;
+            static const float Gf = Rf;
+            static const float Bf = 0xff / (float)0xc0;
+            m_table.resize(256);
+            for (unsigned int color = 0; color < 256; ++color)
+            {
+                m_table[color] =
+                    (((uint32_t)((color & 0xe0) * Rf)) << Rshift)
+                    | (((uint32_t)(((color & 0x1c) << 3) * Gf)) << Gshift)
+                    | (((uint32_t)(((color & 0x03) << 6) * Bf)) << Bshift);
+            }
+        }
+        else if (bpp == 16)
+        {
+            /*** 2 bytes per pixel, 5-6-5 RGB, one table per channel ***/
+            static const float Rf = 0xff / (float)0xf8;
+            static const float Gf = 0xff / (float)0xfc;
+            static const float Bf = Rf;
+            m_table.resize(32 + 64 + 32);
+            for (unsigned int i = 0; i < 32; ++i)
+            {
+                m_table[i]      = ((uint32_t)((i << 3) * Rf)) << Rshift;
+                m_table[96 + i] = ((uint32_t)((i << 3) * Bf)) << Bshift;
+            }
+            for (unsigned int i = 0; i < 64; ++i)
+            {
+                m_table[32 + i] = ((uint32_t)((i << 2) * Gf)) << Gshift;
+            }
+        }
+    }
+
+    void PixelConverter::SetScale(unsigned int width, unsigned int height, unsigned int dest_w, unsigned int dest_h,
+                                  float scalex, float scaley)
+    {
+        m_width = width;
+        m_xmap.resize(dest_w);
+        m_ymap.resize(dest_h);
+
+        m_unscaled = (dest_w == width);
+        for (unsigned int dx = 0; dx < dest_w; ++dx)
+        {
+            m_xmap[dx] = std::min((unsigned int)(dx * scalex), width - 1);
+            m_unscaled = m_unscaled && (m_xmap[dx] == dx);
+        }
+        for (unsigned int dy = 0; dy < dest_h; ++dy)
+        {
+            m_ymap[dy] = std::min((unsigned int)(dy * scaley), height - 1);
+        }
+    }
+
+    // The conversion of one pixel for each format. The row loops are
+    // instantiated for each, without a per-pixel test of the format or
+    // the scaling, so that the compiler can vectorize them.
+    namespace
+    {
+        struct Lookup8
+        {
+            const uint32_t* table;
+            uint32_t operator()(uint8_t c) const { return table[c]; }
+        };
+
+        struct Lookup565
+        {
+            const uint32_t* table;
+            uint32_t operator()(uint16_t c) const { return table[c >> 11] | table[32 + ((c >> 5) & 0x3f)] | table[96 + (c & 0x1f)]; }
+        };
+
+        struct Shift888
+        {
+            unsigned int Rshift, Gshift, Bshift;
+            uint32_t operator()(uint32_t c) const {
+                return (((c & 0xff0000) >> 16) << Rshift)
+                    | (((c & 0x00ff00) >> 8) << Gshift)
+                    | (((c & 0x0000ff)     ) << Bshift);
+            }
+        };
+
+        struct Direct888
+        {
+            uint32_t operator()(uint32_t c) const { return c & 0xffffff; }
+        };
+
+        template <typename T, typename F>
+        void ConvertPixels(uint32_t* dest, const T* src, const std::vector<unsigned int>& xmap, bool unscaled, const F& f)
+        {
+            const size_t n = xmap.size();
+            if (unscaled)
+            {
+                for (size_t i = 0; i < n; ++i)
+                    dest[i] = f(src[i]);
+            }
+            else
+            {
+                const unsigned int* map = &xmap[0];
+                for (size_t i = 0; i < n; ++i)
+                    dest[i] = f(src[map[i]]);
+            }
+        }
+    }
+
+    void PixelConverter::ConvertRow(uint32_t* dest, const uint8_t* framebuffer, unsigned int dy) const
+    {
+        const size_t offset = (size_t)m_ymap[dy] * m_width;
+        switch (m_bpp)
+        {
+        case 8:
+        {
+            Lookup8 f = { &m_table[0] };
+            ConvertPixels(dest, framebuffer + offset, m_xmap, m_unscaled, f);
+            break;
+        }
+        case 16:
+        {
+            Lookup565 f = { &m_table[0] };
+            ConvertPixels(dest, (const uint16_t*)(const void*)framebuffer + offset, m_xmap, m_unscaled, f);
+            break;
+        }
+        case 24:
+        {
+            /*** 3 bytes per pixel, 8-8-8 RGB ***/
+            const uint8_t* src = framebuffer + offset * 3;
+            for (size_t dx = 0; dx < m_xmap.size(); ++dx)
+            {
+                const uint8_t* base = &src[m_xmap[dx] * 3];
+                dest[dx] = (base[0] << m_Rshift)
+                    | (base[1] << m_Gshift)
+                    | (base[2] << m_Bshift);
+            }
+            break;
+        }
+        case 32:
+        {
+            const uint32_t* src = (const uint32_t*)(const void*)framebuffer + offset;
+            if (m_direct)
+            {
+                Direct888 f;
+                ConvertPixels(dest, src, m_xmap, m_unscaled, f);
+            }
+            else
+            {
+                Shift888 f = { m_Rshift, m_Gshift, m_Bshift };
+                ConvertPixels(dest, src, m_xmap, m_unscaled, f);
+            }
+            break;
+        }
+        default:
+            /* no known bpp */
+            break;
+        }
+    }
+
+    void Display::MarkDirty(MemAddr address, MemSize size)
+    {
+        const size_t pitch = m_width * m_bpp / 8;
+        if (pitch == 0 || size == 0)
+            return;
+
+        const size_t last = std::min<size_t>((address + size - 1) / pitch, (size_t)m_height - 1);
+        for (size_t y = address / pitch; y <= last; ++y)
+        {
+            m_dirtyRows[y] = 1;
+            m_dirty = true;
+        }
+
+        if (m_capture != NULL)
+            m_capture->MarkChanged();
+    }
+
+    void Display::Refresh()
     {
 #ifdef USE_SDL
         if (m_screen != NULL)
@@ -394,144 +622,54 @@ namespace Simulator
                 // No source to copy, just clear the surface
                 SDL_FillRect(m_screen, NULL, 0);
             }
-            else 
+            else if (m_redraw || m_dirty)
             {
                 if (SDL_MUSTLOCK(m_screen))
                     if (SDL_LockSurface(m_screen) < 0)
                         return;
                 assert(m_screen->format->BytesPerPixel == 4);
 
-                // Copy the buffer into the video surface
-                unsigned dx, dy;
-                float m_scaley = this->m_scaley, 
-                    m_scalex = this->m_scalex;
-                unsigned m_width = this->m_width;
-                unsigned m_screen_h = m_screen->h, 
-                    m_screen_w = m_screen->w;
-                unsigned m_screen_pitch = m_screen->pitch;
-                char* pixels = (char*)m_screen->pixels;
-                Uint8 Rshift = m_screen->format->Rshift,
-                    Gshift = m_screen->format->Gshift,
-                    Bshift = m_screen->format->Bshift;
-
-                if (m_indexed)
+                if (m_redraw)
                 {
-                    assert(m_bpp == 8);
-                    /*** 1 byte per pixel, palette lookup ***/
-                    const uint8_t *src = &m_framebuffer[0];
-                    for (dy = 0; dy < m_screen_h; ++dy) 
-                    {
-                        Uint32*         dest = (Uint32*)(pixels + dy * m_screen_pitch);
-                        unsigned int    sy   = dy * m_scaley;
-                        for (dx = 0; dx < m_screen_w; ++dx)
-                        {
-                            unsigned int sx  = dx * m_scalex;
-                            Uint32 color = m_palette[src[sy * m_width + sx]];
-                            dest[dx] = (((color & 0xff0000) >> 16) << Rshift) 
-                                | (((color & 0x00ff00) >> 8) << Gshift)
-                                | (((color & 0x0000ff)     ) << Bshift);
-                        }
-                    }                
+                    m_converter.SetFormat(m_bpp, m_indexed, m_palette,
+                                          m_screen->format->Rshift, m_screen->format->Gshift, m_screen->format->Bshift);
+                    m_converter.SetScale(m_width, m_height, m_screen->w, m_screen->h, m_scalex, m_scaley);
                 }
-                else
-                    switch(m_bpp)
-                    {
-                    case 8:
-                    {
-                        /*** 1 bytes per pixel, 3-3-2 RGB ***/
-                        const uint8_t *src = &m_framebuffer[0];
-                        static const float Rf = 0xff / (float)0xe0;
-                        static const float Gf = Rf;
-                        static const float Bf = 0xff / (float)0xc0;
-                        for (dy = 0; dy < m_screen_h; ++dy) 
-                        {
-                            Uint32*         dest = (Uint32*)(pixels + dy * m_screen_pitch);
-                            unsigned int    sy   = dy * m_scaley;
-                        
-                            for (dx = 0; dx < m_screen_w; ++dx)
-                            {
-                                unsigned int sx  = dx * m_scalex;
-                                Uint8 color = src[sy * m_width + sx];
-                                dest[dx] = 
-                                    (((uint32_t)((color & 0xe0) * Rf)) << Rshift) 
-                                    | (((uint32_t)(((color & 0x1c) << 3) * Gf)) << Gshift) 
-                                    | (((uint32_t)(((color & 0x03) << 6) * Bf)) << Bshift);
-                            }
-                        }
-                    }
-                    break;
-                    case 16:
-                    {
-                        /*** 2 bytes per pixel, 5-6-5 RGB ***/
-                        const uint16_t *src = (const uint16_t*)(void*)&m_framebuffer[0];
-                        static const float Rf = 0xff / (float)0xf8;
-                        static const float Gf = 0xff / (float)0xfc;
-                        static const float Bf = Rf;
-                        for (dy = 0; dy < m_screen_h; ++dy) 
-                        {
-                            Uint32*         dest = (Uint32*)(pixels + dy * m_screen_pitch);
-                            unsigned int    sy   = dy * m_scaley;
-                        
-                            for (dx = 0; dx < m_screen_w; ++dx)
-                            {
-                                unsigned int sx  = dx * m_scalex;
-                                Uint16 color = src[sy * m_width + sx];
-                                dest[dx] = 
-                                    (((uint32_t)(((color & 0xf800) >> 8) * Rf)) << Rshift) 
-                                    | (((uint32_t)(((color & 0x07e0) >> 3) * Gf)) << Gshift) 
-                                    | (((uint32_t)(((color & 0x001f) << 3) * Bf)) << Bshift);
-                            }
-                        }
-                    }
-                    break;
-                    case 24:
+
+                // Copy the rows that changed into the video surface, and
+                // collect them in runs of consecutive rows to update.
+                std::vector<SDL_Rect> rects;
+                char* pixels = (char*)m_screen->pixels;
+                for (int dy = 0; dy < m_screen->h; ++dy)
+                {
+                    if (m_redraw || m_dirtyRows[m_converter.GetSourceRow(dy)])
                     {
-                        /*** 3 bytes per pixel, 8-8-8 RGB ***/
-                        const uint8_t *src = (const uint8_t*)(void*)&m_framebuffer[0];
-                        for (dy = 0; dy < m_screen_h; ++dy) 
+                        m_converter.ConvertRow((uint32_t*)(void*)(pixels + dy * m_screen->pitch), &m_framebuffer[0], dy);
+                        ++m_nConvertedRows;
+
+                        if (!rects.empty() && rects.back().y + rects.back().h == dy)
                         {
-                            Uint32*         dest = (Uint32*)(pixels + dy * m_screen_pitch);
-                            unsigned int    sy   = dy * m_scaley;
-                        
-                            for (dx = 0; dx < m_screen_w; ++dx)
-                            {
-                                unsigned int sx  = dx * m_scalex;
-                                const Uint8 * base = &src[sy * m_width * 3 + sx * 3];
-                                dest[dx] = (base[0] << Rshift) 
-                                    | (base[1] << Gshift)
-                                    | (base[2] << Bshift);
-                            }
+                            ++rects.back().h;
                         }
-                    }
-                    break;
-                    case 32:
-                    {
-                        /*** 4 bytes per pixel, 8-8-8 RGB ***/
-                        const uint32_t *src = (const uint32_t*)(void*)&m_framebuffer[0];
-                        for (dy = 0; dy < m_screen_h; ++dy) 
+                        else
                         {
-                            Uint32*         dest = (Uint32*)(pixels + dy * m_screen_pitch);
-                            unsigned int    sy   = dy * m_scaley;
-                        
-                            for (dx = 0; dx < m_screen_w; ++dx)
-                            {
-                                unsigned int sx  = dx * m_scalex;
-                                Uint32 color = src[sy * m_width + sx];
-                                dest[dx] = (((color & 0xff0000) >> 16) << Rshift) 
-                                    | (((color & 0x00ff00) >> 8) << Gshift)
-                                    | (((color & 0x0000ff)     ) << Bshift);
-                            }
+                            SDL_Rect r;
+                            r.x = 0;
+                            r.y = dy;
+                            r.w = m_screen->w;
+                            r.h = 1;
+                            rects.push_back(r);
                         }
                     }
-                    break;
-                    default:
-                        /* no known bpp */
-                        break;
-                    }
+                }
+                std::fill(m_dirtyRows.begin(), m_dirtyRows.end(), 0);
+                m_dirty  = false;
+                m_redraw = false;
 
                 if (SDL_MUSTLOCK(m_screen))
                     SDL_UnlockSurface(m_screen);
-                SDL_Flip(m_screen);
+                if (!rects.empty())
+                    SDL_UpdateRects(m_screen, rects.size(), &rects[0]);
             }
         }
 #endif
@@ -548,6 +686,12 @@ namespace Simulator
 #endif
     }
 
+    void Display::ResetRefreshDelay()
+    {
+        GetKernel()->SetHostHookPeriod(*this, std::max(1U, m_refreshDelay), 0);
+        ResetCaption();
+    }
+
     static unsigned currentDelayScale(unsigned x)
     {
         for (unsigned i = 10000000; i > 0; i /= 10)
@@ -597,15 +741,16 @@ namespace Simulator
                     break;
                 case SDLK_DOWN:
                     m_refreshDelay += currentDelayScale(m_refreshDelay);
-                    ResetCaption();
+                    ResetRefreshDelay();
                     break;
                 case SDLK_UP:
                     if (m_refreshDelay)
                         m_refreshDelay -= currentDelayScale(m_refreshDelay);
-                    ResetCaption();
+                    ResetRefreshDelay();
                     break;
                 case SDLK_r:
                     m_refreshDelay = m_refreshDelay_orig;
+                    ResetRefreshDelay();
                     m_scalex = m_scalex_orig;
                     m_scaley = m_scaley_orig;
                     do_resize = true;
@@ -621,6 +766,10 @@ namespace Simulator
                 }
                 break;
                 
+            case SDL_VIDEOEXPOSE:
+                m_redraw = true;
+                break;
+
             case SDL_VIDEORESIZE:
                 do_resize = true;
                 nw = event.resize.w;
@@ -648,6 +797,10 @@ namespace Simulator
     {
         m_width  = w;
         m_height = h;
+        m_dirtyRows.assign(h, 0);
+        m_redraw = true;
+        if (m_capture != NULL)
+            m_capture->MarkChanged();
 
         if (erase)
             memset(&m_framebuffer[0], 0, w * h * m_bpp / 8);
@@ -8,10 +8,43 @@
 
 struct SDL_Surface;
 
+namespace Simulator
+{
+    class FrameCapture;
+}
+
 
 namespace Simulator
 {
-    class Display : public Object
+    // Conversion of framebuffer rows to 32-bit host pixels. The scaling
+    // and the pixel formats are precomputed into tables when the mode,
+    // the palette or the screen size changes, so that converting a row
+    // is only table lookups.
+    class PixelConverter
+    {
+        unsigned int              m_bpp;
+        bool                      m_indexed;
+        unsigned int              m_width;     ///< Source width in pixels
+        unsigned int              m_Rshift, m_Gshift, m_Bshift;
+        bool                      m_direct;    ///< Destination uses the source 8-8-8 layout
+        bool                      m_unscaled;  ///< One source pixel per destination pixel
+        std::vector<uint32_t>     m_table;     ///< Destination color per 8-bit pixel, or per 5-6-5 channel
+        std::vector<unsigned int> m_xmap;      ///< Source column of each destination column
+        std::vector<unsigned int> m_ymap;      ///< Source row of each destination row
+
+    public:
+        PixelConverter();
+
+        void SetFormat(unsigned int bpp, bool indexed, const std::vector<uint32_t>& palette,
+                       unsigned int Rshift, unsigned int Gshift, unsigned int Bshift);
+        void SetScale(unsigned int width, unsigned int height, unsigned int dest_w, unsigned int dest_h,
+                      float scalex, float scaley);
+
+        unsigned int GetSourceRow(unsigned int dy) const { return m_ymap[dy]; }
+        void ConvertRow(uint32_t* dest, const uint8_t* framebuffer, unsigned int dy) const;
+    };
+
+    class Display : public Object, public IHostHook
     {
         static Display*       m_singleton;
 
@@ -29,6 +62,15 @@ namespace Simulator
 
         bool                  m_enabled;
 
+        // Refresh state
+        PixelConverter        m_converter;
+        std::vector<uint8_t>  m_dirtyRows;       ///< Framebuffer rows written since the last refresh
+        bool                  m_dirty;           ///< Whether any row is dirty
+        bool                  m_redraw;          ///< Whether the whole screen must be redrawn
+        uint64_t              m_nConvertedRows;  ///< Number of screen rows converted
+
+        FrameCapture*         m_capture;         ///< Headless capture of the frames, if enabled
+
         class ControlInterface;
 
         class FrameBufferInterface : public IIOBusClient, public Object
@@ -77,6 +119,7 @@ namespace Simulator
         FrameBufferInterface     m_fbinterface;
         friend class ControlInterface;
         friend class FrameBufferInterface;
+        friend class FrameCapture;
         
     public:
         Display(const std::string& name, Object& parent, IIOBus& iobus, IODeviceID ctldevid, IODeviceID fbdevid, Config& config);
@@ -84,11 +127,10 @@ namespace Simulator
         ~Display();
 
         void CheckEvents(void);
-        void OnCycle(CycleNo cycle)
+
+        // From IHostHook, run every m_refreshDelay master cycles
+        void OnHostHook(CycleNo cycle)
         {
-            if (m_lastUpdate + m_refreshDelay > cycle)
-                return;
-            
             m_lastUpdate = cycle;
             CheckEvents();
         }
@@ -97,10 +139,12 @@ namespace Simulator
 
     protected:
         void Resize(unsigned w, unsigned h, bool erase); 
-        void Refresh() const;
+        void MarkDirty(MemAddr address, MemSize size);
+        void Refresh();
         void ResetCaption() const;
         void ResizeScreen(unsigned int w, unsigned int h);
         void DumpFrameBuffer(unsigned key, int stream, bool gen_timestamp) const;
+        void ResetRefreshDelay();
     };
 
 
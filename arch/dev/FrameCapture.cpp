@@ -0,0 +1,345 @@
+#include "FrameCapture.h"
+#include "Display.h"
+#include "sim/sampling.h"
+
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <csignal>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Simulator
+{
+    FrameCapture::FrameCapture(const std::string& name, Display& parent, Config& config)
+        : Object(name, parent),
+          m_display(parent),
+          m_format(FORMAT_STREAM),
+          m_prefix(config.getValueOrDefault<std::string>(parent, "GfxCapturePrefix", "gfxcapture")),
+          m_maxQueued(config.getValueOrDefault<size_t>(parent, "GfxCaptureQueueSize", 4)),
+          m_wait(config.getValueOrDefault<bool>(parent, "GfxCaptureWait", false)),
+          m_changed(true),
+          m_lastWidth(0),
+          m_nCaptured(0),
+          m_nUnchanged(0),
+          m_nDuplicates(0),
+          m_nDropped(0),
+          m_nWritten(0)
+#ifdef HAVE_PTHREAD
+        , m_shutdown(false),
+          m_nWorkerDuplicates(0),
+          m_nWorkerWritten(0)
+#endif
+    {
+        const std::string mode = config.getValue<std::string>(parent, "GfxCaptureMode");
+        if (mode == "PNG")
+        {
+#ifndef HAVE_ZLIB
+            throw exceptf<InvalidArgumentException>(*this, "GfxCaptureMode PNG requires zlib");
+#endif
+            m_format = FORMAT_PNG;
+        }
+        else if (mode == "STREAM")
+        {
+            const std::string fname = m_prefix + ".ppms";
+            m_stream.open(fname.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!m_stream.good())
+            {
+                throw exceptf<InvalidArgumentException>(*this, "Unable to open %s for writing", fname.c_str());
+            }
+            m_format = FORMAT_STREAM;
+        }
+        else
+        {
+            throw exceptf<InvalidArgumentException>(*this, "Invalid GfxCaptureMode: %s", mode.c_str());
+        }
+
+        const CycleNo delay = config.getValueOrDefault<CycleNo>(parent, "GfxCaptureDelay", 1000000);
+        if (delay == 0)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "GfxCaptureDelay cannot be zero");
+        }
+        if (m_maxQueued == 0)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "GfxCaptureQueueSize cannot be zero");
+        }
+
+        RegisterSampleVariableInObject(m_nCaptured, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nUnchanged, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nDuplicates, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nDropped, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nWritten, SVC_CUMULATIVE);
+
+#ifdef HAVE_PTHREAD
+        pthread_mutex_init(&m_lock, NULL);
+        pthread_cond_init(&m_available, NULL);
+        pthread_cond_init(&m_space, NULL);
+        if (pthread_create(&m_worker, NULL, RunWorker, this) != 0)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "Unable to start the frame capture thread");
+        }
+#endif
+
+        GetKernel()->RegisterHostHook(*this, delay, 0);
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        GetKernel()->UnregisterHostHook(*this);
+
+#ifdef HAVE_PTHREAD
+        // The writer finishes the frames that are still queued
+        pthread_mutex_lock(&m_lock);
+        m_shutdown = true;
+        pthread_cond_signal(&m_available);
+        pthread_mutex_unlock(&m_lock);
+        pthread_join(m_worker, NULL);
+        UpdateStatistics();
+
+        pthread_cond_destroy(&m_space);
+        pthread_cond_destroy(&m_available);
+        pthread_mutex_destroy(&m_lock);
+#endif
+    }
+
+#ifdef HAVE_PTHREAD
+    // Copies the counts of the writer into the statistics; called with m_lock held
+    void FrameCapture::UpdateStatistics()
+    {
+        m_nDuplicates = m_nWorkerDuplicates;
+        m_nWritten    = m_nWorkerWritten;
+    }
+#endif
+
+    void FrameCapture::OnHostHook(CycleNo cycle)
+    {
+        if (!m_changed)
+        {
+#ifdef HAVE_PTHREAD
+            pthread_mutex_lock(&m_lock);
+            UpdateStatistics();
+            pthread_mutex_unlock(&m_lock);
+#endif
+            ++m_nUnchanged;
+            return;
+        }
+
+        const Display& disp = m_display;
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock(&m_lock);
+        while (m_wait && m_queue.size() >= m_maxQueued)
+        {
+            pthread_cond_wait(&m_space, &m_lock);
+        }
+        const size_t queued = m_queue.size();
+        UpdateStatistics();
+        pthread_mutex_unlock(&m_lock);
+        if (queued >= m_maxQueued)
+        {
+            // Do not hold up the simulation; the next frame will be
+            // taken as the framebuffer is still marked as changed.
+            ++m_nDropped;
+            return;
+        }
+#endif
+
+        Frame* frame   = new Frame;
+        frame->cycle   = cycle;
+        frame->width   = disp.m_width;
+        frame->height  = disp.m_height;
+        frame->bpp     = disp.m_bpp;
+        frame->indexed = disp.m_indexed;
+        if (disp.m_indexed)
+        {
+            frame->palette = disp.m_palette;
+        }
+        frame->data.assign(disp.m_framebuffer.begin(), disp.m_framebuffer.begin() + disp.m_width * disp.m_height * disp.m_bpp / 8);
+        m_changed = false;
+        ++m_nCaptured;
+
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock(&m_lock);
+        m_queue.push_back(frame);
+        pthread_cond_signal(&m_available);
+        pthread_mutex_unlock(&m_lock);
+#else
+        if (WriteFrame(*frame))
+        {
+            ++m_nWritten;
+        }
+        else
+        {
+            ++m_nDuplicates;
+        }
+        delete frame;
+#endif
+    }
+
+#ifdef HAVE_PTHREAD
+    void* FrameCapture::RunWorker(void* arg)
+    {
+        // Leave the handling of signals to the simulation thread
+        sigset_t sigset;
+        sigfillset(&sigset);
+        pthread_sigmask(SIG_BLOCK, &sigset, 0);
+
+        static_cast<FrameCapture*>(arg)->WriteFrames();
+        return NULL;
+    }
+
+    void FrameCapture::WriteFrames()
+    {
+        for (;;)
+        {
+            pthread_mutex_lock(&m_lock);
+            while (m_queue.empty() && !m_shutdown)
+            {
+                pthread_cond_wait(&m_available, &m_lock);
+            }
+            if (m_queue.empty())
+            {
+                pthread_mutex_unlock(&m_lock);
+                return;
+            }
+            Frame* frame = m_queue.front();
+            pthread_mutex_unlock(&m_lock);
+
+            const bool written = WriteFrame(*frame);
+
+            // The frame stays in the queue while it is written, so
+            // that it counts against GfxCaptureQueueSize.
+            pthread_mutex_lock(&m_lock);
+            m_queue.pop_front();
+            if (written)
+            {
+                ++m_nWorkerWritten;
+            }
+            else
+            {
+                ++m_nWorkerDuplicates;
+            }
+            pthread_cond_signal(&m_space);
+            pthread_mutex_unlock(&m_lock);
+            delete frame;
+        }
+    }
+#endif
+
+    // Returns false if the frame was not written as it is identical to the previous one
+    bool FrameCapture::WriteFrame(const Frame& frame)
+    {
+        // Convert to 8-8-8 RGB with the same conversion as the screen
+        PixelConverter conv;
+        conv.SetFormat(frame.bpp, frame.indexed, frame.palette, 16, 8, 0);
+        conv.SetScale(frame.width, frame.height, frame.width, frame.height, 1.0f, 1.0f);
+
+        std::vector<uint32_t> row(frame.width);
+        std::vector<uint8_t>  rgb((size_t)frame.width * frame.height * 3);
+        for (unsigned int y = 0; y < frame.height; ++y)
+        {
+            conv.ConvertRow(&row[0], &frame.data[0], y);
+            uint8_t* dest = &rgb[(size_t)y * frame.width * 3];
+            for (unsigned int x = 0; x < frame.width; ++x)
+            {
+                const uint32_t c = row[x];
+                dest[x * 3 + 0] = (c >> 16) & 0xff;
+                dest[x * 3 + 1] = (c >>  8) & 0xff;
+                dest[x * 3 + 2] = (c      ) & 0xff;
+            }
+        }
+
+        // A program that redraws the same image produces no new frame
+        if (frame.width == m_lastWidth && rgb == m_lastFrame)
+        {
+            return false;
+        }
+
+        if (m_format == FORMAT_PNG)
+        {
+            WritePNG(frame, rgb);
+        }
+        else
+        {
+            WriteStream(frame, rgb);
+        }
+
+        m_lastWidth = frame.width;
+        m_lastFrame.swap(rgb);
+        return true;
+    }
+
+    void FrameCapture::WriteStream(const Frame& frame, const std::vector<uint8_t>& rgb)
+    {
+        // Binary PPM images can simply be concatenated; most tools
+        // that read images from a pipe accept this as a video stream.
+        m_stream << "P6" << '\n'
+                 << "# cycle: " << frame.cycle << '\n'
+                 << frame.width << ' ' << frame.height << '\n'
+                 << 255 << '\n';
+        m_stream.write((const char*)&rgb[0], rgb.size());
+        m_stream.flush();
+    }
+
+#ifdef HAVE_ZLIB
+    static void WritePNGChunk(std::ostream& os, const char* type, const uint8_t* data, size_t size)
+    {
+        const uint8_t header[8] = {
+            (uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size,
+            (uint8_t)type[0], (uint8_t)type[1], (uint8_t)type[2], (uint8_t)type[3]
+        };
+        uLong crc = crc32(0, (const Bytef*)type, 4);
+        if (size > 0)
+        {
+            crc = crc32(crc, (const Bytef*)data, size);
+        }
+        const uint8_t trailer[4] = { (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc };
+
+        os.write((const char*)header, sizeof header);
+        os.write((const char*)data, size);
+        os.write((const char*)trailer, sizeof trailer);
+    }
+#endif
+
+    void FrameCapture::WritePNG(const Frame& frame, const std::vector<uint8_t>& rgb)
+    {
+#ifdef HAVE_ZLIB
+        // Every row starts with its filter type; we use none
+        const size_t pitch = (size_t)frame.width * 3;
+        std::vector<uint8_t> raw((pitch + 1) * frame.height);
+        for (unsigned int y = 0; y < frame.height; ++y)
+        {
+            raw[y * (pitch + 1)] = 0;
+            memcpy(&raw[y * (pitch + 1) + 1], &rgb[y * pitch], pitch);
+        }
+
+        uLongf size = compressBound(raw.size());
+        std::vector<uint8_t> compressed(size);
+        if (compress2(&compressed[0], &size, &raw[0], raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            std::cerr << GetFQN() << ": unable to compress frame at cycle " << frame.cycle << std::endl;
+            return;
+        }
+
+        std::ostringstream fname;
+        fname << m_prefix << '.' << frame.cycle << ".png";
+        std::ofstream os(fname.str().c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        const uint8_t ihdr[13] = {
+            (uint8_t)(frame.width >> 24),  (uint8_t)(frame.width >> 16),  (uint8_t)(frame.width >> 8),  (uint8_t)frame.width,
+            (uint8_t)(frame.height >> 24), (uint8_t)(frame.height >> 16), (uint8_t)(frame.height >> 8), (uint8_t)frame.height,
+            8,  // bit depth
+            2,  // color type: RGB
+            0, 0, 0 // compression, filter, interlace
+        };
+        os.write((const char*)signature, sizeof signature);
+        WritePNGChunk(os, "IHDR", ihdr, sizeof ihdr);
+        WritePNGChunk(os, "IDAT", &compressed[0], size);
+        WritePNGChunk(os, "IEND", NULL, 0);
+#else
+        (void)frame; (void)rgb;
+#endif
+    }
+}
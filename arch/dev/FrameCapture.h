@@ -0,0 +1,97 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include "sim/kernel.h"
+#include "sim/config.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <fstream>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+namespace Simulator
+{
+    class Display;
+
+    // Headless capture of the frames of a display, for hosts without a
+    // screen. A frame is taken every GfxCaptureDelay master cycles if the
+    // framebuffer was written since the previous one. The simulation only
+    // copies the framebuffer; the frames are converted, compared and
+    // written by a host thread. When GfxCaptureQueueSize frames are
+    // waiting, further frames are dropped unless GfxCaptureWait is set,
+    // so by default the frames captured depend on the speed of the host.
+    class FrameCapture : public Object, public IHostHook
+    {
+        struct Frame
+        {
+            CycleNo               cycle;
+            unsigned int          width, height, bpp;
+            bool                  indexed;
+            std::vector<uint32_t> palette;
+            std::vector<uint8_t>  data;
+        };
+
+        enum Format
+        {
+            FORMAT_PNG,     ///< One PNG file per frame
+            FORMAT_STREAM,  ///< One file of concatenated binary PPM frames
+        };
+
+        Display&            m_display;
+        Format              m_format;
+        std::string         m_prefix;
+        std::ofstream       m_stream;     ///< Output file in FORMAT_STREAM
+        size_t              m_maxQueued;  ///< Maximum number of frames waiting to be written
+        bool                m_wait;       ///< Wait for the writer instead of dropping frames?
+        bool                m_changed;    ///< Was the framebuffer written since the last frame?
+
+        // Only used by the writer
+        std::vector<uint8_t> m_lastFrame; ///< RGB pixels of the last frame written
+        unsigned int        m_lastWidth;
+
+        // Statistics
+        uint64_t            m_nCaptured;   ///< Frames copied from the framebuffer
+        uint64_t            m_nUnchanged;  ///< Frames skipped as the framebuffer was not written
+        uint64_t            m_nDuplicates; ///< Frames skipped as identical to the previous one
+        uint64_t            m_nDropped;    ///< Frames skipped as the writer was too far behind
+        uint64_t            m_nWritten;    ///< Frames written
+
+#ifdef HAVE_PTHREAD
+        pthread_t           m_worker;
+        pthread_mutex_t     m_lock;
+        pthread_cond_t      m_available;  ///< Signalled when a frame is queued
+        pthread_cond_t      m_space;      ///< Signalled when a frame is written
+        std::deque<Frame*>  m_queue;
+        bool                m_shutdown;
+
+        // Counts of the writer, protected by m_lock. The simulation
+        // copies them into the statistics when it takes a frame.
+        uint64_t            m_nWorkerDuplicates;
+        uint64_t            m_nWorkerWritten;
+
+        static void* RunWorker(void* arg);
+        void WriteFrames();
+        void UpdateStatistics();
+#endif
+
+        bool WriteFrame(const Frame& frame);
+        void WritePNG(const Frame& frame, const std::vector<uint8_t>& rgb);
+        void WriteStream(const Frame& frame, const std::vector<uint8_t>& rgb);
+
+    public:
+        FrameCapture(const std::string& name, Display& parent, Config& config);
+        ~FrameCapture();
+
+        // Called by the display when the image may have changed
+        void MarkChanged() { m_changed = true; }
+
+        // From IHostHook: take a frame
+        void OnHostHook(CycleNo cycle);
+    };
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "RPC.h"
 #include "config.h"
+#include <sched.h>
+#include <signal.h>
 
 /*
 
@@ -55,6 +57,21 @@ The following processes run concurrently (pipeline):
 - notifications:  issues completion notification for the frontmost
   notification entry. Then pop the entry.
 
+In asynchronous mode (RPCAsyncLatency > 0), the processing step does not
+call the service provider itself. Instead:
+
+- processing: hands the request to a host worker thread and queues it to
+  the pending queue, due RPCAsyncLatency cycles later.
+
+- completion: when the frontmost pending request is due, collects its
+  result from the worker's completion queue and queues it to the
+  completed queue. If the host has not finished yet, the simulation
+  waits for it, so that the simulated timing only depends on the
+  configured latency and never on the host.
+
+The worker services requests in the order they were issued, so the
+host observes the same sequence of system calls as in synchronous mode.
+
   - read request handler:
     informs the latches for all parameters except command type
     informs the current size of the queues for monitoring
@@ -88,6 +105,13 @@ The following processes run concurrently (pipeline):
 namespace Simulator
 {
 
+#ifdef HAVE_PTHREAD
+    // All RPC devices share the same service provider, which is not
+    // reentrant; serialize the calls from the host workers and the
+    // simulation.
+    static pthread_mutex_t g_serviceLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
     RPCInterface::RPCInterface(const std::string& name, Object& parent, IIOBus& iobus, IODeviceID devid, Config& config, IRPCServiceProvider& provider)
         : Object(name, parent, iobus.GetClock()),
           m_iobus(iobus),
@@ -116,9 +140,21 @@ namespace Simulator
 
           m_provider(provider),
 
+          m_asyncLatency (config.getValueOrDefault<CycleNo>(*this, "RPCAsyncLatency", 0)),
+          m_pending      ("b_pending",       *this, iobus.GetClock(), config.getValueOrDefault<BufferSize>(*this, "RPCMaxOutstanding", 4)),
+#ifdef HAVE_PTHREAD
+          m_shutdown(false),
+          m_doneRing(m_pending.GetMaxSize() + 1, NULL),
+          m_doneHead(0),
+          m_doneTail(0),
+#endif
+          m_nasync(0),
+          m_nhoststalls(0),
+
           p_queue                      (*this, "queue-request",                 delegate::create<RPCInterface, &RPCInterface::DoQueue>(*this)),
           p_argumentFetch              (*this, "fetch-argument-data",           delegate::create<RPCInterface, &RPCInterface::DoArgumentFetch>(*this)),
           p_processRequests            (*this, "process-requests",              delegate::create<RPCInterface, &RPCInterface::DoProcessRequests>(*this)),
+          p_completeRequests           (*this, "complete-requests",             delegate::create<RPCInterface, &RPCInterface::DoCompleteRequests>(*this)),
           p_writeResponse              (*this, "write-response",                delegate::create<RPCInterface, &RPCInterface::DoWriteResponse>(*this)),
           p_sendCompletionNotifications(*this, "send-completion-notifications", delegate::create<RPCInterface, &RPCInterface::DoSendCompletionNotifications>(*this))
     {
@@ -129,14 +165,172 @@ namespace Simulator
         m_ready.Sensitive(p_processRequests);
         m_completed.Sensitive(p_writeResponse);
         m_notifications.Sensitive(p_sendCompletionNotifications);
+        m_pending.Sensitive(p_completeRequests);
 
         if (m_lineSize == 0)
         {
             throw exceptf<InvalidArgumentException>(*this, "RPCLineSize cannot be zero");
-        }        
-        
+        }
+        if (m_lineSize > MAX_IO_OPERATION_SIZE)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "RPCLineSize cannot be larger than %u", (unsigned)MAX_IO_OPERATION_SIZE);
+        }
+
+        RegisterSampleVariableInObject(m_nasync, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nhoststalls, SVC_CUMULATIVE);
+
+        if (m_asyncLatency > 0)
+        {
+#ifdef HAVE_PTHREAD
+            if (m_pending.GetMaxSize() == 0)
+            {
+                throw exceptf<InvalidArgumentException>(*this, "RPCMaxOutstanding cannot be zero");
+            }
+            pthread_mutex_init(&m_jobLock, NULL);
+            pthread_cond_init(&m_jobAvailable, NULL);
+            if (pthread_create(&m_worker, NULL, RunWorker, this) != 0)
+            {
+                throw exceptf<InvalidArgumentException>(*this, "Unable to start the host worker thread");
+            }
+#else
+            throw exceptf<InvalidArgumentException>(*this, "RPCAsyncLatency requires support for POSIX threads");
+#endif
+        }
+    }
+
+    RPCInterface::~RPCInterface()
+    {
+#ifdef HAVE_PTHREAD
+        if (m_asyncLatency > 0)
+        {
+            pthread_mutex_lock(&m_jobLock);
+            m_shutdown = true;
+            pthread_cond_signal(&m_jobAvailable);
+            pthread_mutex_unlock(&m_jobLock);
+            pthread_join(m_worker, NULL);
+
+            pthread_cond_destroy(&m_jobAvailable);
+            pthread_mutex_destroy(&m_jobLock);
+
+            // Release the requests that were still in flight
+            for (Buffer<PendingRequest>::const_iterator p = m_pending.begin(); p != m_pending.end(); ++p)
+            {
+                delete p->job;
+            }
+        }
+#endif
     }
 
+    void RPCInterface::ServiceRequest(const ProcessRequest& req, ProcessResponse& res)
+    {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock(&g_serviceLock);
+#endif
+        try
+        {
+            m_provider.Service(req.procedure_id, 
+                               res.data1, m_maxRes1Size,
+                               res.data2, m_maxRes2Size,
+                               req.data1, 
+                               req.data2, 
+                               req.extra_arg1,
+                               req.extra_arg2);
+        }
+        catch (...)
+        {
+#ifdef HAVE_PTHREAD
+            pthread_mutex_unlock(&g_serviceLock);
+#endif
+            throw;
+        }
+#ifdef HAVE_PTHREAD
+        pthread_mutex_unlock(&g_serviceLock);
+#endif
+    }
+
+#ifdef HAVE_PTHREAD
+    void* RPCInterface::RunWorker(void* arg)
+    {
+        // Leave the handling of signals to the simulation thread
+        sigset_t sigset;
+        sigfillset(&sigset);
+        pthread_sigmask(SIG_BLOCK, &sigset, 0);
+
+        static_cast<RPCInterface*>(arg)->ServiceJobs();
+        return NULL;
+    }
+
+    void RPCInterface::ServiceJobs()
+    {
+        for (;;)
+        {
+            pthread_mutex_lock(&m_jobLock);
+            while (m_jobs.empty() && !m_shutdown)
+            {
+                pthread_cond_wait(&m_jobAvailable, &m_jobLock);
+            }
+            if (m_shutdown)
+            {
+                pthread_mutex_unlock(&m_jobLock);
+                return;
+            }
+            HostJob* job = m_jobs.front();
+            m_jobs.pop_front();
+            pthread_mutex_unlock(&m_jobLock);
+
+            try
+            {
+                ServiceRequest(job->request, job->response);
+            }
+            catch (const std::exception& e)
+            {
+                job->failed = true;
+                job->error  = e.what();
+            }
+
+            // Publish the completion. The ring has room for every
+            // request that can be in flight, so it cannot overflow.
+            size_t tail = m_doneTail;
+            m_doneRing[tail] = job;
+            __sync_synchronize();
+            m_doneTail = (tail + 1) % m_doneRing.size();
+        }
+    }
+
+    void RPCInterface::SubmitJob(HostJob* job)
+    {
+        pthread_mutex_lock(&m_jobLock);
+        m_jobs.push_back(job);
+        pthread_cond_signal(&m_jobAvailable);
+        pthread_mutex_unlock(&m_jobLock);
+    }
+
+    void RPCInterface::WaitForJob(HostJob* job)
+    {
+        // Drain the completion queue until the job has been seen
+        bool stalled = false;
+        while (!job->done)
+        {
+            size_t head = m_doneHead;
+            if (head == m_doneTail)
+            {
+                // The host is slower than the simulated latency
+                stalled = true;
+                sched_yield();
+                continue;
+            }
+            __sync_synchronize();
+            m_doneRing[head]->done = true;
+            m_doneHead = (head + 1) % m_doneRing.size();
+        }
+
+        if (stalled)
+        {
+            ++m_nhoststalls;
+        }
+    }
+#endif
+
     Result RPCInterface::DoQueue()
     {
         if (!m_incoming.Push(m_inputLatch))
@@ -261,6 +455,44 @@ namespace Simulator
 
         ProcessResponse res;
 
+#ifdef HAVE_PTHREAD
+        if (m_asyncLatency > 0)
+        {
+            // Hand the request to the host worker
+            PendingRequest pending;
+            pending.job = NULL;
+            pending.due = GetCycleNo() + m_asyncLatency;
+
+            COMMIT {
+                pending.job = new HostJob;
+                pending.job->request = req;
+                pending.job->failed  = false;
+                pending.job->done    = false;
+
+                ProcessResponse& res = pending.job->response;
+                res.dca_device_id = req.dca_device_id;
+                res.res1_base_address = req.res1_base_address;
+                res.res2_base_address = req.res2_base_address;
+                res.notification_channel_id = req.notification_channel_id;
+                res.completion_tag = req.completion_tag;
+            }
+
+            if (!m_pending.Push(pending))
+            {
+                COMMIT { delete pending.job; }
+                DeadlockWrite("Unable to push request to the pending queue");
+                return FAILED;
+            }
+
+            COMMIT {
+                SubmitJob(pending.job);
+                ++m_nasync;
+            }
+            m_ready.Pop();
+            return SUCCESS;
+        }
+#endif
+
         COMMIT {
             res.dca_device_id = req.dca_device_id;
             res.res1_base_address = req.res1_base_address;
@@ -268,13 +500,7 @@ namespace Simulator
             res.notification_channel_id = req.notification_channel_id;
             res.completion_tag = req.completion_tag;
             
-            m_provider.Service(req.procedure_id, 
-                               res.data1, m_maxRes1Size,
-                               res.data2, m_maxRes2Size,
-                               req.data1, 
-                               req.data2, 
-                               req.extra_arg1,
-                               req.extra_arg2);
+            ServiceRequest(req, res);
         }
 
         if (!m_completed.Push(res))
@@ -286,6 +512,41 @@ namespace Simulator
         return SUCCESS;
     }
 
+    Result RPCInterface::DoCompleteRequests()
+    {
+        assert(!m_pending.Empty());
+
+        const PendingRequest& pending = m_pending.Front();
+        if (GetCycleNo() < pending.due)
+        {
+            // The request is still in flight
+            return SUCCESS;
+        }
+
+#ifdef HAVE_PTHREAD
+        COMMIT {
+            // The result becomes visible now, however long the host took
+            WaitForJob(pending.job);
+            if (pending.job->failed)
+            {
+                throw SimulationException(pending.job->error, *this);
+            }
+        }
+#endif
+
+        // The data is only copied into the queue during commit,
+        // after the job has completed.
+        if (!m_completed.Push(pending.job->response))
+        {
+            DeadlockWrite("Unable to push request completion");
+            return FAILED;
+        }
+
+        COMMIT { delete pending.job; }
+        m_pending.Pop();
+        return SUCCESS;
+    }
+
     Result RPCInterface::DoWriteResponse()
     {
         assert(!m_completed.Empty());
@@ -4,6 +4,10 @@
 #include "kernel.h"
 #include "storage.h"
 #include "IOBus.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include <deque>
 
 namespace Simulator 
 {
@@ -70,6 +74,22 @@ namespace Simulator
             Integer                 completion_tag;
         };
 
+        // A request being serviced by the host worker in asynchronous mode
+        struct HostJob
+        {
+            ProcessRequest          request;
+            ProcessResponse         response;
+            bool                    failed;   ///< Service() threw an exception
+            std::string             error;    ///< The exception message, if failed
+            bool                    done;     ///< Seen on the completion queue (simulation side only)
+        };
+
+        struct PendingRequest
+        {
+            HostJob*                job;      ///< The host side of the request
+            CycleNo                 due;      ///< Cycle at which the result becomes visible
+        };
+
         enum ArgumentFetchState
         {
             ARGFETCH_READING1,
@@ -114,9 +134,42 @@ namespace Simulator
 
         IRPCServiceProvider&    m_provider;
 
+        // Asynchronous mode: requests are serviced by a host thread and
+        // complete a fixed number of cycles after they were issued,
+        // regardless of how long the host operation took.
+        CycleNo                 m_asyncLatency;     ///< Simulated latency; 0 for synchronous mode
+        Buffer<PendingRequest>  m_pending;          ///< Requests in flight, in issue order
+
+#ifdef HAVE_PTHREAD
+        // Host worker; jobs are serviced in submission order
+        pthread_t               m_worker;
+        pthread_mutex_t         m_jobLock;
+        pthread_cond_t          m_jobAvailable;
+        std::deque<HostJob*>    m_jobs;             ///< Submitted jobs (under m_jobLock)
+        bool                    m_shutdown;         ///< Worker should exit (under m_jobLock)
+
+        // Lock-free single-producer (worker), single-consumer
+        // (simulation) queue of completed jobs
+        std::vector<HostJob*>   m_doneRing;
+        volatile size_t         m_doneHead;         ///< Next slot to read; written by the simulation
+        volatile size_t         m_doneTail;         ///< Next slot to write; written by the worker
+
+        static void* RunWorker(void* arg);
+        void ServiceJobs();
+        void SubmitJob(HostJob* job);
+        void WaitForJob(HostJob* job);
+#endif
+
+        // Statistics
+        uint64_t                m_nasync;           ///< Requests serviced asynchronously
+        uint64_t                m_nhoststalls;      ///< Completions that had to wait for the host
+
+        void ServiceRequest(const ProcessRequest& req, ProcessResponse& res);
+
     public:
 
         RPCInterface(const std::string& name, Object& parent, IIOBus& iobus, IODeviceID devid, Config& config, IRPCServiceProvider& provider);
+        ~RPCInterface();
 
         Process p_queue;
         Result  DoQueue();
@@ -127,6 +180,9 @@ namespace Simulator
         Process p_processRequests;
         Result  DoProcessRequests();       
 
+        Process p_completeRequests;
+        Result  DoCompleteRequests();
+
         Process p_writeResponse;
         Result  DoWriteResponse();
         
@@ -1,11 +1,20 @@
 #include "Selector.h"
+#include "sim/config.h"
 #include "sim/except.h"
 #include <map>
+#include <vector>
 #include <iomanip>
 #include <cstring>
 #include <cerrno>
 #include <ev++.h>
 #include <fcntl.h>
+#include <sys/time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <csignal>
+#include <sched.h>
+#endif
 
 using namespace std;
 
@@ -23,24 +32,162 @@ namespace Simulator
         static
         bool current_result = true;
 
+        // Readiness of each stream found by the last check.
         static
-        size_t handler_count;
+        map<int, int> ready;
 
-        
         void selector_delegate_callback(ev::io& io, int revents)
         {
             // cerr << "I/O ready on fd " << fd << ", mode " << mode << endl;
-            ISelectorClient* client = (ISelectorClient*)io.data;
-            
             int st = 0;
             if (revents & ev::READ) st |= Selector::READABLE;
             if (revents & ev::WRITE) st |= Selector::WRITABLE;
             if (st != 0)
             {
-                current_result &= client->OnStreamReady(io.fd, (Selector::StreamState)st);
-                ++handler_count;
+                ready[io.fd] |= st;
+            }
+        }
+
+#ifdef HAVE_PTHREAD
+        //
+        // Event mode. The host thread has its own event loop, which
+        // waits for the readiness that the simulation asked for. A
+        // watcher is stopped when it fires; the simulation arms it again
+        // when it still needs that readiness. This way the thread never
+        // posts the same event twice and the rings cannot fill up with
+        // a stream that stays ready.
+        //
+        struct Readiness
+        {
+            int fd;
+            int state;   ///< Selector::StreamState bits, or 0 to forget the stream
+        };
+
+        // Lock-free single-producer, single-consumer ring
+        class Ring
+        {
+            std::vector<Readiness> m_slots;
+            volatile size_t        m_head;  ///< Next slot to read; written by the consumer
+            volatile size_t        m_tail;  ///< Next slot to write; written by the producer
+        public:
+            bool Empty() const { return m_head == m_tail; }
+
+            bool Push(const Readiness& r)
+            {
+                const size_t tail = m_tail, next = (tail + 1) % m_slots.size();
+                if (next == m_head)
+                    return false;
+                m_slots[tail] = r;
+                __sync_synchronize();
+                m_tail = next;
+                return true;
             }
+
+            bool Pop(Readiness& r)
+            {
+                const size_t head = m_head;
+                if (head == m_tail)
+                    return false;
+                __sync_synchronize();
+                r = m_slots[head];
+                __sync_synchronize();
+                m_head = (head + 1) % m_slots.size();
+                return true;
+            }
+
+            Ring(size_t size) : m_slots(size + 1), m_head(0), m_tail(0) {}
+        };
+
+        static const size_t RING_SIZE = 1024;
+
+        static Ring*            posted   = NULL;  ///< Readiness found by the thread
+        static Ring*            requests = NULL;  ///< Readiness wanted by the simulation
+        static map<int, int>    armed;            ///< Readiness requested and not yet posted, per stream
+
+        // Owned by the host thread
+        static struct ev_loop*  hostloop = NULL;
+        static ev::async*       wakeup   = NULL;
+        static map<int, ev::io*> watchers;
+        static volatile bool    shutdown = false;
+
+        static pthread_t        thread;
+        static pthread_mutex_t  idle_lock;
+        static pthread_cond_t   idle_available;
+
+        void host_io_callback(ev::io& io, int revents)
+        {
+            Readiness r;
+            r.fd    = io.fd;
+            r.state = 0;
+            if (revents & ev::READ)  r.state |= Selector::READABLE;
+            if (revents & ev::WRITE) r.state |= Selector::WRITABLE;
+            io.stop();
+
+            // The simulation drains the ring at every check, so this
+            // only waits if it is stuck in a long cycle.
+            while (!posted->Push(r))
+            {
+                sched_yield();
+            }
+
+            // Wake up the simulation if it waits for us
+            pthread_mutex_lock(&idle_lock);
+            pthread_cond_signal(&idle_available);
+            pthread_mutex_unlock(&idle_lock);
+        }
+
+        void host_wakeup_callback(ev::async& /*w*/, int /*revents*/)
+        {
+            Readiness r;
+            while (requests->Pop(r))
+            {
+                ev::io* &io = watchers[r.fd];
+                if (r.state == 0)
+                {
+                    delete io;
+                    watchers.erase(r.fd);
+                    continue;
+                }
+
+                int events = 0;
+                if (io == NULL)
+                {
+                    io = new ev::io(hostloop);
+                    io->set<host_io_callback>(NULL);
+                }
+                else if (io->is_active())
+                {
+                    events = io->events;
+                    io->stop();
+                }
+                if (r.state & Selector::READABLE) events |= ev::READ;
+                if (r.state & Selector::WRITABLE) events |= ev::WRITE;
+                io->start(r.fd, events);
+            }
+
+            if (shutdown)
+            {
+                for (map<int, ev::io*>::const_iterator i = watchers.begin(); i != watchers.end(); ++i)
+                {
+                    delete i->second;
+                }
+                watchers.clear();
+                wakeup->stop();
+                ev_unloop(hostloop, EVUNLOOP_ALL);
+            }
+        }
+
+        void* host_thread(void*)
+        {
+            // Leave the handling of signals to the simulation thread
+            sigset_t sigset;
+            sigfillset(&sigset);
+            pthread_sigmask(SIG_BLOCK, &sigset, 0);
+
+            ev_loop(hostloop, 0);
+            return NULL;
         }
+#endif
     }
 
     static map<int, int> fd_flags;
@@ -62,6 +209,13 @@ namespace Simulator
                 cerr << "Unable to set non-blocking flags for " << fd << ": " << strerror(errno) << endl;
             }
         }
+
+        // Disable forgot the readiness; look at the streams again
+        if (m_mode == MODE_HOSTPOLL)
+        {
+            Poll();
+        }
+        m_nextPoll = 0;
     }
 
     void Selector::Disable()
@@ -77,6 +231,15 @@ namespace Simulator
                 cerr << "Unable to reset non-blocking flags for " << fd << ": " << strerror(errno) << endl;
             }
         }
+
+        for (map<int,ev::io*>::const_iterator i = Event::handlers.begin(); i != Event::handlers.end(); ++i)
+        {
+            ((ISelectorClient*)i->second->data)->OnSelectorDisabled();
+        }
+
+        // The streams may change while the simulation is stopped
+        Event::ready.clear();
+        m_active = false;
     }
 
     Selector& Selector::GetSelector()
@@ -100,8 +263,16 @@ namespace Simulator
         ev->set<Event::selector_delegate_callback>(&callback);
         ev->start(fd, EV_READ|EV_WRITE);
         
-        if (!m_doCheckStreams.IsSet())
+        // In event mode, the next check arms the stream for the host thread
+        if (m_mode != MODE_EVENT && !m_doCheckStreams.IsSet())
             m_doCheckStreams.Set();
+
+        // Find the readiness of the new stream at the next check
+        if (m_mode == MODE_HOSTPOLL)
+        {
+            Poll();
+        }
+        m_nextPoll = 0;
         return true;
     }
 
@@ -116,8 +287,26 @@ namespace Simulator
         // the following stops the event handler automatically
         delete i->second;
         Event::handlers.erase(i);
+        Event::ready.erase(fd);
 
-        if (Event::handlers.empty())
+#ifdef HAVE_PTHREAD
+        if (m_mode == MODE_EVENT)
+        {
+            // Tell the host thread to forget the stream
+            Event::Readiness r;
+            r.fd    = fd;
+            r.state = 0;
+            while (!Event::requests->Push(r))
+            {
+                Event::wakeup->send();
+                sched_yield();
+            }
+            Event::wakeup->send();
+            Event::armed.erase(fd);
+        }
+#endif
+
+        if (m_mode != MODE_EVENT && Event::handlers.empty())
             m_doCheckStreams.Clear();
 
         return true;
@@ -140,17 +329,47 @@ namespace Simulator
         
         // cerr << GetClock().GetCycleNo() << ": Checking for I/O stream availability" << endl;
 
+        if (m_mode == MODE_EVENT && !m_active)
+        {
+            // No stream is ready that a client needs; the next check
+            // that finds one activates us again.
+            COMMIT { m_doCheckStreams.Clear(); }
+            return SUCCESS;
+        }
+
+        if (m_mode == MODE_POLL)
+        {
+            // The streams are checked at fixed cycles, so that the timing
+            // of the simulation does not depend on the speed of the host
+            if (GetCycleNo() < m_nextPoll)
+            {
+                return SUCCESS;
+            }
+            COMMIT {
+                Poll();
+                m_nextPoll = GetCycleNo() + m_pollCycles;
+            }
+        }
+
         COMMIT { 
-            // in principle we should be able to run event_base_loop once per
-            // kernel phase, and only actually do the I/O on the commit phase.
-            // Unfortunately, libev/kqueue only reports writability once
-            // in a while, so we end up losing opportunities to send/write by calling
-            // the loop too often.
+            // In the host modes, the host is only checked for readiness by
+            // OnHostHook. The readiness it found stays until the next check:
+            // the handlers do non-blocking I/O, so a stream that stopped being
+            // ready only causes a spurious event.
+            // We copy it because the handlers can unregister streams.
             Event::current_result = true;
-            Event::handler_count = 0;
-            ev_loop(Event::evbase, EVLOOP_NONBLOCK); 
+            const vector<pair<int, int> > ready(Event::ready.begin(), Event::ready.end());
+            for (vector<pair<int, int> >::const_iterator i = ready.begin(); i != ready.end(); ++i)
+            {
+                map<int, ev::io*>::const_iterator h = Event::handlers.find(i->first);
+                if (h != Event::handlers.end())
+                {
+                    ISelectorClient* client = (ISelectorClient*)h->second->data;
+                    Event::current_result &= client->OnStreamReady(i->first, (StreamState)i->second);
+                }
+            }
 
-            if (Event::handler_count == 0)
+            if (ready.empty())
             {
                 DebugIONetWrite("No I/O streams are ready.");
             }
@@ -163,15 +382,157 @@ namespace Simulator
     
     Selector* Selector::m_singleton = NULL;
 
-    Selector::Selector(const std::string& name, Object& parent, Clock& clock, Config& /*config*/)
+    void Selector::OnHostHook(CycleNo /*cycle*/)
+    {
+        if (Event::handlers.empty())
+        {
+            return;
+        }
+
+        if (m_mode == MODE_EVENT)
+        {
+            UpdateEvents();
+            return;
+        }
+        Poll();
+    }
+
+    void Selector::Poll()
+    {
+        // in principle we should be able to run event_base_loop once per
+        // kernel phase, and only actually do the I/O on the commit phase.
+        // Unfortunately, libev/kqueue only reports writability once
+        // in a while, so we end up losing opportunities to send/write by calling
+        // the loop too often.
+        Event::ready.clear();
+        ev_loop(Event::evbase, EVLOOP_NONBLOCK);
+        ++m_npolls;
+    }
+
+    bool Selector::UpdateEvents()
+    {
+#ifdef HAVE_PTHREAD
+        // Readability is only kept until the next check, the host thread
+        // verifies it again if the client still needs it. Writability is
+        // kept: it rarely goes away and the handlers do non-blocking I/O.
+        for (map<int, int>::iterator i = Event::ready.begin(); i != Event::ready.end(); )
+        {
+            i->second &= ~READABLE;
+            if (i->second == 0)
+                Event::ready.erase(i++);
+            else
+                ++i;
+        }
+
+        Event::Readiness r;
+        while (Event::posted->Pop(r))
+        {
+            Event::ready[r.fd] |= r.state;
+            Event::armed[r.fd] = 0;
+            ++m_nevents;
+        }
+
+        bool active = false, wake = false;
+        for (map<int, ev::io*>::const_iterator i = Event::handlers.begin(); i != Event::handlers.end(); ++i)
+        {
+            const int fd = i->first;
+            const int interest = ((ISelectorClient*)i->second->data)->GetStreamInterest(fd);
+            map<int, int>::const_iterator p = Event::ready.find(fd);
+            const int held = (p != Event::ready.end()) ? p->second : 0;
+            if (held & interest)
+            {
+                active = true;
+            }
+
+            int &armed = Event::armed[fd];
+            r.fd    = fd;
+            r.state = ((interest & READABLE) | (interest & WRITABLE & ~held)) & ~armed;
+            if (r.state != 0 && Event::requests->Push(r))
+            {
+                // When the ring is full, we try again at the next check
+                armed |= r.state;
+                wake = true;
+            }
+        }
+
+        if (wake)
+        {
+            Event::wakeup->send();
+        }
+
+        m_active = active;
+        if (active && !m_doCheckStreams.IsSet())
+        {
+            // Host hooks are allowed to activate a process
+            m_doCheckStreams.Set();
+        }
+        ++m_npolls;
+        return active;
+#else
+        return false;
+#endif
+    }
+
+    bool Selector::OnHostIdle()
+    {
+#ifdef HAVE_PTHREAD
+        if (m_mode != MODE_EVENT || Event::handlers.empty())
+        {
+            return false;
+        }
+
+        // The simulation only waits for the host streams now. This
+        // replaces the polling of an idle simulation in poll mode.
+        while (!UpdateEvents())
+        {
+            pthread_mutex_lock(&Event::idle_lock);
+            while (Event::posted->Empty() && !GetKernel()->IsStopRequested())
+            {
+                // Wake up now and then to see if we were interrupted
+                struct timeval  tv;
+                struct timespec ts;
+                gettimeofday(&tv, NULL);
+                ts.tv_sec  = tv.tv_sec + (tv.tv_usec + 100000) / 1000000;
+                ts.tv_nsec = ((tv.tv_usec + 100000) % 1000000) * 1000;
+                pthread_cond_timedwait(&Event::idle_available, &Event::idle_lock, &ts);
+            }
+            pthread_mutex_unlock(&Event::idle_lock);
+
+            if (GetKernel()->IsStopRequested())
+            {
+                return false;
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Selector::Selector(const std::string& name, Object& parent, Clock& clock, Config& config)
         : Object(name, parent, clock),
           m_doCheckStreams("f_checking", *this, clock, false),
+          m_mode(MODE_POLL),
+          m_pollCycles(config.getValueOrDefault<CycleNo>("SelectorPollCycles", 1)),
+          m_nextPoll(0),
+          m_pollInterval(config.getValueOrDefault<uint64_t>("SelectorPollInterval", 1000)),
+          m_npolls(0),
+          m_nevents(0),
+          m_active(false),
           p_checkStreams(*this, "check-streams", delegate::create<Selector, &Selector::DoCheckStreams>(*this))
     { 
         if (m_singleton != NULL)
         {
             throw InvalidArgumentException(*this, "More than one selector defined, previous at " + m_singleton->GetFQN());
         }
+        if (m_pollCycles == 0)
+        {
+            throw InvalidArgumentException(*this, "SelectorPollCycles must be at least 1");
+        }
+        if (m_pollInterval == 0)
+        {
+            throw InvalidArgumentException(*this, "SelectorPollInterval must be at least 1");
+        }
         m_singleton = this;
 
         // debug
@@ -184,11 +545,75 @@ namespace Simulator
             throw InvalidArgumentException(*this, "Unable to initialize libev, bad LIBEV_FLAGS in environment?");
         }
 
+        const std::string mode = config.getValueOrDefault<std::string>("SelectorMode", "POLL");
+        if (mode == "EVENT")
+        {
+#ifdef HAVE_PTHREAD
+            Event::hostloop = ev_loop_new(EVFLAG_AUTO);
+            if (Event::hostloop == NULL)
+            {
+                throw InvalidArgumentException(*this, "Unable to initialize libev for the host thread");
+            }
+            Event::posted   = new Event::Ring(Event::RING_SIZE);
+            Event::requests = new Event::Ring(Event::RING_SIZE);
+            Event::shutdown = false;
+            Event::wakeup   = new ev::async(Event::hostloop);
+            Event::wakeup->set<Event::host_wakeup_callback>(NULL);
+            Event::wakeup->start();
+            pthread_mutex_init(&Event::idle_lock, NULL);
+            pthread_cond_init(&Event::idle_available, NULL);
+            if (pthread_create(&Event::thread, NULL, Event::host_thread, NULL) != 0)
+            {
+                throw InvalidArgumentException(*this, "Unable to start the selector thread");
+            }
+            m_mode = MODE_EVENT;
+#else
+            throw InvalidArgumentException(*this, "SelectorMode EVENT requires thread support");
+#endif
+        }
+        else if (mode == "HOSTPOLL")
+        {
+            m_mode = MODE_HOSTPOLL;
+        }
+        else if (mode != "POLL")
+        {
+            throw exceptf<InvalidArgumentException>(*this, "Invalid SelectorMode: %s", mode.c_str());
+        }
+
         m_doCheckStreams.Sensitive(p_checkStreams);
+
+        RegisterSampleVariableInObject(m_npolls, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nevents, SVC_CUMULATIVE);
+        if (m_mode != MODE_POLL)
+        {
+            GetKernel()->RegisterHostHook(*this, 0, m_pollInterval);
+        }
     }
 
     Selector::~Selector()
     {
+        if (m_mode != MODE_POLL)
+        {
+            GetKernel()->UnregisterHostHook(*this);
+        }
+
+#ifdef HAVE_PTHREAD
+        if (m_mode == MODE_EVENT)
+        {
+            Event::shutdown = true;
+            Event::wakeup->send();
+            pthread_join(Event::thread, NULL);
+
+            delete Event::wakeup;
+            delete Event::posted;
+            delete Event::requests;
+            Event::armed.clear();
+            ev_loop_destroy(Event::hostloop);
+            pthread_cond_destroy(&Event::idle_available);
+            pthread_mutex_destroy(&Event::idle_lock);
+        }
+#endif
+
         for (map<int,ev::io*>::const_iterator i = Event::handlers.begin(); i != Event::handlers.end(); ++i)
         {
             delete i->second;
@@ -205,9 +630,25 @@ namespace Simulator
             << "notifying other components when I/O is possible." << endl
             << endl
             << "Currently checking: " << (m_doCheckStreams.IsSet() ? "yes" : "no") << endl
-            << "Checking method: ";
+            << "Checks so far: " << m_npolls << endl;
+        switch (m_mode)
+        {
+        case MODE_POLL:     out << "Mode: poll, every " << m_pollCycles << " cycles" << endl; break;
+        case MODE_HOSTPOLL: out << "Mode: poll, every " << m_pollInterval << " us of host time" << endl; break;
+        case MODE_EVENT:    out << "Mode: event (host thread), checked every " << m_pollInterval << " us of host time" << endl; break;
+        }
+        if (m_mode == MODE_EVENT)
+        {
+            out << "Events from the host thread: " << m_nevents << endl
+                << "Streams ready and needed: " << (m_active ? "yes" : "no") << endl;
+        }
+        out << "Checking method: ";
 
+#ifdef HAVE_PTHREAD
+        unsigned backend = ev_backend(m_mode == MODE_EVENT ? Event::hostloop : Event::evbase);
+#else
         unsigned backend = ev_backend(Event::evbase);
+#endif
         switch(backend)
         {
         case ev::SELECT: cout << "select"; break;
@@ -13,11 +13,28 @@ namespace Simulator
 
     class ISelectorClient;
 
-    class Selector : public Object, public Inspect::Interface<Inspect::Info>
+    class Selector : public Object, public IHostHook, public Inspect::Interface<Inspect::Info>
     {
         static Selector*     m_singleton;
 
+        enum Mode
+        {
+            MODE_POLL,      ///< check-streams polls the streams every m_pollCycles cycles; deterministic
+            MODE_HOSTPOLL,  ///< A host hook polls the streams every m_pollInterval of host time
+            MODE_EVENT,     ///< A host thread waits for the streams, check-streams runs when one is ready
+        };
+
         SingleFlag m_doCheckStreams;
+        Mode       m_mode;
+        CycleNo    m_pollCycles;     ///< In poll mode, cycles between checks for readiness
+        CycleNo    m_nextPoll;       ///< In poll mode, cycle of the next check for readiness
+        uint64_t   m_pollInterval;   ///< In the host modes, host microseconds between checks for readiness
+        uint64_t   m_npolls;         ///< Number of checks for readiness
+        uint64_t   m_nevents;        ///< Number of readiness events from the host thread
+        bool       m_active;         ///< In event mode, is a stream ready that a client needs?
+
+        void Poll();
+        bool UpdateEvents();
 
     public:
 
@@ -34,6 +51,10 @@ namespace Simulator
 
         Result DoCheckStreams();
 
+        // From IHostHook: check the streams for readiness
+        void OnHostHook(CycleNo cycle);
+        bool OnHostIdle();
+
         bool RegisterStream(int fd, ISelectorClient& callback);
         bool UnregisterStream(int fd);
 
@@ -51,6 +72,12 @@ namespace Simulator
     {
     public:
         virtual bool OnStreamReady(int fd, Selector::StreamState state) = 0;
+        // Which readiness of the stream the client currently needs to make
+        // progress. In event mode, the selector is only active while one of
+        // these is ready.
+        virtual int GetStreamInterest(int /*fd*/) const { return Selector::READABLE | Selector::WRITABLE; }
+        // Called when the simulation stops, to flush buffered output.
+        virtual void OnSelectorDisabled() {}
         virtual std::string GetSelectorClientName() const = 0;
         virtual ~ISelectorClient() {}
     };
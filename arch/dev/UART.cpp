@@ -4,6 +4,8 @@
 #include <cstring>
 #include <cstdlib>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
 
 using namespace std;
 
@@ -78,6 +80,21 @@ namespace Simulator
 
           m_loopback(false),
           m_scratch(0),
+
+          m_outbuf(std::max<size_t>(1, config.getValueOrDefault<size_t>(*this, "UARTOutputBufferSize", 1))),
+          m_outbuf_head(0),
+          m_outbuf_count(0),
+          m_outbuf_since(0),
+          m_flushOnNewline(config.getValueOrDefault<bool>(*this, "UARTOutputFlushOnNewline", true)),
+          m_flushDelay(config.getValueOrDefault<CycleNo>(*this, "UARTOutputFlushDelay", 0)),
+
+          m_inbuf(std::max<size_t>(1, config.getValueOrDefault<size_t>(*this, "UARTInputBufferSize", 1))),
+          m_inbuf_head(0),
+          m_inbuf_count(0),
+
+          m_nflushes(0),
+          m_nreads(0),
+
           m_enabled(false),
 
           p_dummy(*this, "dummy-process", delegate::create<UART, &UART::DoNothing>(*this))
@@ -184,6 +201,14 @@ namespace Simulator
         config.registerProperty(*this, "inpfifosz", m_fifo_in.GetMaxSize());
         config.registerProperty(*this, "outfifosz", m_fifo_out.GetMaxSize());
         RegisterSampleVariableInObject(m_enabled, SVC_LEVEL);
+        RegisterSampleVariableInObject(m_nflushes, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nreads, SVC_CUMULATIVE);
+    }
+
+    UART::~UART()
+    {
+        // Send the remaining output to the host.
+        FlushOutput(true);
     }
 
     Result UART::DoSendReadInterrupt()
@@ -385,6 +410,7 @@ namespace Simulator
                 m_writeInterrupt.Clear();
                 m_readInterrupt.Clear();
                 COMMIT {
+                    FlushOutput(true);
                     Selector::GetSelector().UnregisterStream(m_fd_in); 
                     if (m_fd_in != m_fd_out)
                         Selector::GetSelector().UnregisterStream(m_fd_out); 
@@ -556,65 +582,141 @@ namespace Simulator
     }
 
 
+    void UART::FlushOutput(bool wait)
+    {
+        // Write the contents of the output ring to the host, with at
+        // most two segments. If wait is set, block until everything
+        // is written, otherwise stop when the host would block.
+        while (m_outbuf_count > 0)
+        {
+            struct iovec iov[2];
+            size_t first = std::min(m_outbuf_count, m_outbuf.size() - m_outbuf_head);
+            iov[0].iov_base = &m_outbuf[m_outbuf_head];
+            iov[0].iov_len = first;
+            iov[1].iov_base = &m_outbuf[0];
+            iov[1].iov_len = m_outbuf_count - first;
+
+            ssize_t res = writev(m_fd_out, iov, (iov[1].iov_len > 0) ? 2 : 1);
+            if (res < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    m_error_out = errno;
+                    DebugIOWrite("error in writev(): %s, dropping %u bytes", strerror(errno), (unsigned)m_outbuf_count);
+                    m_outbuf_count = 0;
+                    break;
+                }
+                if (!wait)
+                    break;
+
+                struct pollfd pfd;
+                pfd.fd = m_fd_out;
+                pfd.events = POLLOUT;
+                poll(&pfd, 1, -1);
+                continue;
+            }
+
+            ++m_nflushes;
+            DebugIOWrite("Flushed %u bytes from output buffer to fd %d", (unsigned)res, m_fd_out);
+            m_outbuf_head = (m_outbuf_head + res) % m_outbuf.size();
+            m_outbuf_count -= res;
+        }
+        if (m_outbuf_count == 0)
+        {
+            m_outbuf_head = 0;
+        }
+    }
+
+    void UART::FillInput(int fd)
+    {
+        // Read as much as fits in the input ring, with at most two
+        // segments.
+        size_t tail = (m_inbuf_head + m_inbuf_count) % m_inbuf.size();
+        size_t space = m_inbuf.size() - m_inbuf_count;
+        struct iovec iov[2];
+        size_t first = std::min(space, m_inbuf.size() - tail);
+        iov[0].iov_base = &m_inbuf[tail];
+        iov[0].iov_len = first;
+        iov[1].iov_base = &m_inbuf[0];
+        iov[1].iov_len = space - first;
+
+        ssize_t res = readv(fd, iov, (iov[1].iov_len > 0) ? 2 : 1);
+        if (res == 0)
+        {
+            m_eof = true;
+            DebugIOWrite("Detected EOF condition on fd %d", fd);
+        }
+        else if (res < 0)
+        {
+            // we might get spurious availability events. Only
+            // catch an error if this is one.
+            if (errno != EAGAIN && errno != EINTR && errno != EWOULDBLOCK)
+            {
+                m_error_in = errno;
+                DebugIOWrite("error in readv(): %s", strerror(errno));
+            }
+        }
+        else
+        {
+            ++m_nreads;
+            m_inbuf_count += res;
+            DebugIOWrite("Read %u bytes from fd %d to input buffer", (unsigned)res, fd);
+        }
+    }
+
     bool UART::OnStreamReady(int fd, Selector::StreamState state)
     {
         // fprintf(stderr, "External fd %d is ready for I/O (state %d) in %d out %d\n", fd, (int)state, m_fd_in, m_fd_out);
 
-        if (fd == m_fd_in && (state & Selector::READABLE))
+        if (!m_hwbuf_in_full && m_inbuf_count == 0 && fd == m_fd_in && (state & Selector::READABLE))
         {
             // fprintf(stderr, "External fd %d is readable\n", fd);
+            FillInput(fd);
+        }
+
+        // The input latch is loaded from the input buffer at the same
+        // rate as it was loaded from the stream without buffering:
+        // at most one byte per stream event.
+        if (m_inbuf_count > 0)
+        {
             if (m_hwbuf_in_full)
             {
                 DeadlockWrite("Cannot acquire byte, input latch busy");
             }
             else
             {
-                ssize_t res = read(fd, &m_hwbuf_in, 1);
-                if (res == 0)
-                {
-                    m_eof = true;
-                    DebugIOWrite("Detected EOF condition on fd %d", fd);
-                }
-                else if (res < 0)
-                {
-                    // we might get spurious availability events. Only
-                    // catch an error if this is one.
-                    if (errno != EAGAIN && errno != EINTR && errno != EWOULDBLOCK)
-                    {
-                        m_error_in = errno;
-                        DebugIOWrite("error in read(): %s", strerror(errno));
-                    }
-                }
-                else
-                {
-                    assert(res == 1);
-                    m_hwbuf_in_full = true;
-                    m_receiveEnable.Set();
-                    DebugIOWrite("Acquired one byte from fd %d to input latch: %#02x", fd, (unsigned)m_hwbuf_in);
-                }
+                m_hwbuf_in = m_inbuf[m_inbuf_head];
+                m_inbuf_head = (m_inbuf_head + 1) % m_inbuf.size();
+                --m_inbuf_count;
+                m_hwbuf_in_full = true;
+                m_receiveEnable.Set();
+                DebugIOWrite("Acquired one byte from input buffer to input latch: %#02x", (unsigned)m_hwbuf_in);
             }
         }
 
         if (fd == m_fd_out && (state & Selector::WRITABLE))
         {
-            if (m_hwbuf_out_full)
+            if (m_outbuf_count == m_outbuf.size())
             {
-                ssize_t res = write(fd, &m_hwbuf_out, 1);
-                if (res < 0)
+                FlushOutput(false);
+            }
+
+            if (m_hwbuf_out_full && m_outbuf_count < m_outbuf.size())
+            {
+                if (m_outbuf_count == 0)
                 {
-                    // we might get spurious availability events. Only
-                    // catch an error if this is one.
-                    if (errno != EAGAIN && errno != EINTR && errno != EWOULDBLOCK)
-                    {
-                        m_error_out = errno;
-                        DebugIOWrite("error in write(): %s", strerror(errno));
-                    }
+                    m_outbuf_since = GetKernel()->GetCycleNo();
                 }
-                else
+                m_outbuf[(m_outbuf_head + m_outbuf_count) % m_outbuf.size()] = m_hwbuf_out;
+                ++m_outbuf_count;
+                DebugIOWrite("Sent one byte from output latch to output buffer: %#02x", (unsigned)m_hwbuf_out);
+                m_hwbuf_out_full = false;
+
+                if (m_outbuf_count == m_outbuf.size() || (m_flushOnNewline && m_hwbuf_out == '\n'))
                 {
-                    assert(res == 1);
-                    DebugIOWrite("Sent one byte from output latch to fd %d: %#02x", fd, (unsigned)m_hwbuf_out);
-                    m_hwbuf_out_full = false;
+                    FlushOutput(false);
                 }
             }
             else
@@ -622,10 +724,39 @@ namespace Simulator
                 /* nothing to do */
                 /* DebugIOWrite("Output latch empty, nothing to send"); */
             }
+
+            if (m_outbuf_count > 0 && GetKernel()->GetCycleNo() >= m_outbuf_since + m_flushDelay)
+            {
+                FlushOutput(false);
+            }
         }
         return true;
     }
 
+    int UART::GetStreamInterest(int fd) const
+    {
+        int interest = 0;
+        if (m_inbuf_count > 0)
+        {
+            // Buffered input is moved to the input latch on any event
+            interest |= Selector::READABLE | Selector::WRITABLE;
+        }
+        if (fd == m_fd_in && !m_hwbuf_in_full)
+        {
+            interest |= Selector::READABLE;
+        }
+        if (fd == m_fd_out && (m_hwbuf_out_full || m_outbuf_count > 0))
+        {
+            interest |= Selector::WRITABLE;
+        }
+        return interest;
+    }
+
+    void UART::OnSelectorDisabled()
+    {
+        FlushOutput(true);
+    }
+
     string UART::GetSelectorClientName() const
     {
         return GetFQN();
@@ -651,6 +782,8 @@ namespace Simulator
             << endl
             << "Stream output latch: " << (m_hwbuf_out_full ? "full" : "empty") << endl
             << "Stream input latch: " << (m_hwbuf_in_full ? "full" : "empty") << endl
+            << "Host output buffer: " << m_outbuf_count << " of " << m_outbuf.size() << " bytes" << endl
+            << "Host input buffer: " << m_inbuf_count << " of " << m_inbuf.size() << " bytes" << endl
             << "Input error condition: " << (m_error_in ? strerror(m_error_in) : "(no error)") << endl
             << "Output error condition: " << (m_error_out ? strerror(m_error_out) : "(no error)")<< endl
             << "End-of-file reached: " << (m_eof ? "yes" : "no") << endl;
@@ -60,6 +60,28 @@ namespace Simulator
         bool m_loopback;
         unsigned char m_scratch;
 
+        // Host-side buffering. Output bytes leave the output latch at
+        // the same time as without buffering, but are gathered in a
+        // ring and written to the host in batches. Input is read from
+        // the host in chunks and fed to the input latch one byte at a
+        // time.
+        std::vector<char> m_outbuf;
+        size_t  m_outbuf_head;
+        size_t  m_outbuf_count;
+        CycleNo m_outbuf_since;         ///< Cycle when the oldest unflushed byte was buffered
+        bool    m_flushOnNewline;
+        CycleNo m_flushDelay;           ///< Maximum number of cycles a byte stays buffered
+
+        std::vector<char> m_inbuf;
+        size_t  m_inbuf_head;
+        size_t  m_inbuf_count;
+
+        uint64_t m_nflushes;
+        uint64_t m_nreads;
+
+        void FlushOutput(bool wait);
+        void FillInput(int fd);
+
         std::string m_fin_name;
         std::string m_fout_name;
         int m_fd_in;
@@ -71,6 +93,7 @@ namespace Simulator
 
     public:
         UART(const std::string& name, Object& parent, IIOBus& iobus, IODeviceID devid, Config& config);
+        ~UART();
 
 
         // from IIOBusClient
@@ -81,6 +104,8 @@ namespace Simulator
 
         // From ISelectorClient
         bool OnStreamReady(int fd, Selector::StreamState state);
+        int  GetStreamInterest(int fd) const;
+        void OnSelectorDisabled();
         std::string GetSelectorClientName() const;
 
         /* debug */
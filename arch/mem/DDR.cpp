@@ -16,58 +16,161 @@ static T GET_BITS(const T& value, unsigned int offset, unsigned int size)
 
 static const unsigned long INVALID_ROW = std::numeric_limits<unsigned long>::max();
 
-bool DDRChannel::Read(MemAddr address, MemSize size)
+// Decodes the bank array and row of the current offset of the request
+void DDRChannel::Decode(Request& request) const
+{
+    // Decode the burst address
+    const MemAddr      address = (request.address + request.offset) / m_ddrconfig.m_nDevicesPerRank;
+    const unsigned int bank    = GET_BITS(address, m_ddrconfig.m_nBankStart, m_ddrconfig.m_nBankBits),
+                       rank    = GET_BITS(address, m_ddrconfig.m_nRankStart, m_ddrconfig.m_nRankBits);
+
+    // Ranks and banks are analogous in this concept; each bank can be invidually pre-charged and activated,
+    // providing an array of rows * columns cells.
+    request.array = rank * (1 << m_ddrconfig.m_nBankBits) + bank;
+    request.row   = GET_BITS(address, m_ddrconfig.m_nRowStart, m_ddrconfig.m_nRowBits);
+}
+
+bool DDRChannel::Queue(MemAddr address, MemSize size, bool write)
 {
-    if (m_busy.IsSet())
+    if (m_queue.size() >= m_queueSize)
     {
-        // We're still busy
+        // The queue is full
         return false;
     }
-    
-    // Accept request
-    COMMIT
+
+    if (m_queue.empty() && !m_busy.Set())
     {
-        m_request.address = address;
-        m_request.offset  = 0;
-        m_request.size    = size;
-        m_request.write   = false;
+        return false;
     }
-    
-    if (!m_busy.Set())
+
+    // Accept request
+    COMMIT
     {
-        return false;
+        Request request;
+        request.address = address;
+        request.offset  = 0;
+        request.size    = size;
+        request.write   = write;
+        request.started = false;
+        request.opened  = false;
+        request.arrival = GetClock().GetCycleNo();
+        Decode(request);
+        m_queue.push_back(request);
+
+        if (write) ++m_nwrites; else ++m_nreads;
     }
     return true;
 }
 
+bool DDRChannel::Read(MemAddr address, MemSize size)
+{
+    return Queue(address, size, false);
+}
+
 bool DDRChannel::Write(MemAddr address, MemSize size)
 {
-    if (m_busy.IsSet())
+    return Queue(address, size, true);
+}
+
+// Marks the request as being served; called from COMMIT
+void DDRChannel::Start(Request& request, CycleNo now)
+{
+    if (!request.started)
     {
-        // We're still busy
-        return false;
+        request.started = true;
+        m_queueDelay += now - request.arrival;
     }
-    
-    // Accept request
+}
+
+// Issues a burst for a request whose row is open
+Result DDRChannel::DoBurst(size_t index, CycleNo now)
+{
+    Request& request = m_queue[index];
+    Bank&    bank    = m_banks[request.array];
+
+    // We read from m_nDevicesPerRank devices, each providing m_nBurstLength bytes in the burst.
+    const unsigned burst_size = m_ddrconfig.m_nBurstSize;
+    const unsigned int offset = (request.address + request.offset) % m_ddrconfig.m_nDevicesPerRank;
+
+    // Process a single burst
+    unsigned int remainder = request.size - request.offset;
+    unsigned int size      = std::min(burst_size - offset, remainder);
+
     COMMIT
     {
-        m_request.address = address;
-        m_request.offset  = 0;
-        m_request.size    = size;
-        m_request.write   = true;
+        Start(request, now);
+
+        // Update address to reflect the read or written portion
+        request.offset += size;
+        if (m_queueSize == 1)
+        {
+            // In order: a burst holds up all commands
+            if (request.write)
+            {
+                m_next_command   = now + m_ddrconfig.m_tCWL;
+                m_next_precharge = now + m_ddrconfig.m_tWR;
+            }
+            else
+            {
+                request.done   = now + m_ddrconfig.m_tCL;
+                m_next_command = now + m_ddrconfig.m_tCCD;
+            }
+        }
+        else if (request.write)
+        {
+            m_next_command      = now + 1;
+            m_next_column       = now + m_ddrconfig.m_tCWL;
+            bank.next_precharge = std::max(bank.next_precharge, now + m_ddrconfig.m_tWR);
+        }
+        else
+        {
+            m_next_command = now + 1;
+            request.done   = now + m_ddrconfig.m_tCL;
+            m_next_column  = now + m_ddrconfig.m_tCCD;
+        }
     }
 
-    if (!m_busy.Set())
+    if (size < remainder)
     {
-        return false;
+        // We're not done yet
+        COMMIT{ Decode(request); }
+        return SUCCESS;
     }
-    return true;
+
+    if (!request.write)
+    {
+        // We're done with this read; queue it into the pipeline
+        if (!m_pipeline.Push(request))
+        {
+            // The read pipeline should be big enough
+            assert(false);
+            return FAILED;
+        }
+    }
+
+    // We've completed this request
+    if (m_queue.size() == 1 && !m_busy.Clear())
+    {
+        return FAILED;
+    }
+
+    COMMIT
+    {
+        if (!request.opened)
+        {
+            ++m_nrowhits;
+        }
+        m_queue.erase(m_queue.begin() + index);
+    }
+    return SUCCESS;
 }
 
-// Main process for timing the current active request
+// Main process for scheduling the commands of the queued requests
 Result DDRChannel::DoRequest()
 {
     assert(m_busy.IsSet());
+    assert(!m_queue.empty());
+    COMMIT{ ++m_activeCycles; }
     
     const CycleNo now = GetClock().GetCycleNo();
     if (now < m_next_command)
@@ -75,97 +178,138 @@ Result DDRChannel::DoRequest()
         // Can't continue yet
         return SUCCESS;
     }
-    
-    // We read from m_nDevicesPerRank devices, each providing m_nBurstLength bytes in the burst.
-    const unsigned burst_size = m_ddrconfig.m_nBurstSize;
-    
-    // Decode the burst address and offset-within-burst
-    const MemAddr      address = (m_request.address + m_request.offset) / m_ddrconfig.m_nDevicesPerRank;
-    const unsigned int offset  = (m_request.address + m_request.offset) % m_ddrconfig.m_nDevicesPerRank;
-    const unsigned int bank    = GET_BITS(address, m_ddrconfig.m_nBankStart, m_ddrconfig.m_nBankBits),
-                       rank    = GET_BITS(address, m_ddrconfig.m_nRankStart, m_ddrconfig.m_nRankBits),
-                       row     = GET_BITS(address, m_ddrconfig.m_nRowStart,  m_ddrconfig.m_nRowBits);
 
-    // Ranks and banks are analogous in this concept; each bank can be invidually pre-charged and activated,
-    // providing an array of rows * columns cells.
-    const unsigned int array  = rank * (1 << m_ddrconfig.m_nBankBits) + bank;
-    
-    if (m_currentRow[array] != row)
+    if (m_queueSize == 1)
     {
-        if (m_currentRow[array] != INVALID_ROW)
+        return DoInOrder(now);
+    }
+
+    // When the oldest request has waited too long, the other
+    // requests for its bank may no longer go before it.
+    const Request& oldest   = m_queue.front();
+    const bool     starving = (now - oldest.arrival >= m_maxRequestAge);
+
+    // First ready: the oldest request whose row is open
+    if (now >= m_next_column)
+    {
+        for (size_t i = 0; i < m_queue.size(); ++i)
         {
-            // Precharge (close) the currently active row
-            COMMIT
+            const Request& request = m_queue[i];
+            const Bank&    bank    = m_banks[request.array];
+            if (starving && i > 0 && request.array == oldest.array)
             {
-                m_next_command = std::max(m_next_precharge, now) + m_ddrconfig.m_tRP;
-                m_currentRow[array] = INVALID_ROW;
+                continue;
+            }
+
+            if (bank.row == request.row && now >= bank.next_column)
+            {
+                return DoBurst(i, now);
             }
-            return SUCCESS;
-        }
-        
-        // Activate (open) the desired row
-        COMMIT
-        {
-            m_next_command   = now + m_ddrconfig.m_tRCD;
-            m_next_precharge = now + m_ddrconfig.m_tRAS;
-            
-            m_currentRow[array] = row;
         }
-        return SUCCESS;
     }
-    
-    // Process a single burst
-    unsigned int remainder = m_request.size - m_request.offset;
-    unsigned int size      = std::min(burst_size - offset, remainder);
 
-    if (m_request.write)
+    // Otherwise, the oldest request for a bank opens its row
+    for (size_t i = 0; i < m_queue.size(); ++i)
     {
-        COMMIT
+        Request& request = m_queue[i];
+        Bank&    bank    = m_banks[request.array];
+        if (bank.row == request.row)
         {
-            // Update address to reflect written portion
-            m_request.offset += size;
-
-            m_next_command   = now + m_ddrconfig.m_tCWL;
-            m_next_precharge = now + m_ddrconfig.m_tWR;
+            // Waiting for its burst
+            continue;
         }
 
-        if (size < remainder)
+        bool older = false;
+        for (size_t j = 0; j < i && !older; ++j)
         {
-            // We're not done yet
-            return SUCCESS;
+            older = (m_queue[j].array == request.array);
         }
-    }
-    else
-    {
-        COMMIT
+        if (older)
         {
-            // Update address to reflect read portion
-            m_request.offset += size;
-            m_request.done    = now + m_ddrconfig.m_tCL;
-            
-            // Schedule next read
-            m_next_command = now + m_ddrconfig.m_tCCD;
+            // The bank serves an older request first
+            continue;
         }
-    
-        if (size < remainder)
+
+        if (bank.row != INVALID_ROW)
         {
-            // We're not done yet
+            // A starving request closes the row regardless
+            bool wanted = false;
+            if (!starving || i > 0)
+            {
+                for (size_t j = i + 1; j < m_queue.size() && !wanted; ++j)
+                {
+                    wanted = (m_queue[j].array == request.array && m_queue[j].row == bank.row);
+                }
+            }
+
+            if (wanted || now < bank.next_precharge)
+            {
+                // Keep the row open for now
+                continue;
+            }
+
+            // Precharge (close) the currently active row
+            COMMIT
+            {
+                Start(request, now);
+                bank.row           = INVALID_ROW;
+                bank.next_activate = now + m_ddrconfig.m_tRP;
+                m_next_command     = now + 1;
+                ++m_nconflicts;
+            }
             return SUCCESS;
         }
-        
-        // We're done with this read; queue it into the pipeline
-        if (!m_pipeline.Push(m_request))
+
+        if (now >= bank.next_activate)
         {
-            // The read pipeline should be big enough
-            assert(false);
-            return FAILED;
+            // Activate (open) the desired row
+            COMMIT
+            {
+                Start(request, now);
+                request.opened      = true;
+                bank.row            = request.row;
+                bank.next_column    = now + m_ddrconfig.m_tRCD;
+                bank.next_precharge = now + m_ddrconfig.m_tRAS;
+                m_next_command      = now + 1;
+            }
+            return SUCCESS;
         }
     }
+    return SUCCESS;
+}
 
-    // We've completed this request
-    if (!m_busy.Clear())
+// Serves the single queued request with the timing of one shared
+// command stream, as the channel did before it could queue requests
+Result DDRChannel::DoInOrder(CycleNo now)
+{
+    Request& request = m_queue.front();
+    Bank&    bank    = m_banks[request.array];
+    if (bank.row == request.row)
     {
-        return FAILED;
+        return DoBurst(0, now);
+    }
+
+    if (bank.row != INVALID_ROW)
+    {
+        // Precharge (close) the currently active row
+        COMMIT
+        {
+            Start(request, now);
+            m_next_command = std::max(m_next_precharge, now) + m_ddrconfig.m_tRP;
+            bank.row       = INVALID_ROW;
+            ++m_nconflicts;
+        }
+        return SUCCESS;
+    }
+
+    // Activate (open) the desired row
+    COMMIT
+    {
+        Start(request, now);
+        request.opened   = true;
+        m_next_command   = now + m_ddrconfig.m_tRCD;
+        m_next_precharge = now + m_ddrconfig.m_tRAS;
+        bank.row         = request.row;
     }
     return SUCCESS;
 }
@@ -179,7 +323,7 @@ Result DDRChannel::DoPipeline()
     {
         // The last burst has completed, send the assembled data back
         assert(!request.write);
-        if (!m_callback->OnReadCompleted())
+        if (!m_callback->OnReadCompleted(request.address))
         {
             return FAILED;
         }
@@ -233,20 +377,43 @@ DDRChannel::DDRChannel(const std::string& name, Object& parent, Clock& clock, Co
     : Object(name, parent, clock),
       m_registry(config),
       m_ddrconfig("config", *this, clock, config),
-      // Initialize each rank at 'no row selected'
-      m_currentRow(1 << (m_ddrconfig.m_nRankBits + m_ddrconfig.m_nBankBits), INVALID_ROW),
+      m_banks(1 << (m_ddrconfig.m_nRankBits + m_ddrconfig.m_nBankBits)),
 
       m_callback(0),
+      m_queueSize(config.getValueOrDefault<size_t>(*this, "QueueSize", 1)),
+      m_maxRequestAge(config.getValueOrDefault<CycleNo>(*this, "MaxRequestAge", 128)),
       m_pipeline("b_pipeline", *this, clock, m_ddrconfig.m_tCL),
       m_busy("f_busy", *this, clock, false),
       m_next_command(0),
+      m_next_column(0),
       m_next_precharge(0),
     
       p_Request (*this, "request",  delegate::create<DDRChannel, &DDRChannel::DoRequest >(*this)),
       p_Pipeline(*this, "pipeline", delegate::create<DDRChannel, &DDRChannel::DoPipeline>(*this)),
       
-      m_busyCycles(0)
+      m_busyCycles(0),
+      m_activeCycles(0),
+      m_nreads(0),
+      m_nwrites(0),
+      m_nrowhits(0),
+      m_nconflicts(0),
+      m_queueDelay(0)
 {
+    if (m_queueSize == 0)
+    {
+        throw InvalidArgumentException(*this, "QueueSize cannot be zero");
+    }
+
+    // Initialize each bank at 'no row selected'
+    for (size_t i = 0; i < m_banks.size(); ++i)
+    {
+        m_banks[i].row            = INVALID_ROW;
+        m_banks[i].next_activate  = 0;
+        m_banks[i].next_column    = 0;
+        m_banks[i].next_precharge = 0;
+    }
+    m_queue.reserve(m_queueSize);
+
     m_busy.Sensitive(p_Request);
     m_pipeline.Sensitive(p_Pipeline);
 
@@ -263,8 +430,16 @@ DDRChannel::DDRChannel(const std::string& name, Object& parent, Clock& clock, Co
     config.registerProperty(*this, "rows", (uint32_t)(1UL<<m_ddrconfig.m_nRowBits));
     config.registerProperty(*this, "columns", (uint32_t)(1UL<<m_ddrconfig.m_nColumnBits));
     config.registerProperty(*this, "freq", (uint32_t)clock.GetFrequency());
+    config.registerProperty(*this, "queue", (uint32_t)m_queueSize);
+    config.registerProperty(*this, "maxage", (uint32_t)m_maxRequestAge);
     
     RegisterSampleVariableInObject(m_busyCycles, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_activeCycles, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nreads, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nwrites, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nrowhits, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nconflicts, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_queueDelay, SVC_CUMULATIVE);
 }
 
 void DDRChannel::SetClient(ICallback& cb, StorageTraceSet& sts, const StorageTraceSet& storages)
@@ -275,7 +450,8 @@ void DDRChannel::SetClient(ICallback& cb, StorageTraceSet& sts, const StorageTra
     }
     m_callback = &cb;
 
-    sts = m_busy;
+    // Accepting a request only sets the flag when the queue was empty
+    sts = opt(m_busy);
     p_Request.SetStorageTraces(opt(m_pipeline));
     p_Pipeline.SetStorageTraces(opt(storages));
 
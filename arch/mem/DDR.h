@@ -66,6 +66,21 @@ Bandwidth of DDR memory is identified by the number behind it. For instance,
 DDR3-800 means the data rate is 800 MHz (thus, the I/O bus frequency is 400
 MHz and the memory clock 100 MHz). Together with a 64-bit wide databus and
 2 transfers/cycle, DDR3-800 can support up to 6.4 GB/s.
+
+=== Scheduling ===
+
+A channel accepts up to QueueSize requests and schedules their commands
+first-ready, first-come-first-served (FR-FCFS): a column access for a request
+whose row is open goes first, oldest first; otherwise the oldest request for
+each bank may precharge or activate its bank. A row is not closed while a
+queued request still wants it. The banks keep their own timing, so commands
+to different banks overlap; only one command is issued per cycle and the
+column accesses share the data bus. Reads may thus complete out of order.
+Once the oldest request has waited MaxRequestAge cycles, row hits to its bank
+no longer go first and its bank's row is closed for it, so that a stream of row
+hits cannot starve it. QueueSize defaults to 1, which serves the requests in
+order with the timing of older versions: every command then waits for the
+previous one, including bursts for tCWL or tCCD, and the banks do not overlap.
 */   
 #include "kernel.h"
 #include "Memory.h"
@@ -85,7 +100,8 @@ public:
     class ICallback
     {
     public:
-        virtual bool OnReadCompleted() = 0;
+        /// Called when the read of the address, as given to Read(), has completed
+        virtual bool OnReadCompleted(MemAddr address) = 0;
         virtual ~ICallback() {}
     };
     
@@ -99,9 +115,23 @@ private:
         MemData      data;      ///< With this data
         unsigned int offset;    ///< Current offset that we're handling
         bool         write;     ///< A write or read
+        unsigned int array;     ///< Bank array of the current offset
+        unsigned long row;      ///< Row of the current offset
+        bool         started;   ///< Has a command been issued for this request?
+        bool         opened;    ///< Has a row been opened for this request?
+        CycleNo      arrival;   ///< When this request was accepted
         CycleNo      done;      ///< When this request is done
     };
 
+    /// The state of a bank array
+    struct Bank
+    {
+        unsigned long row;            ///< Currently open row
+        CycleNo       next_activate;  ///< Minimum time for next Row Activate
+        CycleNo       next_column;    ///< Minimum time for next read or write
+        CycleNo       next_precharge; ///< Minimum time for next Row Precharge
+    };
+
     class DDRConfig : public Object {
     public:
         unsigned int m_nBurstLength;    ///< Size of a single burst
@@ -134,13 +164,16 @@ private:
     // Runtime parameters
     ComponentModelRegistry&    m_registry;
     DDRConfig                  m_ddrconfig;      ///< DDR virtual chip parameters
-    std::vector<unsigned long> m_currentRow;     ///< Currently selected row, for each rank
+    std::vector<Bank>          m_banks;          ///< State of each bank, for each rank
     ICallback*                 m_callback;       ///< The callback to notify for completion
-    Request                    m_request;        ///< The current request
+    std::vector<Request>       m_queue;          ///< The accepted requests, oldest first
+    size_t                     m_queueSize;      ///< Maximum number of accepted requests
+    CycleNo                    m_maxRequestAge;  ///< Age after which the oldest request is no longer bypassed
     Buffer<Request>            m_pipeline;       ///< Pipelined reads
-    SingleFlag                 m_busy;           ///< Trigger for process
+    SingleFlag                 m_busy;           ///< Trigger for process; set while requests are queued
     CycleNo                    m_next_command;   ///< Minimum time for next command
-    CycleNo                    m_next_precharge; ///< Minimum time for next Row Precharge
+    CycleNo                    m_next_column;    ///< Minimum time for next read or write
+    CycleNo                    m_next_precharge; ///< Minimum time for next precharge, when in order
     TraceMap                   m_traces;         ///< Active traces
     
     // Processes
@@ -148,9 +181,20 @@ private:
     Process p_Pipeline;
     
     // Statistics
-    CycleNo m_busyCycles;
+    CycleNo  m_busyCycles;
+    CycleNo  m_activeCycles;  ///< Cycles with a request in progress, for the utilisation
+    uint64_t m_nreads;        ///< Number of read requests accepted
+    uint64_t m_nwrites;       ///< Number of write requests accepted
+    uint64_t m_nrowhits;      ///< Number of requests served without opening a row
+    uint64_t m_nconflicts;    ///< Number of rows closed for a request to another row
+    CycleNo  m_queueDelay;    ///< Total cycles from acceptance to first command, over all requests
     
+    void   Decode(Request& request) const;
+    bool   Queue(MemAddr address, MemSize size, bool write);
+    void   Start(Request& request, CycleNo now);
+    Result DoBurst(size_t index, CycleNo now);
     Result DoRequest();
+    Result DoInOrder(CycleNo now);
     Result DoPipeline();
     
 public:
@@ -36,7 +36,7 @@ class DDRMemory::Interface : public Object, public DDRChannel::ICallback
     Buffer<Request>     m_requests;  //< incoming from system, outgoing to memory
     Buffer<Request>     m_responses; //< incoming from memory, outgoing to system
     
-    std::queue<Request> m_activeRequests; //< Requests currently active in DDR
+    std::deque<Request> m_activeRequests; //< Requests currently active in DDR
 
     // Processes
     Process             p_Requests;
@@ -52,11 +52,21 @@ class DDRMemory::Interface : public Object, public DDRChannel::ICallback
 public:
 
     // IMemory
-    bool OnReadCompleted()
+    bool OnReadCompleted(MemAddr address)
     {
-        assert(!m_activeRequests.empty());
-        
-        Request& request = m_activeRequests.front();
+        // The DDR channel may complete reads out of order;
+        // find the oldest request for this address
+        std::deque<Request>::iterator p = m_activeRequests.begin();
+        while (p != m_activeRequests.end() && p->address != address)
+        {
+            ++p;
+        }
+        if (p == m_activeRequests.end())
+        {
+            throw exceptf<InvalidArgumentException>(*this, "DDR completed a read of %#016llx that was not requested",
+                                                    (unsigned long long)address);
+        }
+        Request& request = *p;
 
         COMMIT {
             m_memory.Read(request.address, request.data.data, m_lineSize);
@@ -69,7 +79,7 @@ public:
         }
         
         COMMIT {
-            m_activeRequests.pop();
+            m_activeRequests.erase(p);
         }
 
         return true;
@@ -111,7 +121,7 @@ public:
             
             COMMIT{ 
                 ++m_nreads;
-                m_activeRequests.push(req);
+                m_activeRequests.push_back(req);
             }
         }
         else
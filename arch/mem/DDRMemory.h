@@ -6,7 +6,7 @@
 #include "arch/Memory.h"
 #include "arch/VirtualMemory.h"
 #include "sim/inspect.h"
-#include <queue>
+#include <deque>
 #include <set>
 
 class Config;
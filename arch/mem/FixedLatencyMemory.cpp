@@ -0,0 +1,296 @@
+#include "FixedLatencyMemory.h"
+#include "sim/config.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+using namespace std;
+
+namespace Simulator
+{
+
+MCID FixedLatencyMemory::RegisterClient(IMemoryCallback& callback, Process& /*process*/, StorageTraceSet& traces, Storage& storage, bool /*ignored*/)
+{
+    // The clients of a core share its distance to memory. The cores are
+    // laid out on a grid in order of registration, with memory at the
+    // corner of core 0.
+    Object& peer = callback.GetMemoryPeer();
+    const size_t core = std::find(m_peers.begin(), m_peers.end(), &peer) - m_peers.begin();
+    if (core == m_peers.size())
+    {
+        m_peers.push_back(&peer);
+    }
+
+    ClientInfo client;
+    client.callback = &callback;
+    client.distance = (core % m_gridWidth + core / m_gridWidth) * m_latencyPerHop;
+    m_clients.push_back(client);
+
+    // Accepting a request only sets the flag when the queue was empty
+    traces = opt(m_pending);
+
+    m_storages = m_storages ^ storage;
+    p_Completions.SetStorageTraces(m_storages);
+
+    m_registry.registerRelation(peer, *this, "mem");
+
+    return m_clients.size() - 1;
+}
+
+void FixedLatencyMemory::UnregisterClient(MCID id)
+{
+    assert(id < m_clients.size() && m_clients[id].callback != NULL);
+    m_clients[id].callback = NULL;
+}
+
+// Times the request and queues it; the rest of the request is filled in
+bool FixedLatencyMemory::AddRequest(MCID id, Request& request)
+{
+    // Client should have registered
+    assert(id < m_clients.size() && m_clients[id].callback != NULL);
+
+    if (m_events.empty() && !m_pending.Set())
+    {
+        return false;
+    }
+
+    COMMIT
+    {
+        const ClientInfo& client = m_clients[id];
+        const CycleNo     now    = GetCycleNo();
+        const CycleNo     start  = std::max(now, m_nextfree);
+
+        // The request takes the next slot of the bandwidth
+        m_nextfree        = start + m_timePerLine;
+        m_bandwidthDelay += start - now;
+
+        request.callback = client.callback;
+        request.done     = start + m_timePerLine + m_baseRequestTime + client.distance;
+        request.seqno    = m_seqno++;
+
+        m_events.push_back(request);
+        std::push_heap(m_events.begin(), m_events.end(), LaterThan());
+    }
+    return true;
+}
+
+bool FixedLatencyMemory::Read(MCID id, MemAddr address)
+{
+    assert(address % m_lineSize == 0);
+
+    Request request;
+    request.address = address;
+    request.write   = false;
+    return AddRequest(id, request);
+}
+
+bool FixedLatencyMemory::Write(MCID id, MemAddr address, const MemData& data, WClientID wid)
+{
+    assert(address % m_lineSize == 0);
+
+    Request request;
+    request.address = address;
+    request.wid     = wid;
+    request.write   = true;
+    COMMIT{
+    std::copy(data.data, data.data + m_lineSize, request.data.data);
+    std::copy(data.mask, data.mask + m_lineSize, request.data.mask);
+    }
+
+    if (!AddRequest(id, request))
+    {
+        return false;
+    }
+
+    // Broadcast the snoop data
+    for (vector<ClientInfo>::const_iterator p = m_clients.begin(); p != m_clients.end(); ++p)
+    {
+        if (p->callback != NULL && !p->callback->OnMemorySnooped(address, data.data, data.mask))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FixedLatencyMemory::Reserve(MemAddr address, MemSize size, ProcessID pid, int perm)
+{
+    return VirtualMemory::Reserve(address, size, pid, perm);
+}
+
+void FixedLatencyMemory::Unreserve(MemAddr address, MemSize size)
+{
+    return VirtualMemory::Unreserve(address, size);
+}
+
+void FixedLatencyMemory::UnreserveAll(ProcessID pid)
+{
+    return VirtualMemory::UnreserveAll(pid);
+}
+
+void FixedLatencyMemory::Read(MemAddr address, void* data, MemSize size)
+{
+    return VirtualMemory::Read(address, data, size);
+}
+
+void FixedLatencyMemory::Write(MemAddr address, const void* data, const bool* mask, MemSize size)
+{
+    return VirtualMemory::Write(address, data, mask, size);
+}
+
+bool FixedLatencyMemory::CheckPermissions(MemAddr address, MemSize size, int access) const
+{
+    return VirtualMemory::CheckPermissions(address, size, access);
+}
+
+// Delivers the first request of the event queue when it is due; one per cycle
+Result FixedLatencyMemory::DoCompletions()
+{
+    assert(!m_events.empty());
+
+    const Request& request = m_events.front();
+    if (GetCycleNo() < request.done)
+    {
+        // The first request has not completed yet
+        return SUCCESS;
+    }
+
+    if (request.write)
+    {
+        if (!request.callback->OnMemoryWriteCompleted(request.wid))
+        {
+            return FAILED;
+        }
+
+        COMMIT {
+            VirtualMemory::Write(request.address, request.data.data, request.data.mask, m_lineSize);
+            ++m_nwrites;
+            m_nwrite_bytes += m_lineSize;
+        }
+    }
+    else
+    {
+        char data[m_lineSize];
+
+        VirtualMemory::Read(request.address, data, m_lineSize);
+
+        if (!request.callback->OnMemoryReadCompleted(request.address, data))
+        {
+            return FAILED;
+        }
+
+        COMMIT {
+            ++m_nreads;
+            m_nread_bytes += m_lineSize;
+        }
+    }
+
+    if (m_events.size() == 1 && !m_pending.Clear())
+    {
+        return FAILED;
+    }
+
+    COMMIT
+    {
+        std::pop_heap(m_events.begin(), m_events.end(), LaterThan());
+        m_events.pop_back();
+    }
+    return SUCCESS;
+}
+
+FixedLatencyMemory::FixedLatencyMemory(const std::string& name, Object& parent, Clock& clock, Config& config) :
+    Object(name, parent, clock),
+    m_registry       (config),
+    m_pending        ("f_pending", *this, clock, false),
+    m_baseRequestTime(config.getValue<CycleNo>(*this, "BaseRequestTime")),
+    m_timePerLine    (config.getValue<CycleNo>(*this, "TimePerLine")),
+    m_latencyPerHop  (config.getValueOrDefault<CycleNo>(*this, "LatencyPerHop", 0)),
+    m_gridWidth      ((size_t)ceil(sqrt((double)config.getValue<size_t>("NumProcessors")))),
+    m_lineSize       (config.getValue<size_t>("CacheLineSize")),
+    m_nextfree(0),
+    m_seqno(0),
+    m_nreads(0),
+    m_nread_bytes(0),
+    m_nwrites(0),
+    m_nwrite_bytes(0),
+    m_bandwidthDelay(0),
+
+    p_Completions(*this, "completions", delegate::create<FixedLatencyMemory, &FixedLatencyMemory::DoCompletions>(*this) )
+{
+    if (m_gridWidth == 0)
+    {
+        m_gridWidth = 1;
+    }
+
+    m_pending.Sensitive( p_Completions );
+    config.registerObject(*this, "fixedmem");
+    config.registerProperty(*this, "latency", (uint32_t)m_baseRequestTime);
+    config.registerProperty(*this, "timeperline", (uint32_t)m_timePerLine);
+    config.registerProperty(*this, "latencyperhop", (uint32_t)m_latencyPerHop);
+    config.registerProperty(*this, "freq", (uint32_t)clock.GetFrequency());
+
+    m_storages = StorageTraceSet(StorageTrace());   // The first request is not due yet
+    p_Completions.SetStorageTraces(m_storages);
+
+    RegisterSampleVariableInObject(m_nreads, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nread_bytes, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nwrites, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nwrite_bytes, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_bandwidthDelay, SVC_CUMULATIVE);
+}
+
+void FixedLatencyMemory::Cmd_Info(ostream& out, const vector<string>& arguments) const
+{
+    if (!arguments.empty() && arguments[0] == "ranges")
+    {
+        return VirtualMemory::Cmd_Info(out, arguments);
+    }
+    out <<
+    "The Fixed Latency Memory is an analytical memory implementation that completes\n"
+    "each request a fixed latency after it has taken a slot of the memory bandwidth.\n"
+    "The latency grows with the distance of the requesting core to memory.\n\n"
+    "Latency: " << m_baseRequestTime << " cycles, plus " << m_latencyPerHop << " cycles per hop\n"
+    "Bandwidth: one line per " << m_timePerLine << " cycles\n\n"
+    "Supported operations:\n"
+    "- info <component> ranges\n"
+    "  Displays the currently reserved and allocated memory ranges\n\n"
+    "- inspect <component> <start> <size>\n"
+    "  Reads the specified number of bytes of raw data from memory from the\n"
+    "  specified address\n\n"
+    "- inspect <component> requests\n"
+    "  Reads the queued requests, in order of completion\n";
+}
+
+void FixedLatencyMemory::Cmd_Read(ostream& out, const vector<string>& arguments) const
+{
+    if (arguments.empty() || arguments[0] != "requests")
+    {
+        return VirtualMemory::Cmd_Read(out, arguments);
+    }
+
+    std::vector<Request> events(m_events);
+    std::sort_heap(events.begin(), events.end(), LaterThan());
+
+    out << "      Address       | Type  | Done       | Source" << endl;
+    out << "--------------------+-------+------------+---------------------" << endl;
+
+    // sort_heap leaves the latest completion first
+    for (std::vector<Request>::const_reverse_iterator p = events.rbegin(); p != events.rend(); ++p)
+    {
+        out << hex << setfill('0') << right
+            << " 0x" << setw(16) << p->address << " | "
+            << (p->write ? "Write" : "Read ") << " | "
+            << dec << setfill(' ') << setw(10) << p->done << " | ";
+
+        Object* obj = dynamic_cast<Object*>(p->callback);
+        if (obj == NULL) {
+            out << "???";
+        } else {
+            out << obj->GetFQN();
+        }
+        out << endl;
+    }
+    out << endl;
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef FIXEDLATENCYMEMORY_H
+#define FIXEDLATENCYMEMORY_H
+
+#include "arch/Memory.h"
+#include "arch/VirtualMemory.h"
+#include "sim/inspect.h"
+#include <vector>
+
+class Config;
+class ComponentModelRegistry;
+
+namespace Simulator
+{
+
+/// FixedLatencyMemory: an analytical memory for design-space exploration
+/// where only the cores matter. A request is timed when it is accepted:
+/// it takes a slot of the shared bandwidth, after which it completes a
+/// fixed latency later, plus a per-hop latency for the distance of its
+/// core to memory. The requests wait in an event queue ordered on their
+/// completion time; a single process delivers them, so no process runs
+/// per request or per client.
+class FixedLatencyMemory : public Object, public IMemoryAdmin, public VirtualMemory
+{
+    struct Request
+    {
+        CycleNo          done;      ///< When the request completes
+        uint64_t         seqno;     ///< Order of acceptance, to break ties
+        bool             write;
+        MemAddr          address;
+        MemData          data;
+        WClientID        wid;
+        IMemoryCallback* callback;
+    };
+
+    /// Orders the event queue on completion time, earliest on top
+    struct LaterThan
+    {
+        bool operator()(const Request& a, const Request& b) const
+        {
+            return a.done > b.done || (a.done == b.done && a.seqno > b.seqno);
+        }
+    };
+
+    struct ClientInfo
+    {
+        IMemoryCallback* callback;
+        CycleNo          distance;  ///< Additional latency for the core of the client
+    };
+
+    bool AddRequest(MCID id, Request& request);
+
+    // IMemory
+    MCID RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, Storage& storage, bool /*ignored*/);
+    void UnregisterClient(MCID id);
+    bool Read (MCID id, MemAddr address);
+    bool Write(MCID id, MemAddr address, const MemData& data, WClientID wid);
+    bool CheckPermissions(MemAddr address, MemSize size, int access) const;
+
+    // IMemoryAdmin
+    void Reserve(MemAddr address, MemSize size, ProcessID pid, int perm);
+    void Unreserve(MemAddr address, MemSize size);
+    void UnreserveAll(ProcessID pid);
+
+    void Read (MemAddr address, void* data, MemSize size);
+    void Write(MemAddr address, const void* data, const bool* mask, MemSize size);
+
+    void GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites,
+                             uint64_t& nread_bytes, uint64_t& nwrite_bytes,
+                             uint64_t& nreads_ext, uint64_t& nwrites_ext) const
+    {
+        nreads = m_nreads;
+        nwrites = m_nwrites;
+        nread_bytes = m_nread_bytes;
+        nwrite_bytes = m_nwrite_bytes;
+        nreads_ext = m_nreads;
+        nwrites_ext = m_nwrites;
+    }
+
+    ComponentModelRegistry&  m_registry;
+    std::vector<ClientInfo>  m_clients;
+    std::vector<Object*>     m_peers;           ///< The cores of the clients, in order of registration
+    std::vector<Request>     m_events;          ///< Event queue; a heap of the requests on completion time
+    SingleFlag               m_pending;         ///< Set while the event queue is not empty
+    CycleNo                  m_baseRequestTime; ///< Config: latency of a request
+    CycleNo                  m_timePerLine;     ///< Config: cycles of bandwidth per line
+    CycleNo                  m_latencyPerHop;   ///< Config: additional latency per hop from a core to memory
+    size_t                   m_gridWidth;       ///< Number of cores on a row of the grid for the distances
+    size_t                   m_lineSize;
+    CycleNo                  m_nextfree;        ///< First cycle the bandwidth is free for the next line
+    uint64_t                 m_seqno;           ///< Number of requests accepted
+    StorageTraceSet          m_storages;
+
+    uint64_t m_nreads;
+    uint64_t m_nread_bytes;
+    uint64_t m_nwrites;
+    uint64_t m_nwrite_bytes;
+    CycleNo  m_bandwidthDelay;                  ///< Total cycles that requests waited for bandwidth
+
+    // Processes
+    Process p_Completions;
+
+    Result DoCompletions();
+
+public:
+    FixedLatencyMemory(const std::string& name, Object& parent, Clock& clock, Config& config);
+
+    // Debugging
+    void Cmd_Info(std::ostream& out, const std::vector<std::string>& arguments) const;
+    void Cmd_Read(std::ostream& out, const std::vector<std::string>& arguments) const;
+};
+
+}
+#endif
@@ -0,0 +1,116 @@
+#ifndef MESSAGEPOOL_H
+#define MESSAGEPOOL_H
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include <inttypes.h>
+
+namespace Simulator
+{
+    /// MessagePool: allocator for the messages that a ring node sends.
+    /// The messages are carved from slabs in slots of whole host cache
+    /// lines. Every slot records its pool, so a message can be released
+    /// by whichever node consumes it, in any ring. Released messages go
+    /// to a lock-free list that the owner takes over when its own free
+    /// list runs out, so the rings may be simulated by separate host
+    /// threads as long as every pool allocates from one thread only.
+    /// The slabs are freed with the pool.
+    template <typename T>
+    class MessagePool
+    {
+        static const size_t HOST_LINE_SIZE = 64;  ///< Alignment of the slots
+        static const size_t SLAB_SIZE      = 64;  ///< Number of slots per slab
+
+        /// The pool pointer follows the message in its slot
+        static const size_t OWNER_OFFSET = (sizeof(T) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+        static const size_t SLOT_SIZE    = (OWNER_OFFSET + sizeof(void*) + HOST_LINE_SIZE - 1) / HOST_LINE_SIZE * HOST_LINE_SIZE;
+
+        void*              m_free;      ///< Free slots; only touched by the owner
+        void* volatile     m_released;  ///< Slots released since the owner last took them
+        std::vector<char*> m_slabs;     ///< The allocated slabs
+
+        static void*& Next(void* slot) { return *static_cast<void**>(slot); }
+
+        void Grow()
+        {
+            char* slab = new char[SLAB_SIZE * SLOT_SIZE + HOST_LINE_SIZE - 1];
+            m_slabs.push_back(slab);
+
+            char* slot = slab + (HOST_LINE_SIZE - (uintptr_t)slab % HOST_LINE_SIZE) % HOST_LINE_SIZE;
+            for (size_t i = 0; i < SLAB_SIZE; ++i, slot += SLOT_SIZE)
+            {
+                *reinterpret_cast<MessagePool**>(slot + OWNER_OFFSET) = this;
+                Next(slot) = m_free;
+                m_free = slot;
+            }
+            m_capacity += SLAB_SIZE;
+        }
+
+    public:
+        // Statistics
+        uint64_t          m_allocated;  ///< Number of messages allocated
+        volatile uint64_t m_releases;   ///< Number of messages released
+        uint64_t          m_maxInUse;   ///< High-water mark of the messages in use
+        uint64_t          m_capacity;   ///< Number of slots in the slabs
+
+        void* Allocate()
+        {
+            if (m_free == NULL)
+            {
+                // Take over the messages that were released meanwhile
+                m_free = __sync_lock_test_and_set(&m_released, (void*)NULL);
+                if (m_free == NULL)
+                {
+                    Grow();
+                }
+            }
+
+            void* slot = m_free;
+            m_free = Next(slot);
+
+            const uint64_t inuse = ++m_allocated - m_releases;
+            if (inuse > m_maxInUse)
+            {
+                m_maxInUse = inuse;
+            }
+            return slot;
+        }
+
+        /// Returns a message to the pool that allocated it
+        static void Release(void* slot)
+        {
+            MessagePool* pool = *reinterpret_cast<MessagePool**>(static_cast<char*>(slot) + OWNER_OFFSET);
+#ifndef NDEBUG
+            // Fill the message with garbage
+            memset(slot, 0xFE, sizeof(T));
+#endif
+            void* head;
+            do
+            {
+                head = pool->m_released;
+                Next(slot) = head;
+            } while (!__sync_bool_compare_and_swap(&pool->m_released, head, slot));
+            __sync_fetch_and_add(&pool->m_releases, 1);
+        }
+
+        MessagePool()
+            : m_free(NULL), m_released(NULL),
+              m_allocated(0), m_releases(0), m_maxInUse(0), m_capacity(0)
+        {}
+
+        ~MessagePool()
+        {
+            for (size_t i = 0; i < m_slabs.size(); ++i)
+            {
+                delete[] m_slabs[i];
+            }
+        }
+
+    private:
+        MessagePool(const MessagePool&);
+        MessagePool& operator=(const MessagePool&);
+    };
+}
+
+#endif
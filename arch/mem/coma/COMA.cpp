@@ -169,6 +169,10 @@ COMA::COMA(const std::string& name, Simulator::Object& parent, Clock& clock, Con
     m_selector(IBankSelector::makeSelector(*this,
                                            config.getValueOrDefault<string>(*this, "BankSelector", "XORFOLD"),
                                            config.getValue<size_t>(*this, "L2CacheNumSets"))),
+    m_rootSelector(IBankSelector::makeSelector(*this,
+                                               config.getValueOrDefault<string>(*this, "RootDirectorySelector", "DIRECT"),
+                                               config.getValue<size_t>(*this, "NumRootDirectories"))),
+    m_rootInterleaving(config.getValueOrDefault<size_t>(*this, "RootDirectoryInterleaving", m_lineSize)),
     m_ddr("ddr", *this, config, config.getValue<size_t>(*this, "NumRootDirectories")),
     m_nreads(0), m_nwrites(0), m_nread_bytes(0), m_nwrite_bytes(0)
 {
@@ -184,12 +188,16 @@ COMA::COMA(const std::string& name, Simulator::Object& parent, Clock& clock, Con
     {
         throw InvalidArgumentException(*this, "NumRootDirectories is not a power of two");
     }
+    if (!IsPowerOfTwo(m_rootInterleaving) || m_rootInterleaving < m_lineSize)
+    {
+        throw exceptf<InvalidArgumentException>(*this, "RootDirectoryInterleaving is not a power of two multiple of the line size: %zu", m_rootInterleaving);
+    }
     
     for (size_t i = 0; i < m_roots.size(); ++i)
     {
         stringstream name;
         name << "rootdir" << i;
-        m_roots[i] = new RootDirectory(name.str(), *this, clock, i, m_roots.size(), m_ddr, config);
+        m_roots[i] = new RootDirectory(name.str(), *this, clock, i, m_ddr, config);
     }
     
 }
@@ -207,6 +215,8 @@ void OneLevelCOMA::Initialize()
 {
     m_config.registerObject(*this, "coma");
     m_config.registerProperty(*this, "selector", m_selector->GetName());
+    m_config.registerProperty(*this, "rootselector", m_rootSelector->GetName());
+    m_config.registerProperty(*this, "rootinterleaving", (uint32_t)m_rootInterleaving);
 
     //
     // Figure out the layout of the top-level ring
@@ -243,12 +253,16 @@ void OneLevelCOMA::Initialize()
 
         m_config.registerRelation(*nodes[i], *next, "topring", true);
     }
+
+    InitializeExpress();
 }
 
 void TwoLevelCOMA::Initialize()
 {
     m_config.registerObject(*this, "coma");
     m_config.registerProperty(*this, "selector", m_selector->GetName());
+    m_config.registerProperty(*this, "rootselector", m_rootSelector->GetName());
+    m_config.registerProperty(*this, "rootinterleaving", (uint32_t)m_rootInterleaving);
 
     // Initialize the caches
     for (size_t i = 0; i < m_caches.size(); ++i)
@@ -309,6 +323,25 @@ void TwoLevelCOMA::Initialize()
 
         m_config.registerRelation(*nodes[i], *next, "topring", true);
     }
+
+    InitializeExpress();
+}
+
+void COMA::InitializeExpress()
+{
+    for (size_t i = 0; i < m_caches.size(); ++i)
+    {
+        m_caches[i]->InitializeExpress();
+    }
+    for (size_t i = 0; i < m_directories.size(); ++i)
+    {
+        m_directories[i]->m_bottom.InitializeExpress();
+        m_directories[i]->m_top.InitializeExpress();
+    }
+    for (size_t i = 0; i < m_roots.size(); ++i)
+    {
+        m_roots[i]->InitializeExpress();
+    }
 }
 
 COMA::~COMA()
@@ -329,6 +362,7 @@ COMA::~COMA()
     }
 
     delete m_selector;
+    delete m_rootSelector;
 }
 
 size_t COMA::GetNumCacheSets() const
@@ -381,6 +415,8 @@ void COMA::Cmd_Info(ostream& out, const vector<string>& arguments) const
     "to off-chip storage.\n"
     "\n"
     "This memory uses the following mapping of lines to cache sets(banks): " << m_selector->GetName() <<
+    "\n"
+    "and the following mapping of " << m_rootInterleaving << "-byte blocks to root directories: " << m_rootSelector->GetName() <<
     "\n\n"
     "Supported operations:\n"
     "- info <component> ranges\n"
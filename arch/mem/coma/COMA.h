@@ -49,6 +49,8 @@ protected:
     size_t                      m_lineSize;
     Config&                     m_config;
     IBankSelector*              m_selector;           ///< Mapping of line addresses to set indexes
+    IBankSelector*              m_rootSelector;       ///< Mapping of interleaving units to root directories
+    size_t                      m_rootInterleaving;   ///< Size of the interleaving unit, in bytes
     std::vector<Cache*>         m_caches;             ///< List of caches
     std::vector<Directory*>     m_directories;        ///< List of directories
     std::vector<RootDirectory*> m_roots;              ///< List of root directories
@@ -65,6 +67,9 @@ protected:
     }
     
     virtual void Initialize() = 0;
+
+    /// Set up the express paths on the rings, after Initialize()
+    void InitializeExpress();
     
 public:
     COMA(const std::string& name, Simulator::Object& parent, Clock& clock, Config& config);
@@ -74,6 +79,12 @@ public:
 
     IBankSelector& GetBankSelector() const { return *m_selector; }
 
+    /// Returns the root directory that owns the line at the address, and
+    /// the address of the line in the DDR channel of that root directory
+    size_t MapToRootDirectory(MemAddr address, MemAddr& local) const {
+        return m_rootSelector->MapInterleaved(address, m_rootInterleaving, local);
+    }
+
     size_t GetLineSize() const { return m_lineSize; }
     size_t GetNumClientsPerCache() const { return m_numClientsPerCache; }    
     size_t GetNumCachesPerLowRing() const { return m_numCachesPerLowRing; }
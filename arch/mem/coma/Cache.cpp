@@ -129,19 +129,10 @@ COMA::Cache::Line* COMA::Cache::FindLine(MemAddr address)
     MemAddr tag;
     size_t  setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
-    {
-        Line& line = m_lines[set + i];
-        if (line.state != LINE_EMPTY && line.tag == tag)
-        {
-            // The wanted line was in the cache
-            return &line;
-        }
-    }
-    return NULL;
+    // Find the line; empty lines have no tag
+    const size_t index = m_tags.Find(setindex, tag);
+    return (index != m_tags.Count()) ? &m_lines[index] : NULL;
 }
 
 // Attempts to find a line for the specified address.
@@ -150,19 +141,10 @@ const COMA::Cache::Line* COMA::Cache::FindLine(MemAddr address) const
     MemAddr tag;
     size_t  setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
-    {
-        const Line& line = m_lines[set + i];
-        if (line.state != LINE_EMPTY && line.tag == tag)
-        {
-            // The wanted line was in the cache
-            return &line;
-        }
-    }
-    return NULL;
+    // Find the line; empty lines have no tag
+    const size_t index = m_tags.Find(setindex, tag);
+    return (index != m_tags.Count()) ? &m_lines[index] : NULL;
 }
 
 // Attempts to allocate a line for the specified address.
@@ -189,11 +171,11 @@ COMA::Cache::Line* COMA::Cache::AllocateLine(MemAddr address, bool empty_only, M
         else if (!empty_only)
         {
             // We're also considering non-empty lines; use LRU
-            assert(line.tag != tag);
+            assert(m_tags.Get(set + i) != tag);
             DeadlockWrite("New line, tag %#016llx: considering busy line %zu from set %zu, tag %#016llx, state %u, updating %u, access %llu",
                           (unsigned long long)tag,
                           i, setindex,
-                          (unsigned long long)line.tag, (unsigned)line.state, (unsigned)line.updating, (unsigned long long)line.access);
+                          (unsigned long long)m_tags.Get(set + i), (unsigned)line.state, (unsigned)line.updating, (unsigned long long)line.access);
             if (line.state != LINE_LOADING && line.updating == 0 && (replace == NULL || line.access < replace->access))
             {
                 // The line is available to be replaced and has a lower LRU rating,
@@ -214,15 +196,15 @@ bool COMA::Cache::EvictLine(Line* line, const Request& req)
     assert(line->state != LINE_LOADING);
     assert(line->updating == 0);
 
-    size_t setindex = (line - &m_lines[0]) / m_assoc;
-    MemAddr address = m_selector.Unmap(line->tag, setindex) * m_lineSize;
+    const size_t index = line - &m_lines[0];
+    MemAddr address = m_selector.Unmap(m_tags.Get(index), index / m_assoc) * m_lineSize;
     
     TraceWrite(address, "Evicting with %u tokens due to miss for address %#016llx", line->tokens, (unsigned long long)req.address);
     
     Message* msg = NULL;
     COMMIT
     {
-        msg = new Message;
+        msg = new (m_messages) Message;
         msg->type      = Message::EVICTION;
         msg->address   = address;
         msg->ignore    = false;
@@ -254,10 +236,35 @@ bool COMA::Cache::EvictLine(Line* line, const Request& req)
         }
     }
     
-    COMMIT{ line->state = LINE_EMPTY; }
+    COMMIT
+    {
+        line->state = LINE_EMPTY;
+        m_tags.Clear(index);
+    }
     return true;
 }
 
+// Messages that should be ignored and read responses that have not
+// reached their origin yet are forwarded as they are
+bool COMA::Cache::IsPassThrough(const Message& msg) const
+{
+    return msg.ignore || (msg.type == Message::REQUEST_DATA_TOKEN && msg.sender != m_id);
+}
+
+// Pending requests from the clients compete with forwarded messages
+// for the lines and the outgoing buffer
+bool COMA::Cache::CanExpress(const Message& msg) const
+{
+    return m_requests.Empty() && IsPassThrough(msg);
+}
+
+// A message that went past on the express path was received and ignored
+void COMA::Cache::OnMessageExpressed()
+{
+    ++m_numReceivedMessages;
+    ++m_numIgnoredMessages;
+}
+
 // Called when a message has been received from the previous node in the chain
 bool COMA::Cache::OnMessageReceived(Message* msg)
 {
@@ -271,7 +278,7 @@ bool COMA::Cache::OnMessageReceived(Message* msg)
         return false;
     }
     
-    if (msg->ignore || (msg->type == Message::REQUEST_DATA_TOKEN && msg->sender != m_id))
+    if (IsPassThrough(*msg))
     {
         // This is either
         // * a message that should ignored, or
@@ -444,7 +451,7 @@ bool COMA::Cache::OnMessageReceived(Message* msg)
                 COMMIT
                 {
                     line->state    = LINE_FULL;
-                    line->tag      = tag;
+                    m_tags.Set(line - &m_lines[0], tag);
                     line->tokens   = msg->tokens;
                     line->dirty    = msg->dirty;
                     line->updating = 0;
@@ -569,7 +576,9 @@ bool COMA::Cache::OnReadCompleted(MemAddr addr, const char * data)
 // SUCCESS - advance
 Result COMA::Cache::OnWriteRequest(const Request& req)
 {
-    if (!p_lines.Invoke())
+    // p_In has priority for the lines, also when it would be receiving
+    // a message on the express path
+    if (!p_lines.Invoke() || (!IsAcquiring() && IsReceivingExpress()))
     {
         DeadlockWrite("Lines busy, cannot process bus write request");
         return FAILED;
@@ -593,7 +602,7 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         {
             // We're overwriting another line, evict the old line
             TraceWrite(req.address, "Processing Bus Write Request: Miss; Evicting line with tag %#016llx",
-                       (unsigned long long)line->tag);
+                       (unsigned long long)m_tags.Get(line - &m_lines[0]));
 
             if (!EvictLine(line, req))
             {
@@ -612,7 +621,7 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         COMMIT
         {
             line->state    = LINE_LOADING;
-            line->tag      = tag;
+            m_tags.Set(line - &m_lines[0], tag);
             line->tokens   = 0;
             line->dirty    = false;
             line->updating = 0;
@@ -623,7 +632,7 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         Message* msg = NULL;
         COMMIT
         {
-            msg = new Message;
+            msg = new (m_messages) Message;
             msg->type      = Message::REQUEST;
             msg->address   = req.address;
             msg->ignore    = false;
@@ -640,7 +649,12 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         }
 
         // Statistics
-        COMMIT { ++m_numWLoads; }
+        COMMIT {
+            ++m_numWLoads;
+
+            if (m_classifier != NULL)
+                m_classifier->Miss(req.address);
+        }
         
         // Now try against next cycle
         return DELAYED;
@@ -671,7 +685,7 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         Message* msg = NULL;
         COMMIT
         {
-            msg = new Message;
+            msg = new (m_messages) Message;
             msg->address   = req.address;
             msg->type      = Message::UPDATE;
             msg->sender    = m_id;
@@ -713,6 +727,9 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
         
         // Also update last access time.
         line->access = GetKernel()->GetCycleNo();                    
+
+        if (m_classifier != NULL)
+            m_classifier->Hit(req.address);
     }
     return SUCCESS;
 }
@@ -723,7 +740,9 @@ Result COMA::Cache::OnWriteRequest(const Request& req)
 // SUCCESS - advance
 Result COMA::Cache::OnReadRequest(const Request& req)
 {
-    if (!p_lines.Invoke())
+    // p_In has priority for the lines, also when it would be receiving
+    // a message on the express path
+    if (!p_lines.Invoke() || (!IsAcquiring() && IsReceivingExpress()))
     {
         DeadlockWrite("Lines busy, cannot process bus read request");
         return FAILED;
@@ -747,7 +766,7 @@ Result COMA::Cache::OnReadRequest(const Request& req)
         {
             // We're overwriting another line, evict the old line
             TraceWrite(req.address, "Processing Bus Read Request: Miss; Evicting line with tag %#016llx",
-                       (unsigned long long)line->tag);
+                       (unsigned long long)m_tags.Get(line - &m_lines[0]));
             
             if (!EvictLine(line, req))
             {
@@ -766,7 +785,7 @@ Result COMA::Cache::OnReadRequest(const Request& req)
         COMMIT
         {
             line->state    = LINE_LOADING;
-            line->tag      = tag;
+            m_tags.Set(line - &m_lines[0], tag);
             line->tokens   = 0;
             line->dirty    = false;
             line->updating = 0;
@@ -778,7 +797,7 @@ Result COMA::Cache::OnReadRequest(const Request& req)
         Message* msg = NULL;
         COMMIT
         {
-            msg = new Message;
+            msg = new (m_messages) Message;
             msg->type      = Message::REQUEST;
             msg->address   = req.address;
             msg->ignore    = false;
@@ -794,7 +813,12 @@ Result COMA::Cache::OnReadRequest(const Request& req)
         }
         
         // Statistics
-        COMMIT { ++m_numRLoads; }
+        COMMIT {
+            ++m_numRLoads;
+
+            if (m_classifier != NULL)
+                m_classifier->Miss(req.address);
+        }
 
     }
     // Read hit
@@ -814,6 +838,9 @@ Result COMA::Cache::OnReadRequest(const Request& req)
             line->access = GetKernel()->GetCycleNo();
             
             ++m_numRFullHits;
+
+            if (m_classifier != NULL)
+                m_classifier->Hit(req.address);
         }
 
         if (!OnReadCompleted(req.address, data))
@@ -833,7 +860,12 @@ Result COMA::Cache::OnReadRequest(const Request& req)
         assert(line->state == LINE_LOADING);
         
         // Counts as a miss because we have to wait
-        COMMIT{ ++m_numLoadingRMisses; }
+        COMMIT{
+            ++m_numLoadingRMisses;
+
+            if (m_classifier != NULL)
+                m_classifier->Hit(req.address);
+        }
     }
     return SUCCESS;
 }
@@ -916,6 +948,7 @@ COMA::Cache::Cache(const std::string& name, COMA& parent, Clock& clock, CacheID
     m_numWCompletions(0),
     m_numNetworkWHits(0),
     m_numStallingWSnoops(0),
+    m_classifier(NULL),
 
     p_Requests (*this, "requests", delegate::create<Cache, &Cache::DoRequests>(*this)),
     p_In       (*this, "incoming", delegate::create<Cache, &Cache::DoReceive>(*this)),
@@ -959,12 +992,20 @@ COMA::Cache::Cache(const std::string& name, COMA& parent, Clock& clock, CacheID
 
     // Create the cache lines
     m_lines.resize(m_assoc * m_sets);
+    m_tags.Resize(m_sets, m_assoc);
     m_data.resize(m_lines.size() * m_lineSize);
+    m_valid = new bool[m_lines.size() * m_lineSize];
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
         Line& line = m_lines[i];
         line.state = LINE_EMPTY;
         line.data  = &m_data[i * m_lineSize];
+        line.valid = &m_valid[i * m_lineSize];
+    }
+
+    if (config.getValueOrDefault<bool>(*this, "ClassifyMisses", false))
+    {
+        m_classifier = new MissClassifier(*this, m_lines.size());
     }
 
     m_requests.Sensitive(p_Requests);   
@@ -983,6 +1024,12 @@ COMA::Cache::Cache(const std::string& name, COMA& parent, Clock& clock, CacheID
     config.registerProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 }
 
+COMA::Cache::~Cache()
+{
+    delete[] m_valid;
+    delete m_classifier;
+}
+
 void COMA::Cache::Cmd_Info(std::ostream& out, const std::vector<std::string>& /*args*/) const
 {
     out <<
@@ -1110,6 +1157,11 @@ void COMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>& ar
                 << "(percentages relative to " << m_numWAccesses << " write requests)" << endl
                 << endl;
 
+            if (m_classifier != NULL)
+            {
+                m_classifier->Print(out);
+            }
+
             float m_factor = 100.f / numMessages;                
             out << "***********************************************************" << endl
                 << "                   Messages to upstream                    " << endl
@@ -1238,7 +1290,7 @@ void COMA::Cache::Cmd_Read(std::ostream& out, const std::vector<std::string>& ar
         {
             const size_t set = i / m_assoc;
             const Line& line = m_lines[i];
-            MemAddr lineaddr = m_selector.Unmap(line.tag, set) * m_lineSize;
+            MemAddr lineaddr = m_selector.Unmap(m_tags.Get(i), set) * m_lineSize;
             if (specific && lineaddr != seladdr)
                 continue;
             
@@ -4,6 +4,8 @@
 #include "Node.h"
 #include "sim/inspect.h"
 #include "arch/BankSelector.h"
+#include "arch/CacheTags.h"
+#include "arch/MissClassifier.h"
 #include <queue>
 #include <set>
 
@@ -25,13 +27,12 @@ public:
     struct Line
     {
         LineState    state;     ///< State of the line
-        MemAddr      tag;       ///< Tag of the line
         char*        data;      ///< Data of the line
+        bool*        valid;     ///< Validity bitmask
         CycleNo      access;    ///< Last access time (for LRU replacement)
         unsigned int tokens;    ///< Number of tokens in this line
         bool         dirty;     ///< Dirty: line has been written to
         unsigned int updating;  ///< Number of REQUEST_UPDATEs pending on this line
-        bool         valid[MAX_MEMORY_OPERATION_SIZE]; ///< Validity bitmask
     };
 
 private:    
@@ -52,7 +53,9 @@ private:
     StorageTraceSet               m_storages;
     ArbitratedService<>           p_lines;
     std::vector<Line>             m_lines;
+    CacheTags                     m_tags;
     std::vector<char>             m_data;
+    bool*                         m_valid;
     
     // Statistics
 
@@ -97,6 +100,8 @@ private:
     uint64_t                      m_numWCompletions;
     uint64_t                      m_numNetworkWHits;
     uint64_t                      m_numStallingWSnoops;
+
+    MissClassifier*               m_classifier;  ///< Compulsory, capacity and conflict misses; when ClassifyMisses is set
    
     // Processes
     Process p_Requests;
@@ -119,9 +124,13 @@ private:
     Result OnReadRequest(const Request& req);
     Result OnWriteRequest(const Request& req);
     bool OnMessageReceived(Message* msg);
+    bool IsPassThrough(const Message& msg) const;
+    bool CanExpress(const Message& msg) const;
+    void OnMessageExpressed();
     bool OnReadCompleted(MemAddr addr, const char * data);
 public:
     Cache(const std::string& name, COMA& parent, Clock& clock, CacheID id, Config& config);
+    ~Cache();
     
     size_t GetLineSize() const { return m_lineSize; }
     size_t GetNumSets() const { return m_sets; }
@@ -39,18 +39,9 @@ COMA::Directory::Line* COMA::Directory::FindLine(MemAddr address)
     MemAddr tag;
     size_t setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
-    {
-        Line* line = &m_lines[set + i];
-        if (line->valid && line->tag == tag)
-        {
-            return line;
-        }
-    }
-    return NULL;
+    const size_t index = m_index.Find(setindex, tag);
+    return (index < m_index.Count()) ? &m_lines[index] : NULL;
 }
 
 // Performs a lookup in this directory's table to see whether
@@ -60,18 +51,9 @@ const COMA::Directory::Line* COMA::Directory::FindLine(MemAddr address) const
     MemAddr tag;
     size_t setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
-    {
-        const Line* line = &m_lines[set + i];
-        if (line->valid && line->tag == tag)
-        {
-            return line;
-        }
-    }
-    return NULL;
+    const size_t index = m_index.Find(setindex, tag);
+    return (index < m_index.Count()) ? &m_lines[index] : NULL;
 }
 
 // Marks the specified address as present in the directory
@@ -93,6 +75,7 @@ COMA::Directory::Line* COMA::Directory::AllocateLine(MemAddr address)
                 line->valid  = true;
                 line->tag    = tag;
                 line->tokens = 0;
+                m_index.Insert(set + i, tag);
             }
             return line;
         }
@@ -136,6 +119,7 @@ bool COMA::Directory::OnMessageReceivedBottom(Message* msg)
                 {
                     // No more tokens left; clear the line too
                     line->valid = false;
+                    m_index.Erase(line - &m_lines[0], line->tag);
                 }
             }
             break;
@@ -285,6 +269,7 @@ COMA::Directory::Directory(const std::string& name, COMA& parent, Clock& clock,
         Line& line = m_lines[i];
         line.valid = false;
     }
+    m_index.Resize(m_sets, m_assoc);
 
     m_bottom.m_incoming.Sensitive(p_InBottom);
     m_top.m_incoming.Sensitive(p_InTop);
@@ -4,6 +4,7 @@
 #include "Node.h"
 #include "sim/inspect.h"
 #include "arch/BankSelector.h"
+#include "arch/CacheTagIndex.h"
 #include <queue>
 #include <set>
 
@@ -54,6 +55,7 @@ private:
     IBankSelector&      m_selector;
     ArbitratedService<CyclicArbitratedPort> p_lines;      ///< Arbitrator for access to the lines
     std::vector<Line>   m_lines;      ///< The cache lines
+    CacheTagIndex       m_index;      ///< Index of the valid lines
     size_t              m_lineSize;   ///< The size of a cache-line
     size_t              m_assoc;      ///< Number of lines in a set
     size_t              m_sets;       ///< Number of sets
@@ -8,51 +8,23 @@ using namespace std;
 namespace Simulator
 {
 
-// Memory management data
-/*static*/ unsigned long                   COMA::Node::g_References   = 0;
-/*static*/ COMA::Node::Message*            COMA::Node::g_FreeMessages = NULL;
-/*static*/ std::list<COMA::Node::Message*> COMA::Node::g_Messages;
-
-/*static*/ void* COMA::Node::Message::operator new(size_t size)
+/*static*/ void* COMA::Node::Message::operator new(size_t size, MessagePool<Message>& pool)
 {
-    // We allocate this many messages at once
-    static const size_t ALLOCATE_SIZE = 1024;
-    
     assert(size == sizeof(Message));
-    if (g_FreeMessages == NULL)
-    {
-        // Allocate more messages
-        Message* msg = new Message[ALLOCATE_SIZE];
-        g_Messages.push_back(msg);
-        
-        // Link the new messages into the free list
-        for (size_t i = 0; i < ALLOCATE_SIZE; ++i, ++msg)
-        {
-            msg->next = g_FreeMessages;
-            g_FreeMessages = msg;
-        }
-    }
-    assert(g_FreeMessages != NULL);
-    
-    // Grab a message off the free list
-    Message* msg = g_FreeMessages;
-    g_FreeMessages = msg->next;
-    return msg;
+    return pool.Allocate();
 }
 
-/*static*/ void COMA::Node::Message::operator delete(void *p, size_t size)
+/*static*/ void COMA::Node::Message::operator delete(void *p, MessagePool<Message>& /*pool*/)
 {
-    assert(size == sizeof(Message));
-    Message* msg = static_cast<Message*>(p);
-
-#ifndef NDEBUG
-    // Fill the message with garbage
-    memset(msg, 0xFE, sizeof(Message));
-#endif
+    MessagePool<Message>::Release(p);
+}
 
-    // Append the message to the free list
-    msg->next = g_FreeMessages;
-    g_FreeMessages = msg;
+/*static*/ void COMA::Node::Message::operator delete(void *p)
+{
+    if (p != NULL)
+    {
+        MessagePool<Message>::Release(p);
+    }
 }
 
 /*static*/ void COMA::Node::PrintMessage(std::ostream& out, const Message& msg)
@@ -119,7 +91,61 @@ void COMA::Node::Initialize(Node* next, Node* prev)
 {
     m_prev = prev;
     m_next = next;
-    p_Forward.SetStorageTraces(next->m_incoming);
+    p_Forward.SetStorageTraces(next->m_incoming ^ m_expressed);
+}
+
+void COMA::Node::InitializeExpress()
+{
+    // An expressed message is delivered to one of the nodes after the
+    // next one, up to the maximum number of hops. When a node that it
+    // passes gets busy, the message is put where it would be hop by hop:
+    // in the outgoing buffer of that node or the incoming buffer of the
+    // node after it.
+    StorageTraceSet sts;
+    Node* node = m_next;
+    for (size_t i = 0; i < m_expressHops && node->m_next != this; ++i)
+    {
+        sts ^= node->m_outgoing;
+        node = node->m_next;
+        sts ^= node->m_incoming;
+    }
+    p_Express.SetStorageTraces(opt(sts));
+}
+
+int COMA::Node::GetExpressStage() const
+{
+    const CycleNo now = GetClock().GetCycleNo();
+    if (now < m_expressIn || now > m_expressUntil)
+    {
+        return -1;
+    }
+    return (int)(now - m_expressIn);
+}
+
+bool COMA::Node::CanPass(const Message& msg) const
+{
+    return m_incoming.Empty() && m_outgoing.Empty() && CanExpress(msg);
+}
+
+COMA::Node* COMA::Node::GetExpressDestination(const Message& msg, size_t& hops) const
+{
+    // A node can be passed if it does nothing but forward the message,
+    // and it has nothing else to forward. With a message ahead of this
+    // one, or when the node's own work competes for the outgoing
+    // buffer, the timing depends on the node, so we go hop by hop.
+    // The nodes on the way, and the destination, are reserved for the
+    // message until it arrives, so they may not be on the way of
+    // another message on the express path.
+    const CycleNo now = GetClock().GetCycleNo();
+    Node* dest = m_next;
+    hops = 0;
+    while (hops < m_expressHops && dest->m_next != this &&
+           dest->CanPass(msg) && now > dest->m_expressUntil && now > dest->m_next->m_expressUntil)
+    {
+        dest = dest->m_next;
+        ++hops;
+    }
+    return (hops > 0) ? dest : NULL;
 }
 
 Result COMA::Node::DoForward()
@@ -128,7 +154,44 @@ Result COMA::Node::DoForward()
     assert(!m_outgoing.Empty());
     assert(m_next != NULL);
     
-    if (!m_next->m_incoming.Push( m_outgoing.Front() ))
+    Message* msg = m_outgoing.Front();
+    if (m_expressHops > 0)
+    {
+        size_t hops;
+        Node*  dest = GetExpressDestination(*msg, hops);
+        if (dest != NULL)
+        {
+            ExpressMessage em;
+            em.msg  = msg;
+            em.dest = dest;
+            em.sent = GetClock().GetCycleNo();
+            em.hops = hops;
+            if (!m_expressed.Push(em))
+            {
+                DeadlockWrite("Unable to send request on the express path");
+                return FAILED;
+            }
+            m_outgoing.Pop();
+            COMMIT
+            {
+                // Every node that is passed takes a cycle to receive the
+                // message and a cycle to forward it.
+                Node* node = m_next;
+                for (size_t i = 0; i <= hops; ++i, node = node->m_next)
+                {
+                    node->m_expressIn    = em.sent + 2 * i;
+                    node->m_expressUntil = em.sent + 2 * hops;
+                }
+                ++m_numExpressed;
+            }
+            return SUCCESS;
+        }
+    }
+
+    // Hop by hop, a message on the express path would be pushed into
+    // the next node in this cycle, or occupy its incoming buffer
+    const int stage = m_next->GetExpressStage();
+    if (stage == 0 || !m_next->m_incoming.Push(msg, (stage == 1) ? 2 : 1))
     {
         DeadlockWrite("Unable to send request to next node (%s)", m_next->GetFQN().c_str());
         return FAILED;
@@ -137,10 +200,97 @@ Result COMA::Node::DoForward()
     return SUCCESS;
 }
 
+Result COMA::Node::DoExpress()
+{
+    assert(!m_expressed.Empty());
+    const ExpressMessage& em   = m_expressed.Front();
+    const CycleNo         step = GetClock().GetCycleNo() - em.sent;
+    assert(step > 0 && step <= 2 * em.hops);
+
+    // Follow the message as it would go hop by hop: the node it is at
+    // receives it on odd steps and forwards it on even steps. Before
+    // each step, we check that the node will not hold it up in the next
+    // step; otherwise it continues hop by hop from where it is.
+    Node* node = m_next;
+    for (CycleNo i = 1; i < (step + 1) / 2; ++i)
+    {
+        node = node->m_next;
+    }
+
+    if (step == 2 * em.hops)
+    {
+        // The last node that is passed forwards it to the destination
+        assert(node->m_next == em.dest);
+        if (!em.dest->m_incoming.Push(em.msg))
+        {
+            DeadlockWrite("Unable to send request on the express path to %s", em.dest->GetFQN().c_str());
+            return FAILED;
+        }
+        m_expressed.Pop();
+        return SUCCESS;
+    }
+
+    if (step % 2 == 1)
+    {
+        // The node receives the message and moves it to its outgoing buffer
+        COMMIT
+        {
+            node->OnMessageExpressed();
+            ++m_numExpressHops;
+        }
+
+        Buffer<Message*>& next = node->m_next->m_incoming;
+        if (node->m_incoming.Empty() && node->m_outgoing.Empty() && next.size() < next.GetMaxSize())
+        {
+            return SUCCESS;
+        }
+
+        if (!node->m_outgoing.Push(em.msg))
+        {
+            DeadlockWrite("Unable to stop express path at %s", node->GetFQN().c_str());
+            return FAILED;
+        }
+    }
+    else
+    {
+        // The node forwards the message to the next node
+        if (node->m_next->CanPass(*em.msg))
+        {
+            return SUCCESS;
+        }
+
+        if (!node->m_next->m_incoming.Push(em.msg))
+        {
+            DeadlockWrite("Unable to stop express path at %s", node->m_next->GetFQN().c_str());
+            return FAILED;
+        }
+    }
+
+    // The message continues hop by hop; release the nodes after this cycle
+    m_expressed.Pop();
+    COMMIT
+    {
+        const CycleNo now = GetClock().GetCycleNo();
+        for (Node* n = m_next; n != em.dest->m_next; n = n->m_next)
+        {
+            n->m_expressUntil = now;
+        }
+        ++m_numExpressStops;
+    }
+    return SUCCESS;
+}
+
 // Send a message to the next node.
 // Only succeeds if there's min_space left before the push.
 bool COMA::Node::SendMessage(Message* message, size_t min_space)
 {
+    // Hop by hop, a message on the express path that is being forwarded
+    // in this cycle would still take a place in the outgoing buffer
+    if (GetExpressStage() == 2)
+    {
+        ++min_space;
+    }
+
     if (!m_outgoing.Push(message, min_space))
     {
         return false;
@@ -155,25 +305,28 @@ COMA::Node::Node(const std::string& name, COMA& parent, Clock& clock, Config& co
       m_next(NULL),
       m_incoming("b_incoming", *this, clock, config.getValue<BufferSize>(*this, "NodeBufferSize")),
       m_outgoing("b_outgoing", *this, clock, config.getValue<BufferSize>(*this, "NodeBufferSize")),
-      p_Forward(*this, "forward", delegate::create<Node, &Node::DoForward>(*this))
+      m_expressed("b_expressed", *this, clock, 1),
+      m_expressHops(config.getValueOrDefault<size_t>(parent, "ExpressHops", 0)),
+      m_expressIn(1),
+      m_expressUntil(0),
+      m_numExpressed(0),
+      m_numExpressHops(0),
+      m_numExpressStops(0),
+      p_Forward(*this, "forward", delegate::create<Node, &Node::DoForward>(*this)),
+      p_Express(*this, "express", delegate::create<Node, &Node::DoExpress>(*this))
 {
-    g_References++;
-    
     m_outgoing.Sensitive(p_Forward);
+    m_expressed.Sensitive(p_Express);
+
+    RegisterSampleVariableInObjectWithName(m_messages.m_maxInUse, "maxmessages", SVC_WATERMARK);
+    RegisterSampleVariableInObjectWithName(m_messages.m_capacity, "messagecapacity", SVC_LEVEL);
+    RegisterSampleVariableInObjectWithName(m_numExpressed, "expressed", SVC_CUMULATIVE);
+    RegisterSampleVariableInObjectWithName(m_numExpressHops, "expresshops", SVC_CUMULATIVE);
+    RegisterSampleVariableInObjectWithName(m_numExpressStops, "expressstops", SVC_CUMULATIVE);
 }
 
 COMA::Node::~Node()
 {
-    assert(g_References > 0);
-    if (--g_References == 0)
-    {
-        // Clean up the allocated messages
-        for (std::list<Message*>::const_iterator p = g_Messages.begin(); p != g_Messages.end(); ++p)
-        {
-            delete[] *p;
-        }
-        g_Messages.clear();
-    }
 }
 
 }
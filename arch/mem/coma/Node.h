@@ -2,6 +2,7 @@
 #define COMA_NODE_H
 
 #include "COMA.h"
+#include "arch/mem/MessagePool.h"
 
 namespace Simulator
 {
@@ -56,23 +57,28 @@ protected:
             WClientID    wid;           ///< Sending entity on client (family/thread) (UP)
         };
         
-        /// For memory management
-        Message* next;
-
-        // Overload allocation for efficiency
-        static void * operator new (size_t size);
-        static void operator delete (void *p, size_t size);
+        // Messages are allocated from the pool of the sending node
+        static void * operator new (size_t size, MessagePool<Message>& pool);
+        static void operator delete (void *p, MessagePool<Message>& pool);
+        static void operator delete (void *p);
         
         Message() {}
     private:
         Message(const Message&) {} // No copying
     };
 
+    MessagePool<Message> m_messages;    ///< Messages sent by this node
+
 private:    
-    // Message management
-    static Message*            g_FreeMessages;
-    static std::list<Message*> g_Messages;
-    static unsigned long       g_References;
+    /// A message on the express path, i.e. one that is sent past the next
+    /// nodes of the ring directly to the first node that handles it.
+    struct ExpressMessage
+    {
+        Message* msg;   ///< The message
+        Node*    dest;  ///< The node whose incoming buffer receives the message
+        CycleNo  sent;  ///< The cycle at which the message was sent
+        size_t   hops;  ///< The number of nodes the message is sent past
+    };
 
     static void PrintMessage(std::ostream& out, const Message& msg);
 
@@ -82,12 +88,53 @@ protected:
     Buffer<Message*>  m_incoming;       ///< Buffer for incoming messages from the prev node
 private:
     Buffer<Message*>  m_outgoing;       ///< Buffer for outgoing messages to the next node
-   
+    Buffer<ExpressMessage> m_expressed; ///< The message this node sent on the express path
+    size_t            m_expressHops;    ///< Max. number of nodes a message can be sent past; 0 disables the express path
+    CycleNo           m_expressIn;      ///< Cycle at which the message on the express path enters this node
+    CycleNo           m_expressUntil;   ///< Last cycle at which this node is reserved for that message
+
+    // Statistics
+    uint64_t          m_numExpressed;   ///< Number of messages sent on the express path
+    uint64_t          m_numExpressHops; ///< Number of nodes that expressed messages were sent past
+    uint64_t          m_numExpressStops;///< Number of expressed messages that went on hop by hop
+
     /// Process for sending to the next node
     Process           p_Forward;
     Result            DoForward();
 
+    /// Process for delivering the messages on the express path
+    Process           p_Express;
+    Result            DoExpress();
+
+    /// Returns the node that receives the message when sending it on the
+    /// express path, and the number of nodes it passes, or NULL if it has
+    /// to go hop by hop.
+    Node* GetExpressDestination(const Message& msg, size_t& hops) const;
+
+    /// Would the node forward the message in the next cycle, with nothing
+    /// ahead of it?
+    bool CanPass(const Message& msg) const;
+
+    /// Returns how many cycles ago the message on the express path entered
+    /// this node, or -1 if the node is not reserved for one. Hop by hop,
+    /// the message would be pushed into the incoming buffer (0), moved to
+    /// the outgoing buffer (1) and forwarded (2).
+    int GetExpressStage() const;
+
 protected:
+    /// Can the express path send the message past this node? Only if the
+    /// node would forward it untouched, with nothing else of its own
+    /// competing for the outgoing buffer.
+    virtual bool CanExpress(const Message& /*msg*/) const { return false; }
+
+    /// Called when a message is sent past this node on the express path,
+    /// so that the node counts it as if it had forwarded it.
+    virtual void OnMessageExpressed() {}
+
+    /// Is a message on the express path received in this cycle? Hop by
+    /// hop, receiving it would take the lines of the node.
+    bool IsReceivingExpress() const { return GetExpressStage() == 1; }
+
     StorageTraceSet GetOutgoingTrace() const {
         return m_outgoing;
     }
@@ -107,6 +154,9 @@ protected:
 
 public:
     void Initialize(Node* next, Node* prev);
+
+    /// Set up the express path, once the whole ring is connected
+    void InitializeExpress();
 };
 
 }
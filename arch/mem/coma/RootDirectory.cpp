@@ -18,29 +18,33 @@ COMA::RootDirectory::Line* COMA::RootDirectory::FindLine(MemAddr address, bool c
     MemAddr tag;
     size_t setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    Line* empty = NULL;
-    for (size_t i = 0; i < m_assoc; ++i)
+    const size_t index = m_index.Find(setindex, tag);
+    if (index < m_index.Count())
     {
-        Line* line = &m_lines[set + i];
+        // The wanted line was in the cache
+        return &m_lines[index];
+    }
 
-        if (line->state == LINE_EMPTY)
-        {
-            // Empty, unused line, remember this one
-            empty = line;
-        }
-        else if (line->tag == tag)
+    if (check_only)
+    {
+        return NULL;
+    }
+
+    // Find the last empty, unused line in the set
+    const size_t set = setindex * m_assoc;
+    Line* empty = NULL;
+    for (size_t i = m_assoc; i > 0 && empty == NULL; --i)
+    {
+        if (m_lines[set + i - 1].state == LINE_EMPTY)
         {
-            // The wanted line was in the cache
-            return line;
+            empty = &m_lines[set + i - 1];
         }
     }
 
     // The line could not be found, allocate the empty line or replace an existing line
     Line* line = NULL;
-    if (!check_only && empty != NULL)
+    if (empty != NULL)
     {
         // Reset the line
         line = empty;
@@ -56,25 +60,31 @@ const COMA::RootDirectory::Line* COMA::RootDirectory::FindLine(MemAddr address)
     MemAddr tag;
     size_t setindex;
     m_selector.Map(address / m_lineSize, tag, setindex);
-    const size_t  set  = setindex * m_assoc;
 
-    // Find the line
-    for (size_t i = 0; i < m_assoc; ++i)
+    const size_t index = m_index.Find(setindex, tag);
+    return (index < m_index.Count()) ? &m_lines[index] : NULL;
+}
+
+bool COMA::RootDirectory::OnReadCompleted(MemAddr address)
+{
+    // The DDR channel may complete reads out of order;
+    // find the oldest message for the line
+    std::deque<Message*>::iterator p = m_active.begin();
+    for (; p != m_active.end(); ++p)
     {
-        const Line* line = &m_lines[set + i];
-        if (line->state != LINE_EMPTY && line->tag == tag)
+        MemAddr local;
+        m_parent.MapToRootDirectory((*p)->address, local);
+        if (local == address)
         {
-            return line;
+            break;
         }
     }
-    return NULL;
-}
-
-bool COMA::RootDirectory::OnReadCompleted()
-{
-    assert (!m_active.empty());
-    
-    Message* msg = m_active.front();
+    if (p == m_active.end())
+    {
+        throw exceptf<InvalidArgumentException>(*this, "DDR completed a read of %#016llx that was not requested",
+                                                (unsigned long long)address);
+    }
+    Message* msg = *p;
     COMMIT
     {
         msg->type = Message::REQUEST_DATA_TOKEN;
@@ -82,7 +92,7 @@ bool COMA::RootDirectory::OnReadCompleted()
         
         m_parent.Read(msg->address, msg->data.data, m_lineSize);
         
-        m_active.pop();
+        m_active.erase(p);
     }
     
     if (!m_responses.Push(msg))
@@ -98,15 +108,18 @@ bool COMA::RootDirectory::OnMessageReceived(Message* msg)
 {
     assert(msg != NULL);
     
-    if (((msg->address / m_lineSize) % m_numRoots) == m_id)
+    // We need to grab p_lines because it also arbitrates access to the
+    // outgoing ring buffer with p_Responses.
+    if (!p_lines.Invoke())
     {
-        // This message is for us
-        if (!p_lines.Invoke())
-        {
-            DeadlockWrite("Unable to acquire lines");
-            return false;
-        }
+        DeadlockWrite("Unable to acquire lines");
+        return false;
+    }
 
+    MemAddr local;
+    if (m_parent.MapToRootDirectory(msg->address, local) == m_id)
+    {
+        // This message is for us
         switch (msg->type)
         {
         case Message::REQUEST:
@@ -129,6 +142,7 @@ bool COMA::RootDirectory::OnMessageReceived(Message* msg)
                 {
                     line->state  = LINE_LOADING;
                     line->sender = msg->sender;
+                    m_index.Insert(line - &m_lines[0], line->tag);
                 }
                 return true;
             }
@@ -156,6 +170,7 @@ bool COMA::RootDirectory::OnMessageReceived(Message* msg)
                     msg->type   = Message::REQUEST_DATA_TOKEN;
                     msg->tokens = m_parent.GetTotalTokens();
                     line->state = LINE_FULL;
+                    m_index.Insert(line - &m_lines[0], line->tag);
                 }
             }
             else if (line->tokens > 0)
@@ -211,7 +226,11 @@ bool COMA::RootDirectory::OnMessageReceived(Message* msg)
                     TraceWrite(msg->address, "Received Evict Request; All tokens; Clearing line from system");
                     COMMIT{ delete msg; }
                 }            
-                COMMIT{ line->state = LINE_EMPTY; }
+                COMMIT
+                {
+                    line->state = LINE_EMPTY;
+                    m_index.Erase(line - &m_lines[0], line->tag);
+                }
             }
             return true;
         }
@@ -268,9 +287,10 @@ Result COMA::RootDirectory::DoRequests()
     }
     else
     {
-        // Since we stripe cache lines across root directories, adjust the 
+        // Since we stripe cache lines across root directories, adjust the
         // address before we send it to memory for timing.
-        unsigned int mem_address = (msg->address / m_lineSize) / m_numRoots * m_lineSize;
+        MemAddr mem_address;
+        m_parent.MapToRootDirectory(msg->address, mem_address);
         
         if (msg->type == Message::REQUEST)
         {
@@ -283,7 +303,7 @@ Result COMA::RootDirectory::DoRequests()
                         
             COMMIT{ 
                 ++m_nreads;
-                m_active.push(msg);
+                m_active.push_back(msg);
             }
 #else
             COMMIT
@@ -378,9 +398,10 @@ void COMA::RootDirectory::SetNumRings(size_t num_rings)
     {
         m_lines[i].state = LINE_EMPTY;
     }
+    m_index.Resize(m_sets, m_assoc);
 }
 
-COMA::RootDirectory::RootDirectory(const std::string& name, COMA& parent, Clock& clock, size_t id, size_t numRoots, const DDRChannelRegistry& ddr, Config& config) :
+COMA::RootDirectory::RootDirectory(const std::string& name, COMA& parent, Clock& clock, size_t id, const DDRChannelRegistry& ddr, Config& config) :
     Simulator::Object(name, parent),
     DirectoryBottom(name, parent, clock, config),
     m_selector (parent.GetBankSelector()),
@@ -388,7 +409,6 @@ COMA::RootDirectory::RootDirectory(const std::string& name, COMA& parent, Clock&
     m_assoc_ring(config.getValue<size_t>(parent, "L2CacheAssociativity") * config.getValue<size_t>(parent, "NumL2CachesPerRing")),
     m_sets     (m_selector.GetNumBanks()),
     m_id       (id),
-    m_numRoots (numRoots),
     p_lines    (*this, clock, "p_lines"),    
     m_requests ("b_requests", *this, clock, config.getValue<size_t>(*this, "ExternalOutputQueueSize")),
     m_responses("b_responses", *this, clock, config.getValue<size_t>(*this, "ExternalInputQueueSize")),
@@ -400,6 +420,9 @@ COMA::RootDirectory::RootDirectory(const std::string& name, COMA& parent, Clock&
 {
     assert(m_lineSize <= MAX_MEMORY_OPERATION_SIZE);
 
+    RegisterSampleVariableInObject(m_nreads, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nwrites, SVC_CUMULATIVE);
+
     config.registerObject(*this, "rootdir");
     config.registerProperty(*this, "freq", (uint32_t)clock.GetFrequency());
     
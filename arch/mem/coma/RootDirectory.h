@@ -3,7 +3,7 @@
 
 #include "Directory.h"
 #include "mem/DDR.h"
-#include <queue>
+#include <deque>
 #include <set>
 
 class Config;
@@ -34,20 +34,20 @@ public:
 private:    
     IBankSelector&    m_selector;   ///< Mapping of cache line addresses to sets/banks
     std::vector<Line> m_lines;      ///< The cache lines
+    CacheTagIndex     m_index;      ///< Index of the lines that are not empty
     size_t            m_lineSize;   ///< The size of a cache-line
     size_t            m_assoc_ring; ///< Number of lines in a set in a directory
     size_t            m_assoc;      ///< Number of lines in a set
     size_t            m_sets;       ///< Number of sets
     size_t            m_numCaches;  ///< Number of caches in the COMA system
-    size_t            m_id;         ///< Which root directory we are (0 <= m_id < m_numRoots)
-    size_t            m_numRoots;   ///< Number of root directories on the top-level ring
+    size_t            m_id;         ///< Which root directory we are (0 <= m_id < number of root directories)
 
     ArbitratedService<CyclicArbitratedPort> p_lines;      ///< Arbitrator for lines and output
     
     DDRChannel*       m_memory;    ///< DDR memory channel
     Buffer<Message*>  m_requests;  ///< Requests to memory
     Buffer<Message*>  m_responses; ///< Responses from memory
-    std::queue<Message*> m_active;  ///< Messages active in DDR
+    std::deque<Message*> m_active;  ///< Messages active in DDR
     
     // Processes
     Process p_Incoming;
@@ -56,7 +56,7 @@ private:
     
     Line* FindLine(MemAddr address, bool check_only);
     bool  OnMessageReceived(Message* msg);
-    bool  OnReadCompleted();
+    bool  OnReadCompleted(MemAddr address);
     
     // Processes
     Result DoIncoming();
@@ -68,7 +68,7 @@ private:
     uint64_t          m_nwrites;
     
 public:
-    RootDirectory(const std::string& name, COMA& parent, Clock& clock, size_t id, size_t numRoots, const DDRChannelRegistry& ddr, Config& config);
+    RootDirectory(const std::string& name, COMA& parent, Clock& clock, size_t id, const DDRChannelRegistry& ddr, Config& config);
     
     // Updates the internal data structures to accomodate a system with N directories
     void SetNumRings(size_t num_rings);
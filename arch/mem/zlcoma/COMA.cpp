@@ -133,6 +133,10 @@ ZLCOMA::ZLCOMA(const std::string& name, Simulator::Object& parent, Clock& clock,
     m_selector(IBankSelector::makeSelector(*this,
                                            config.getValueOrDefault<string>(*this, "BankSelector", "XORFOLD"),
                                            config.getValue<size_t>(*this, "L2CacheNumSets"))),
+    m_rootSelector(IBankSelector::makeSelector(*this,
+                                               config.getValueOrDefault<string>(*this, "RootDirectorySelector", "DIRECT"),
+                                               config.getValue<size_t>(*this, "NumRootDirectories"))),
+    m_rootInterleaving(config.getValueOrDefault<size_t>(*this, "RootDirectoryInterleaving", m_lineSize)),
     m_ddr("ddr", *this, config, config.getValue<size_t>(*this, "NumRootDirectories")),
     m_nreads(0), m_nwrites(0), m_nread_bytes(0), m_nwrite_bytes(0)
 {
@@ -148,12 +152,16 @@ ZLCOMA::ZLCOMA(const std::string& name, Simulator::Object& parent, Clock& clock,
     {
         throw InvalidArgumentException(*this, "NumRootDirectories is not a power of two");
     }
+    if (!IsPowerOfTwo(m_rootInterleaving) || m_rootInterleaving < m_lineSize)
+    {
+        throw exceptf<InvalidArgumentException>(*this, "RootDirectoryInterleaving is not a power of two multiple of the line size: %zu", m_rootInterleaving);
+    }
 
     for (size_t i = 0; i < m_roots.size(); ++i)
     {
         stringstream name;
         name << "rootdir" << i;
-        m_roots[i] = new RootDirectory(name.str(), *this, clock, i, m_roots.size(), m_ddr, config);
+        m_roots[i] = new RootDirectory(name.str(), *this, clock, i, m_ddr, config);
     }
 
 }
@@ -162,6 +170,8 @@ void ZLCOMA::Initialize()
 {
     m_config.registerObject(*this, "coma");
     m_config.registerProperty(*this, "selector", m_selector->GetName());
+    m_config.registerProperty(*this, "rootselector", m_rootSelector->GetName());
+    m_config.registerProperty(*this, "rootinterleaving", (uint32_t)m_rootInterleaving);
 
     // Initialize the caches
     for (size_t i = 0; i < m_caches.size(); ++i)
@@ -242,6 +252,7 @@ ZLCOMA::~ZLCOMA()
     }
 
     delete m_selector;
+    delete m_rootSelector;
 }
 
 void ZLCOMA::GetMemoryStatistics(uint64_t& nreads, uint64_t& nwrites, uint64_t& nread_bytes, uint64_t& nwrite_bytes, uint64_t& nreads_ext, uint64_t& nwrites_ext) const
@@ -273,6 +284,8 @@ void ZLCOMA::Cmd_Info(ostream& out, const vector<string>& arguments) const
     "to off-chip storage.\n"
     "\n"
     "This memory uses the following mapping of lines to cache sets(banks): " << m_selector->GetName() <<
+    "\n"
+    "and the following mapping of " << m_rootInterleaving << "-byte blocks to root directories: " << m_rootSelector->GetName() <<
     "\n\n"
     "Supported operations:\n"
     "- info <component> ranges\n"
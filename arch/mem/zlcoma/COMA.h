@@ -57,6 +57,8 @@ private:
     size_t                      m_lineSize;
     Config&                     m_config;
     IBankSelector*              m_selector;           ///< Mapping of line addresses to set indexes
+    IBankSelector*              m_rootSelector;       ///< Mapping of interleaving units to root directories
+    size_t                      m_rootInterleaving;   ///< Size of the interleaving unit, in bytes
     std::vector<Cache*>         m_caches;             ///< List of caches
     std::vector<Directory*>     m_directories;        ///< List of directories
     std::vector<RootDirectory*> m_roots;              ///< List of root directories
@@ -83,6 +85,12 @@ public:
     const TraceMap& GetTraces() const { return m_traces; }
 
     IBankSelector& GetBankSelector() const { return *m_selector; }
+
+    /// Returns the root directory that owns the line at the address, and
+    /// the address of the line in the DDR channel of that root directory
+    size_t MapToRootDirectory(MemAddr address, MemAddr& local) const {
+        return m_rootSelector->MapInterleaved(address, m_rootInterleaving, local);
+    }
     
     // IMemory
     MCID RegisterClient(IMemoryCallback& callback, Process& process, StorageTraceSet& traces, Storage& storage, bool grouped);
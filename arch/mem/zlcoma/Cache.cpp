@@ -297,7 +297,7 @@ bool ZLCOMA::Cache::EvictLine(Line* line, const Request& req)
     size_t  set     = (line - &m_lines[0]) / m_assoc;
     MemAddr address = m_selector.Unmap(line->tag, set) * m_lineSize;
      
-    Message* msg = new Message();
+    Message* msg = new (m_messages) Message();
     COMMIT
     {
         msg->transient = false;
@@ -430,7 +430,7 @@ Result ZLCOMA::Cache::OnReadRequest(const Request& req)
     Message* msg = NULL;
     COMMIT
     {
-        msg = new Message();
+        msg = new (m_messages) Message();
         msg->type      = Message::READ;
         msg->address   = req.address;
         msg->ignore    = false;
@@ -555,7 +555,7 @@ Result ZLCOMA::Cache::OnWriteRequest(const Request& req)
     Message* msg = NULL;
     COMMIT
     {
-        msg = new Message();
+        msg = new (m_messages) Message();
         msg->type      = Message::ACQUIRE_TOKENS;
         msg->address   = req.address;
         msg->ignore    = false;
@@ -705,7 +705,7 @@ Result ZLCOMA::Cache::OnAcquireTokensRem(Message* req)
             Message *reqnotify = NULL;
             COMMIT
             {
-                reqnotify = new Message();
+                reqnotify = new (m_messages) Message();
                 reqnotify->type    = Message::LOCALDIR_NOTIFICATION;
                 reqnotify->address = req->address;
                 reqnotify->ignore  = false;
@@ -798,7 +798,7 @@ Result ZLCOMA::Cache::OnAcquireTokensRet(Message* req)
             Message *reqnotify = NULL;
             COMMIT
             {
-                reqnotify = new Message();
+                reqnotify = new (m_messages) Message();
                 reqnotify->type    = Message::LOCALDIR_NOTIFICATION;
                 reqnotify->address = req->address;
                 reqnotify->ignore  = false;
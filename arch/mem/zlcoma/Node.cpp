@@ -7,51 +7,23 @@ using namespace std;
 namespace Simulator
 {
 
-// Memory management data
-/*static*/ unsigned long                     ZLCOMA::Node::g_References   = 0;
-/*static*/ ZLCOMA::Node::Message*            ZLCOMA::Node::g_FreeMessages = NULL;
-/*static*/ std::list<ZLCOMA::Node::Message*> ZLCOMA::Node::g_Messages;
-
-/*static*/ void* ZLCOMA::Node::Message::operator new(size_t size)
+/*static*/ void* ZLCOMA::Node::Message::operator new(size_t size, MessagePool<Message>& pool)
 {
-    // We allocate this many messages at once
-    static const size_t ALLOCATE_SIZE = 1024;
-    
     assert(size == sizeof(Message));
-    if (g_FreeMessages == NULL)
-    {
-        // Allocate more messages
-        Message* msg = new Message[ALLOCATE_SIZE];
-        g_Messages.push_back(msg);
-        
-        // Link the new messages into the free list
-        for (size_t i = 0; i < ALLOCATE_SIZE; ++i, ++msg)
-        {
-            msg->next = g_FreeMessages;
-            g_FreeMessages = msg;
-        }
-    }
-    assert(g_FreeMessages != NULL);
-    
-    // Grab a message off the free list
-    Message* msg = g_FreeMessages;
-    g_FreeMessages = msg->next;
-    return msg;
+    return pool.Allocate();
 }
 
-/*static*/ void ZLCOMA::Node::Message::operator delete(void *p, size_t size)
+/*static*/ void ZLCOMA::Node::Message::operator delete(void *p, MessagePool<Message>& /*pool*/)
 {
-    assert(size == sizeof(Message));
-    Message* msg = static_cast<Message*>(p);
-
-#ifndef NDEBUG
-    // Fill the message with garbage
-    memset(msg, 0xFE, sizeof(Message));
-#endif
+    MessagePool<Message>::Release(p);
+}
 
-    // Append the message to the free list
-    msg->next = g_FreeMessages;
-    g_FreeMessages = msg;
+/*static*/ void ZLCOMA::Node::Message::operator delete(void *p)
+{
+    if (p != NULL)
+    {
+        MessagePool<Message>::Release(p);
+    }
 }
 
 /*static*/ void ZLCOMA::Node::PrintMessage(std::ostream& out, const Message& msg)
@@ -139,23 +111,14 @@ ZLCOMA::Node::Node(const std::string& name, ZLCOMA& parent, Clock& clock)
       m_outgoing("b_outgoing", *this, clock, 2),
       p_Forward(*this, "forward", delegate::create<Node, &Node::DoForward>(*this))
 {
-    g_References++;
-    
     m_outgoing.Sensitive(p_Forward);
+
+    RegisterSampleVariableInObjectWithName(m_messages.m_maxInUse, "maxmessages", SVC_WATERMARK);
+    RegisterSampleVariableInObjectWithName(m_messages.m_capacity, "messagecapacity", SVC_LEVEL);
 }
 
 ZLCOMA::Node::~Node()
 {
-    assert(g_References > 0);
-    if (--g_References == 0)
-    {
-        // Clean up the allocated messages
-        for (std::list<Message*>::const_iterator p = g_Messages.begin(); p != g_Messages.end(); ++p)
-        {
-            delete[] *p;
-        }
-        g_Messages.clear();
-    }
 }
 
 }
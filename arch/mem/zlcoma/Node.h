@@ -2,6 +2,7 @@
 #define ZLCOMA_NODE_H
 
 #include "COMA.h"
+#include "arch/mem/MessagePool.h"
 
 namespace Simulator
 {
@@ -80,24 +81,19 @@ protected:
             return transient ? 0 : tokens;
         }
 
-        /// For memory management
-        Message* next;
-
-        // Overload allocation for efficiency
-        static void * operator new (size_t size);
-        static void operator delete (void *p, size_t size);
+        // Messages are allocated from the pool of the sending node
+        static void * operator new (size_t size, MessagePool<Message>& pool);
+        static void operator delete (void *p, MessagePool<Message>& pool);
+        static void operator delete (void *p);
 
         Message() {};
     private:
         Message(const Message&) {} // No copying
     };
 
-private:    
-    // Message management
-    static Message*            g_FreeMessages;
-    static std::list<Message*> g_Messages;
-    static unsigned long       g_References;
+    MessagePool<Message> m_messages;    ///< Messages sent by this node
 
+private:    
     static void PrintMessage(std::ostream& out, const Message& msg);
 
     Node*             m_prev;           ///< Prev node in the ring
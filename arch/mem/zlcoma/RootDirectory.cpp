@@ -69,10 +69,26 @@ ZLCOMA::RootDirectory::Line* ZLCOMA::RootDirectory::GetEmptyLine(MemAddr address
     return NULL;
 }
 
-bool ZLCOMA::RootDirectory::OnReadCompleted()
+bool ZLCOMA::RootDirectory::OnReadCompleted(MemAddr address)
 {
-    assert(!m_active.empty());
-    Message* msg = m_active.front();
+    // The DDR channel may complete reads out of order;
+    // find the oldest message for the line
+    std::deque<Message*>::iterator p = m_active.begin();
+    for (; p != m_active.end(); ++p)
+    {
+        MemAddr local;
+        m_parent.MapToRootDirectory((*p)->address, local);
+        if (local == address)
+        {
+            break;
+        }
+    }
+    if (p == m_active.end())
+    {
+        throw exceptf<InvalidArgumentException>(*this, "DDR completed a read of %#016llx that was not requested",
+                                                (unsigned long long)address);
+    }
+    Message* msg = *p;
     
     // Attach data to message, give all tokens and send
     COMMIT
@@ -85,7 +101,7 @@ bool ZLCOMA::RootDirectory::OnReadCompleted()
 
         msg->dirty = false;
         
-        m_active.pop();
+        m_active.erase(p);
     }
 
     if (!m_responses.Push(msg))
@@ -102,7 +118,8 @@ bool ZLCOMA::RootDirectory::OnMessageReceived(Message* req)
 {
     assert(req != NULL);
 
-    if (((req->address / m_lineSize) % m_numRoots) == m_id)
+    MemAddr local;
+    if (m_parent.MapToRootDirectory(req->address, local) == m_id)
     {
         // This message is for us
         if (!p_lines.Invoke())
@@ -356,7 +373,8 @@ Result ZLCOMA::RootDirectory::DoRequests()
     {
         // Since we stripe cache lines across root directories, adjust the
         // address before we send it to memory for timing.
-        unsigned int mem_address = (msg->address / m_lineSize) / m_numRoots * m_lineSize;
+        MemAddr mem_address;
+        m_parent.MapToRootDirectory(msg->address, mem_address);
 
         if (msg->type == Message::READ)
         {
@@ -368,7 +386,7 @@ Result ZLCOMA::RootDirectory::DoRequests()
             
             COMMIT{ 
                 ++m_nreads;
-                m_active.push(msg);
+                m_active.push_back(msg);
             }
         }
         else
@@ -445,7 +463,7 @@ void ZLCOMA::RootDirectory::SetNumDirectories(size_t num_dirs)
     }
 }
 
-ZLCOMA::RootDirectory::RootDirectory(const std::string& name, ZLCOMA& parent, Clock& clock, size_t id, size_t numRoots, const DDRChannelRegistry& ddr, Config& config) :
+ZLCOMA::RootDirectory::RootDirectory(const std::string& name, ZLCOMA& parent, Clock& clock, size_t id, const DDRChannelRegistry& ddr, Config& config) :
     Simulator::Object(name, parent),
     DirectoryBottom(name, parent, clock),
     m_selector (parent.GetBankSelector()),
@@ -453,7 +471,6 @@ ZLCOMA::RootDirectory::RootDirectory(const std::string& name, ZLCOMA& parent, Cl
     m_assoc_dir(config.getValue<size_t>(parent, "L2CacheAssociativity") * config.getValue<size_t>(parent, "NumL2CachesPerRing")),
     m_sets     (m_selector.GetNumBanks()),
     m_id       (id),
-    m_numRoots (numRoots),
     p_lines    (*this, clock, "p_lines"),
     m_requests ("b_requests", *this, clock, config.getValue<size_t>(*this, "ExternalOutputQueueSize")),
     m_responses("b_responses", *this, clock, config.getValue<size_t>(*this, "ExternalInputQueueSize")),
@@ -465,6 +482,9 @@ ZLCOMA::RootDirectory::RootDirectory(const std::string& name, ZLCOMA& parent, Cl
 {
     assert(m_lineSize <= MAX_MEMORY_OPERATION_SIZE);
 
+    RegisterSampleVariableInObject(m_nreads, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_nwrites, SVC_CUMULATIVE);
+
     config.registerObject(*this, "rootdir");
     config.registerProperty(*this, "freq", (uint32_t)clock.GetFrequency());
 
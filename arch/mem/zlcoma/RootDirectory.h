@@ -3,6 +3,7 @@
 
 #include "Directory.h"
 #include "mem/DDR.h"
+#include <deque>
 #include <queue>
 #include <set>
 
@@ -32,8 +33,7 @@ private:
     size_t            m_assoc_dir;  ///< Number of lines in a set per directory
     size_t            m_assoc;      ///< Number of lines in a set
     size_t            m_sets;       ///< Number of sets
-    size_t            m_id;         ///< Which root directory we are (0 <= m_id < m_numRoots)
-    size_t            m_numRoots;   ///< Number of root directories on the top-level ring
+    size_t            m_id;         ///< Which root directory we are (0 <= m_id < number of root directories)
 
     ArbitratedService<CyclicArbitratedPort> p_lines;      ///< Arbitrator for lines and output
 
@@ -41,7 +41,7 @@ private:
     Buffer<Message*>  m_requests;  ///< Requests to memory
     Buffer<Message*>  m_responses; ///< Responses from memory
     
-    std::queue<Message*> m_active;  ///< Active messages in memory
+    std::deque<Message*> m_active;  ///< Active messages in memory
 
 	std::queue<Line*>    m_activelines;
 
@@ -53,7 +53,7 @@ private:
     Line* FindLine(MemAddr address);
     Line* GetEmptyLine(MemAddr address, MemAddr& tag);
     bool  OnMessageReceived(Message* msg);
-    bool  OnReadCompleted();
+    bool  OnReadCompleted(MemAddr address);
 
     // Processes
     Result DoIncoming();
@@ -65,7 +65,7 @@ private:
     uint64_t          m_nwrites;
 
 public:
-    RootDirectory(const std::string& name, ZLCOMA& parent, Clock& clock, size_t id, size_t numRoots, const DDRChannelRegistry& ddr, Config& config);
+    RootDirectory(const std::string& name, ZLCOMA& parent, Clock& clock, size_t id, const DDRChannelRegistry& ddr, Config& config);
 
     // Updates the internal data structures to accomodate a system with N directories
     void SetNumDirectories(size_t num_dirs);
@@ -157,9 +157,18 @@ bool Processor::Allocator::QueueThreads(ThreadList& list, const ThreadQueue& thr
         {
             cur = next;
             next = m_threadTable[cur].next;
+            if (m_threadTable[cur].state == TST_SUSPENDED)
+            {
+                m_parent.RecordTimeline(Timeline::THREAD_ACTIVATE, cur);
+            }
             m_threadTable[cur].state = state;
             ++count;
 
+            if (m_parent.m_profiler != NULL && state == TST_READY)
+            {
+                m_parent.m_profiler->OnActivate(cur, GetCycleNo());
+            }
+
             DebugSimWrite("F%u/T%u -> %s", (unsigned)m_threadTable[cur].family, (unsigned)cur, ThreadStateNames[state]);
 
         } while (cur != threads.tail);
@@ -228,6 +237,7 @@ bool Processor::Allocator::KillThread(TID tid)
     {
         thread.cid    = INVALID_CID;
         thread.state  = TST_TERMINATED;
+        m_parent.RecordTimeline(Timeline::THREAD_KILL, tid);
     }
     return true;
 }
@@ -287,6 +297,7 @@ bool Processor::Allocator::SuspendThread(TID tid, MemAddr pc)
         thread.cid   = INVALID_CID;
         thread.pc    = pc;
         thread.state = TST_SUSPENDED;
+        m_parent.RecordTimeline(Timeline::THREAD_SUSPEND, tid);
     }
     return true;
 }
@@ -458,6 +469,7 @@ bool Processor::Allocator::AllocateThread(LFID fid, TID tid, bool isNewlyAllocat
     // Statistics
     COMMIT{
         ++m_numCreatedThreads;
+        m_parent.RecordTimeline(Timeline::THREAD_ALLOCATE, tid, fid);
     }
 
     DebugSimWrite("F%u/T%u(%llu) created",
@@ -499,7 +511,11 @@ bool Processor::Allocator::DecreaseFamilyDependency(LFID fid, Family& family, Fa
     case FAMDEP_ALLOCATION_DONE:
         if (deps->numThreadsAllocated == 0 && deps->allocationDone)
         {
-            COMMIT{ family.state = FST_TERMINATED; }
+            COMMIT
+            {
+                family.state = FST_TERMINATED;
+                m_parent.RecordTimeline(Timeline::FAMILY_TERMINATE, fid);
+            }
             DebugSimWrite("F%u terminated", (unsigned)fid);
         }
         // Fall through
@@ -510,7 +526,11 @@ bool Processor::Allocator::DecreaseFamilyDependency(LFID fid, Family& family, Fa
             deps->numPendingReads     == 0 && deps->prevSynchronized)
         {
             // Forward synchronization token
-            COMMIT{ family.sync.done = true; }
+            COMMIT
+            {
+                family.sync.done = true;
+                m_parent.RecordTimeline(Timeline::FAMILY_SYNC, fid);
+            }
     
             if (family.link != INVALID_LFID)
             {
@@ -698,6 +718,7 @@ FCapability Processor::Allocator::InitializeFamily(LFID fid) const
         family.lastAllocated = INVALID_TID;
         family.prevCleanedUp = false;
         family.broken        = false;
+        family.allocFailed   = false;
 
         // Dependencies
         family.dependencies.allocationDone      = false;
@@ -710,6 +731,19 @@ FCapability Processor::Allocator::InitializeFamily(LFID fid) const
     return capability;
 }
 
+void Processor::Allocator::GetPlacementLoad(PID parent_pid, PlacementLoad& load) const
+{
+    load.pid           = m_parent.GetPID();
+    load.parent_pid    = parent_pid;
+    load.used_families = m_familyTable.GetNumUsedFamilies(CONTEXT_NORMAL);
+    load.num_families  = m_familyTable.GetNumFamilies() - 1;
+    load.free_threads  = m_threadTable.GetNumFreeThreads(CONTEXT_NORMAL);
+    load.num_threads   = m_threadTable.GetNumThreads() - 1;
+    load.free_contexts = m_raunit.GetNumFreeContexts(CONTEXT_NORMAL);
+    load.num_contexts  = m_raunit.GetNumContexts();
+    load.num_created   = m_numCreatedFamilies;
+}
+
 bool Processor::Allocator::IsContextAvailable(ContextType type) const
  {
     return m_raunit     .GetNumFreeContexts(type) > 0 &&
@@ -729,6 +763,7 @@ bool Processor::Allocator::ActivateFamily(LFID fid)
     {
         Family& family = m_familyTable[fid];
         family.state = FST_ACTIVE;
+        m_parent.RecordTimeline(Timeline::FAMILY_CREATE, fid, family.pc);
 
         // Statistics
         ++m_numCreatedFamilies;
@@ -742,6 +777,7 @@ bool Processor::Allocator::AllocateRegisters(LFID fid, ContextType type)
 {
     // Try to allocate registers
     Family& family = m_familyTable[fid];
+    bool fragmented = false;
     
     for (FSize physBlockSize = std::max<TSize>(1, family.physBlockSize); physBlockSize > 0; physBlockSize--)
     {
@@ -757,7 +793,7 @@ bool Processor::Allocator::AllocateRegisters(LFID fid, ContextType type)
         }
 
         RegIndex indices[NUM_REG_TYPES];
-        if (m_raunit.Alloc(sizes, fid, type, indices))
+        if (m_raunit.Alloc(sizes, fid, type, indices, fragmented))
         {
             // Success, we have registers for all types
             std::stringstream str;
@@ -797,11 +833,23 @@ bool Processor::Allocator::AllocateRegisters(LFID fid, ContextType type)
                           (unsigned)family.physBlockSize,
                           (unsigned)physBlockSize);
 
-            COMMIT{ family.physBlockSize = physBlockSize; }
+            COMMIT{
+                family.physBlockSize = physBlockSize;
+                family.allocFailed   = false;
+            }
             return true;
         }
     }
 
+    // Not even the smallest physical block size fit. The allocation is
+    // retried every cycle until it succeeds, so only count the family
+    // once. The failing process does not commit, so the flag is set in
+    // the acquire phase; it is only used for the statistics.
+    if (IsAcquiring() && !family.allocFailed)
+    {
+        family.allocFailed = true;
+        m_raunit.OnAllocFailed(fragmented);
+    }
     return false;
 }
 
@@ -2024,6 +2072,7 @@ void Processor::Allocator::AllocateInitialFamily(MemAddr pc, bool legacy, PSize
     family.pc            = pc;
     family.state         = FST_ACTIVE;
     family.start         = startIndex;
+    m_parent.RecordTimeline(Timeline::FAMILY_CREATE, fid, pc);
 
     for (size_t i = 0; i < NUM_REG_TYPES; i++)
     {
@@ -93,6 +93,9 @@ public:
 
     Family& GetFamilyChecked(LFID fid, FCapability capability) const;
 
+    /// Fills in the load of this core for placing a family from parent_pid
+    void GetPlacementLoad(PID parent_pid, PlacementLoad& load) const;
+
     //
     // Thread management
     //
@@ -38,6 +38,7 @@ Processor::DCache::DCache(const std::string& name, Processor& parent, Clock& clo
     m_numStallingRMisses(0),
     m_numStallingWMisses(0),
     m_numSnoops(0),
+    m_classifier(NULL),
 
     p_CompletedReads(*this, "completed-reads", delegate::create<DCache, &Processor::DCache::DoCompletedReads   >(*this) ),
     p_Incoming      (*this, "incoming",        delegate::create<DCache, &Processor::DCache::DoIncomingResponses>(*this) ),
@@ -56,6 +57,8 @@ Processor::DCache::DCache(const std::string& name, Processor& parent, Clock& clo
     RegisterSampleVariableInObject(m_numStallingRMisses, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numStallingWMisses, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numPassThroughWMisses, SVC_CUMULATIVE);
+    m_readLatency.RegisterSampleVariables(GetFQN() + ":readLatency");
+    m_writeLatency.RegisterSampleVariables(GetFQN() + ":writeLatency");
     
     StorageTraceSet traces;
     m_mcid = m_memory.RegisterClient(*this, p_Outgoing, traces, m_incoming, true);
@@ -88,6 +91,7 @@ Processor::DCache::DCache(const std::string& name, Processor& parent, Clock& clo
     }
 
     m_lines.resize(m_sets * m_assoc);
+    m_tags.Resize(m_sets, m_assoc);
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
         m_lines[i].state  = LINE_EMPTY;
@@ -95,6 +99,11 @@ Processor::DCache::DCache(const std::string& name, Processor& parent, Clock& clo
         m_lines[i].valid  = new bool[m_lineSize];
         m_lines[i].create = false;
     }
+
+    if (config.getValueOrDefault<bool>(*this, "ClassifyMisses", false))
+    {
+        m_classifier = new MissClassifier(*this, m_lines.size());
+    }
     
     m_wbstate.size   = 0;
     m_wbstate.offset = 0;
@@ -108,6 +117,7 @@ Processor::DCache::~DCache()
         delete[] m_lines[i].valid;
     }
     delete m_selector;
+    delete m_classifier;
 }
 
 Result Processor::DCache::FindLine(MemAddr address, Line* &line, bool check_only)
@@ -117,7 +127,16 @@ Result Processor::DCache::FindLine(MemAddr address, Line* &line, bool check_only
     m_selector->Map(address / m_lineSize, tag, setindex);
     const size_t  set  = setindex * m_assoc;
 
-    // Find the line
+    // Find the line; empty lines have no tag
+    const size_t index = m_tags.Find(setindex, tag);
+    if (index != m_tags.Count())
+    {
+        // The wanted line was in the cache
+        line = &m_lines[index];
+        return SUCCESS;
+    }
+
+    // Find a line to allocate
     Line* empty   = NULL;
     Line* replace = NULL;
     for (size_t i = 0; i < m_assoc; ++i)
@@ -130,11 +149,6 @@ Result Processor::DCache::FindLine(MemAddr address, Line* &line, bool check_only
             // Empty, unused line, remember this one
             empty = line;
         }
-        else if (line->tag == tag)
-        {
-            // The wanted line was in the cache
-            return SUCCESS;
-        }
         else if (line->state == LINE_FULL && (replace == NULL || line->access < replace->access))
         {
             // The line is available to be replaced and has a lower LRU rating,
@@ -161,7 +175,7 @@ Result Processor::DCache::FindLine(MemAddr address, Line* &line, bool check_only
         COMMIT
         {
             line->processing = false;
-            line->tag        = tag;
+            m_tags.Set(line - &m_lines[0], tag);
             line->waiting    = INVALID_REG;
             std::fill(line->valid, line->valid + m_lineSize, false);
         }
@@ -239,6 +253,9 @@ Result Processor::DCache::Read(MemAddr address, void* data, MemSize size, RegAdd
                 ++m_numEmptyRMisses;
             else
                 ++m_numResolvedConflicts; 
+
+            if (m_classifier != NULL)
+                m_classifier->Miss(address - offset);
         }
     }
     else 
@@ -262,6 +279,9 @@ Result Processor::DCache::Read(MemAddr address, void* data, MemSize size, RegAdd
             {
                 memcpy(data, line->data + offset, (size_t)size);                
                 ++m_numRHits;
+
+                if (m_classifier != NULL)
+                    m_classifier->Hit(address - offset);
             }
             return SUCCESS;
         }
@@ -275,7 +295,12 @@ Result Processor::DCache::Read(MemAddr address, void* data, MemSize size, RegAdd
         }
         else
         {
-            COMMIT{ ++m_numLoadingRMisses; }
+            COMMIT{
+                ++m_numLoadingRMisses;
+
+                if (m_classifier != NULL)
+                    m_classifier->Hit(address - offset);
+            }
         }
     }
 
@@ -452,6 +477,18 @@ bool Processor::DCache::OnMemoryReadCompleted(MemAddr addr, const char* data)
             return false;
         }
     }
+
+    // The first completion of the line after the request was issued,
+    // which need not be the reply to it, ends the request
+    COMMIT
+    {
+        std::map<MemAddr, CycleNo>::iterator p = m_readIssued.find(addr);
+        if (p != m_readIssued.end())
+        {
+            m_readLatency.Add(GetCycleNo() - p->second);
+            m_readIssued.erase(p);
+        }
+    }
     return true;
 }
 
@@ -468,6 +505,21 @@ bool Processor::DCache::OnMemoryWriteCompleted(WClientID wid)
             DeadlockWrite("Unable to push write completion to buffer");
             return false;
         }
+
+        // The memory completes the writes of a thread in order
+        COMMIT
+        {
+            std::map<WClientID, std::deque<CycleNo> >::iterator p = m_writeIssued.find(wid);
+            if (p != m_writeIssued.end())
+            {
+                m_writeLatency.Add(GetCycleNo() - p->second.front());
+                p->second.pop_front();
+                if (p->second.empty())
+                {
+                    m_writeIssued.erase(p);
+                }
+            }
+        }
     }
     return true;
 }
@@ -520,6 +572,7 @@ bool Processor::DCache::OnMemoryInvalidated(MemAddr address)
             if (line->state == LINE_FULL) {
                 // Full lines are invalidated by clearing them. Simple.
                 line->state = LINE_EMPTY;
+                m_tags.Clear(line - &m_lines[0]);
             } else if (line->state == LINE_LOADING) {
                 // The data is being loaded. Invalidate the line and it will get cleaned up
                 // when the data is read.
@@ -665,7 +718,15 @@ Result Processor::DCache::DoCompletedReads()
         // Move the line to the FULL (or EMPTY when invalidated) state.
         COMMIT
         {
-            line.state = (line.state == LINE_INVALID) ? LINE_EMPTY : LINE_FULL;
+            if (line.state == LINE_INVALID)
+            {
+                line.state = LINE_EMPTY;
+                m_tags.Clear(m_completed.Front());
+            }
+            else
+            {
+                line.state = LINE_FULL;
+            }
         }
         m_completed.Pop();
     }
@@ -711,6 +772,8 @@ Result Processor::DCache::DoOutgoingRequests()
             DeadlockWrite("Unable to send write to 0x%016llx to memory", (unsigned long long)request.address);
             return FAILED;
         }
+
+        COMMIT{ m_writeIssued[request.wid].push_back(GetCycleNo()); }
     }
     else
     {
@@ -719,6 +782,8 @@ Result Processor::DCache::DoOutgoingRequests()
             DeadlockWrite("Unable to send read to 0x%016llx to memory", (unsigned long long)request.address);
             return FAILED;
         }
+
+        COMMIT{ m_readIssued[request.address] = GetCycleNo(); }
     }
 
     DebugMemWrite("F%d queued outgoing %s request for %.*llx",
@@ -803,6 +868,11 @@ void Processor::DCache::Cmd_Read(std::ostream& out, const std::vector<std::strin
                 << "- to a reusable line with different tag (conflict): " << PRINTVAL(m_numResolvedConflicts, r_factor) << endl
                 << "(percentages relative to " << numRAccesses << " read requests)" << endl
                 << endl;
+
+            if (m_classifier != NULL)
+            {
+                m_classifier->Print(out);
+            }
             
             float w_factor = 100.0f / m_numWAccesses;
             out << "***********************************************************" << endl
@@ -894,7 +964,7 @@ void Processor::DCache::Cmd_Read(std::ostream& out, const std::vector<std::strin
             out << " |                     |                                                 |";
         } else {
             out << " | "
-                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(line.tag, set) * m_lineSize;
+                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(m_tags.Get(i), set) * m_lineSize;
             
             switch (line.state)
             {
@@ -23,7 +23,6 @@ public:
     {
         LineState   state;      ///< The line state.
         bool        processing; ///< Has the line been added to m_returned yet?
-        MemAddr     tag;        ///< The address tag.
         char*       data;       ///< The data in this line.
         bool*       valid;      ///< A bitmap of valid bytes in this line.
         CycleNo     access;     ///< Last access time of this line (for LRU).
@@ -69,6 +68,7 @@ private:
 	IMemory&             m_memory;          ///< Memory
 	MCID                 m_mcid;            ///< Memory Client ID
     std::vector<Line>    m_lines;           ///< The cache-lines.
+    CacheTags            m_tags;            ///< The address tags of the cache-lines.
 	size_t               m_assoc;           ///< Config: Cache associativity.
 	size_t               m_sets;            ///< Config: Number of sets in the cace.
 	size_t               m_lineSize;        ///< Config: Size of a cache line, in bytes.
@@ -99,6 +99,14 @@ private:
 
     uint64_t             m_numSnoops;
 
+    MissClassifier*      m_classifier;      ///< Compulsory, capacity and conflict misses; when ClassifyMisses is set
+
+    // Latencies of the requests to memory, from issue to completion
+    std::map<MemAddr, CycleNo>                 m_readIssued;   ///< Issue cycle of the outstanding line reads
+    std::map<WClientID, std::deque<CycleNo> >  m_writeIssued;  ///< Issue cycles of the outstanding writes, per thread
+    LatencyHistogram     m_readLatency;
+    LatencyHistogram     m_writeLatency;
+
        
     Result DoCompletedReads();
     Result DoIncomingResponses();
@@ -121,6 +129,9 @@ public:
 
     size_t GetLineSize() const { return m_lineSize; }
 
+    const LatencyHistogram& GetReadLatency()  const { return m_readLatency; }
+    const LatencyHistogram& GetWriteLatency() const { return m_writeLatency; }
+
     // Memory callbacks
     bool OnMemoryReadCompleted(MemAddr addr, const char* data);
     bool OnMemoryWriteCompleted(TID tid);
@@ -105,6 +105,10 @@ Processor::Pipeline::PipeAction Processor::Pipeline::ExecuteStage::OnCycle()
         {
             // We've executed an instruction
             m_op++;
+            if (m_parent.m_profiler != NULL)
+            {
+                m_parent.m_profiler->OnExecute(m_input.pc_dbg);
+            }
             if (action == PIPE_FLUSH)
             {
                 // Pipeline was flushed, thus there's a thread switch
@@ -112,6 +112,7 @@ LFID Processor::FamilyTable::AllocateFamily(ContextType context)
             Family& family = m_families[fid];
             family.state = FST_ALLOCATED;
             m_free[context]--;
+            m_parent.RecordTimeline(Timeline::FAMILY_ALLOCATE, fid);
         }
     }
     return fid;
@@ -147,6 +148,7 @@ void Processor::FamilyTable::FreeFamily(LFID fid, ContextType context)
         UpdateStats();
         m_families[fid].state = FST_EMPTY;
         m_free[context]++;
+        m_parent.RecordTimeline(Timeline::FAMILY_RELEASE, fid);
     }
 }
 
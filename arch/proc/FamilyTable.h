@@ -81,6 +81,7 @@ struct Family
     LFID         link;           // The LFID of the matching family on the next CPU (prev during allocate)
     bool         prevCleanedUp;  // Last thread has been cleaned up
     bool         broken;         // Family terminated due to break
+    bool         allocFailed;    // Register allocation has failed and is being retried (statistics)
     
     struct
     {
@@ -30,6 +30,7 @@ Processor::ICache::ICache(const std::string& name, Processor& parent, Clock& clo
     m_numHardConflicts(0),
     m_numResolvedConflicts(0),
     m_numStallingMisses(0),
+    m_classifier(NULL),
 
     p_Outgoing(*this, "outgoing", delegate::create<ICache, &Processor::ICache::DoOutgoing>(*this)),
     p_Incoming(*this, "incoming", delegate::create<ICache, &Processor::ICache::DoIncoming>(*this)),
@@ -42,6 +43,7 @@ Processor::ICache::ICache(const std::string& name, Processor& parent, Clock& clo
     RegisterSampleVariableInObject(m_numHardConflicts, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numResolvedConflicts, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numStallingMisses, SVC_CUMULATIVE);
+    m_readLatency.RegisterSampleVariables(GetFQN() + ":readLatency");
 
     config.registerObject(m_parent, "cpu");
     
@@ -77,6 +79,7 @@ Processor::ICache::ICache(const std::string& name, Processor& parent, Clock& clo
 
     // Initialize the cache lines
     m_lines.resize(sets * m_assoc);
+    m_tags.Resize(sets, m_assoc);
     m_data.resize(m_lineSize * m_lines.size());
     for (size_t i = 0; i < m_lines.size(); ++i)
     {
@@ -87,11 +90,17 @@ Processor::ICache::ICache(const std::string& name, Processor& parent, Clock& clo
         line.waiting.head = INVALID_TID;
         line.creation     = false;
     }
+
+    if (config.getValueOrDefault<bool>(*this, "ClassifyMisses", false))
+    {
+        m_classifier = new MissClassifier(*this, m_lines.size());
+    }
 }
 
 Processor::ICache::~ICache()
 {
     delete m_selector;
+    delete m_classifier;
 }
 
 bool Processor::ICache::IsEmpty() const
@@ -119,7 +128,16 @@ Result Processor::ICache::FindLine(MemAddr address, Line* &line, bool check_only
     m_selector->Map(address / m_lineSize, tag, setindex);
     const size_t  set  = setindex * m_assoc;
 
-    // Find the line
+    // Find the line; empty lines have no tag
+    const size_t index = m_tags.Find(setindex, tag);
+    if (index != m_tags.Count())
+    {
+        // The wanted line was in the cache
+        line = &m_lines[index];
+        return SUCCESS;
+    }
+
+    // Find a line to allocate
     Line* empty   = NULL;
     Line* replace = NULL;
     for (size_t i = 0; i < m_assoc; ++i)
@@ -131,11 +149,6 @@ Result Processor::ICache::FindLine(MemAddr address, Line* &line, bool check_only
             // Empty line, remember this one
             empty = line;
         }
-        else if (line->tag == tag)
-        {
-            // The wanted line was in the cache
-            return SUCCESS;
-        }
         else if (line->references == 0 && (replace == NULL || line->access < replace->access))
         {
             // The line is available to be replaced and has a lower LRU rating,
@@ -159,7 +172,7 @@ Result Processor::ICache::FindLine(MemAddr address, Line* &line, bool check_only
         COMMIT
         {
             // Reset the line
-            line->tag = tag;
+            m_tags.Set(line - &m_lines[0], tag);
         }
     }
     return DELAYED;
@@ -177,6 +190,7 @@ bool Processor::ICache::ReleaseCacheLine(CID cid)
             if (--line.references == 0 && line.state == LINE_INVALID)
             {
                 line.state = LINE_EMPTY;
+                m_tags.Clear(cid);
             }
         }
     }
@@ -204,7 +218,7 @@ bool Processor::ICache::Read(CID cid, MemAddr address, void* data, MemSize size)
     }
 #endif
 
-    if (m_lines[cid].state == LINE_EMPTY || m_lines[cid].tag != tag)
+    if (m_tags.Get(cid) != tag)
     {
         throw exceptf<InvalidArgumentException>(*this, "Read (%#016llx, %zd): Attempting to read from an invalid cache line",
                                                 (unsigned long long)address, (size_t)size);
@@ -302,7 +316,12 @@ Result Processor::ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* ci
         {
             // The line was already fetched so we're done.
             // This is 'true' hit in that we don't have to wait.
-            COMMIT{ ++m_numHits; }
+            COMMIT{
+                ++m_numHits;
+
+                if (m_classifier != NULL)
+                    m_classifier->Hit(address);
+            }
             return SUCCESS;
         }
         
@@ -329,6 +348,9 @@ Result Processor::ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* ci
 
             // Statistics
             ++m_numLoadingMisses;
+
+            if (m_classifier != NULL)
+                m_classifier->Hit(address);
         }
     }
     else
@@ -350,6 +372,9 @@ Result Processor::ICache::Fetch(MemAddr address, MemSize size, TID* tid, CID* ci
             else 
                 ++m_numResolvedConflicts; 
 
+            if (m_classifier != NULL)
+                m_classifier->Miss(address);
+
             // Initialize buffer
             line->creation   = false;
             line->references = 1;
@@ -398,6 +423,18 @@ bool Processor::ICache::OnMemoryReadCompleted(MemAddr addr, const char *data)
             return false;
         }
     }
+
+    // The first completion of the line after the request was issued,
+    // which need not be the reply to it, ends the request
+    COMMIT
+    {
+        std::map<MemAddr, CycleNo>::iterator p = m_readIssued.find(addr);
+        if (p != m_readIssued.end())
+        {
+            m_readLatency.Add(GetCycleNo() - p->second);
+            m_readIssued.erase(p);
+        }
+    }
     return true;
 }
 
@@ -432,7 +469,12 @@ bool Processor::ICache::OnMemoryInvalidated(MemAddr address)
             if (line->state == LINE_FULL) {
                 // Valid lines without references are invalidated by clearing then. Simple.
                 // Otherwise, we invalidate them.
-                line->state = (line->references == 0) ? LINE_EMPTY : LINE_INVALID;
+                if (line->references == 0) {
+                    line->state = LINE_EMPTY;
+                    m_tags.Clear(line - &m_lines[0]);
+                } else {
+                    line->state = LINE_INVALID;
+                }
             } else if (line->state != LINE_INVALID) {
                 // Mark the line as invalidated. After it has been loaded and used it will be cleared
                 assert(line->state == LINE_LOADING);
@@ -453,6 +495,8 @@ Result Processor::ICache::DoOutgoing()
         DeadlockWrite("Unable to read %#016llx from memory", (unsigned long long)address);
         return FAILED;
     }
+
+    COMMIT{ m_readIssued[address] = GetCycleNo(); }
     m_outgoing.Pop();
     return SUCCESS;
 }
@@ -565,6 +609,11 @@ void Processor::ICache::Cmd_Read(std::ostream& out, const std::vector<std::strin
                 << "- to a reusable line with different tag (conflict): " << PRINTVAL(m_numResolvedConflicts, r_factor) << endl
                 << "(percentages relative to " << numRAccesses << " read requests)" << endl
                 << endl;
+
+            if (m_classifier != NULL)
+            {
+                m_classifier->Print(out);
+            }
             
             if (numStalls != 0)
             {
@@ -634,7 +683,7 @@ void Processor::ICache::Cmd_Read(std::ostream& out, const std::vector<std::strin
             }
             
             out << " | "
-                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(line.tag, set) * m_lineSize
+                << hex << "0x" << setw(16) << setfill('0') << m_selector->Unmap(m_tags.Get(i), set) * m_lineSize
                 << state << " |";
             
             if (line.state == LINE_FULL)
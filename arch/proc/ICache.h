@@ -21,7 +21,6 @@ class ICache : public Object, public IMemoryCallback, public Inspect::Interface<
     struct Line
     {
         LineState     state;        ///< The state of the line
-        MemAddr       tag;			///< Address tag
         char*         data;			///< The line data
         CycleNo       access;		///< Last access time (for LRU replacement)
 		bool          creation;		///< Is the family creation process waiting on this line?
@@ -42,6 +41,7 @@ class ICache : public Object, public IMemoryCallback, public Inspect::Interface<
     IBankSelector*    m_selector;
     MCID              m_mcid;
     std::vector<Line> m_lines;
+    CacheTags         m_tags;
 	std::vector<char> m_data;
 	Buffer<MemAddr>   m_outgoing;
 	Buffer<CID>       m_incoming;
@@ -58,6 +58,12 @@ class ICache : public Object, public IMemoryCallback, public Inspect::Interface<
     uint64_t             m_numHardConflicts;
     uint64_t             m_numResolvedConflicts;
     uint64_t             m_numStallingMisses;
+
+    MissClassifier*      m_classifier;      ///< Compulsory, capacity and conflict misses; when ClassifyMisses is set
+
+    // Latencies of the requests to memory, from issue to completion
+    std::map<MemAddr, CycleNo> m_readIssued;   ///< Issue cycle of the outstanding line reads
+    LatencyHistogram     m_readLatency;
     
 public:
     ICache(const std::string& name, Processor& parent, Clock& clock, Allocator& allocator, IMemory& memory, Config& config);
@@ -80,6 +86,7 @@ public:
     bool   OnMemoryInvalidated(MemAddr addr);
     Object& GetMemoryPeer() { return m_parent; }
     size_t GetLineSize() const { return m_lineSize; }
+    const LatencyHistogram& GetReadLatency() const { return m_readLatency; }
     size_t GetAssociativity() const { return m_assoc; }
     size_t GetNumLines() const { return m_lines.size(); }
     size_t GetNumSets() const { return GetNumLines() / m_assoc; }
@@ -91,7 +91,7 @@ namespace Simulator
 
     bool Processor::IOBusInterface::OnWriteRequestReceived(IODeviceID from, MemAddr address, const IOData& data)
     {
-        if (data.size > MAX_MEMORY_OPERATION_SIZE)
+        if (data.size > MAX_IO_OPERATION_SIZE)
         {
             throw exceptf<InvalidArgumentException>(*this, "Write request for %#016llx/%u from client %u is too large", 
                                                     (unsigned long long)address, (unsigned)data.size, (unsigned)from);
@@ -1,6 +1,30 @@
 #include "Processor.h"
 #include "sim/config.h"
+#include "sim/sampling.h"
 #include <cstring>
+#include <iomanip>
+#include <sstream>
+
+/*
+  Direct cache access (DCA) for I/O devices.
+
+  Devices read and write the memory of the core over the I/O bus. Each
+  request is split into cache lines, and one line is sent to memory
+  per cycle. Up to MaxOutstandingReads read requests can wait for
+  their lines at the same time, so that a device can stream data from
+  memory instead of waiting for every line to return before issuing
+  the next.
+
+  A request may cover several cache lines (a burst), up to the maximum
+  size of an I/O operation. A burst read is answered with a single bus
+  response once all its lines have arrived; a burst write is a single
+  bus transaction. Devices select their transfer size with their own
+  line size setting (e.g. ROMLineSize, RPCLineSize).
+
+  A flush waits until all the reads issued before it have completed,
+  and is answered when all the writes issued before it have been
+  acknowledged by memory.
+*/
 
 namespace Simulator
 {
@@ -12,13 +36,57 @@ namespace Simulator
           m_lineSize(config.getValue<MemSize>("CacheLineSize")),
           m_requests("b_requests", *this, clock, config.getValue<BufferSize>(*this, "RequestQueueSize")),
           m_responses("b_responses", *this, clock, config.getValue<BufferSize>(*this, "ResponseQueueSize")),
-          m_has_outstanding_request(false),
+          m_reads(config.getValueOrDefault<size_t>(*this, "MaxOutstandingReads", 1)),
+          m_numReads(0),
+          m_issueOffset(0),
+          m_issueSlot(0),
           m_flushing(false),
+          m_flush_client(0),
           m_pending_writes(0),
+          m_devstats(config.getValue<size_t>(parent, "NumDeviceSlots")),
+          m_nReadLines(0),
+          m_nWriteLines(0),
+          m_nReadStalls(0),
+          m_totalReadLatency(0),
           p_MemoryOutgoing(*this, "send-memory-requests", delegate::create<IODirectCacheAccess, &Processor::IODirectCacheAccess::DoMemoryOutgoing>(*this)),
           p_BusOutgoing   (*this, "send-bus-responses", delegate::create<IODirectCacheAccess, &Processor::IODirectCacheAccess::DoBusOutgoing>(*this)),
           p_service(*this, clock, "p_service")
     {
+        if (m_reads.empty())
+        {
+            throw exceptf<InvalidArgumentException>(*this, "MaxOutstandingReads must be at least 1");
+        }
+
+        // A request of MAX_IO_OPERATION_SIZE bytes that is not aligned
+        // touches one more line than it fills.
+        if (MAX_IO_OPERATION_SIZE / m_lineSize + 1 > sizeof(unsigned long long) * 8)
+        {
+            throw exceptf<InvalidArgumentException>(*this, "CacheLineSize is too small for DCA bursts of %u bytes", (unsigned)MAX_IO_OPERATION_SIZE);
+        }
+
+        for (size_t i = 0; i < m_reads.size(); ++i)
+        {
+            m_reads[i].used = false;
+        }
+
+        for (size_t i = 0; i < m_devstats.size(); ++i)
+        {
+            DeviceStats& s = m_devstats[i];
+            s.nReads = s.nWrites = s.nBytesRead = s.nBytesWritten = 0;
+
+            std::stringstream prefix;
+            prefix << "dev" << i << ".";
+            RegisterSampleVariableInObjectWithName(s.nReads,        prefix.str() + "nReads",        SVC_CUMULATIVE);
+            RegisterSampleVariableInObjectWithName(s.nWrites,       prefix.str() + "nWrites",       SVC_CUMULATIVE);
+            RegisterSampleVariableInObjectWithName(s.nBytesRead,    prefix.str() + "nBytesRead",    SVC_CUMULATIVE);
+            RegisterSampleVariableInObjectWithName(s.nBytesWritten, prefix.str() + "nBytesWritten", SVC_CUMULATIVE);
+        }
+        RegisterSampleVariableInObject(m_numReads, SVC_LEVEL);
+        RegisterSampleVariableInObject(m_nReadLines, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nWriteLines, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_nReadStalls, SVC_CUMULATIVE);
+        RegisterSampleVariableInObject(m_totalReadLatency, SVC_CUMULATIVE);
+
         p_service.AddProcess(p_BusOutgoing);
         p_service.AddProcess(p_MemoryOutgoing);
         m_responses.Sensitive(p_BusOutgoing);
@@ -35,14 +103,49 @@ namespace Simulator
     {
         m_memory.UnregisterClient(m_mcid);
     }
-    
+
+    unsigned long long Processor::IODirectCacheAccess::GetLineMask(MemAddr address, MemSize size) const
+    {
+        MemAddr first = address / m_lineSize;
+        MemAddr last  = (address + size - 1) / m_lineSize;
+        size_t nlines = last - first + 1;
+        return (nlines == sizeof(unsigned long long) * 8) ? ~0ULL : (1ULL << nlines) - 1;
+    }
+
+    // Returns the bit for the line in the read's line mask, or 0 if the
+    // read does not cover the line.
+    unsigned long long Processor::IODirectCacheAccess::GetLineBit(const OutstandingRead& r, MemAddr line) const
+    {
+        const MemAddr first = r.address / m_lineSize;
+        if (!r.used || line < first || line - first >= sizeof(unsigned long long) * 8)
+        {
+            return 0;
+        }
+        return r.lines & (1ULL << (line - first));
+    }
+
+    void Processor::IODirectCacheAccess::CountTransfer(IODeviceID client, RequestType type, MemSize size)
+    {
+        if (client < m_devstats.size())
+        {
+            DeviceStats& s = m_devstats[client];
+            if (type == READ) {
+                ++s.nReads;
+                s.nBytesRead += size;
+            } else {
+                ++s.nWrites;
+                s.nBytesWritten += size;
+            }
+        }
+    }
+
     bool Processor::IODirectCacheAccess::QueueRequest(const Request& req)
     {
-        size_t offset = (size_t)(req.address % m_lineSize);
-        if (offset + req.size > m_lineSize)
+        if (req.size > MAX_IO_OPERATION_SIZE)
         {
-            throw exceptf<InvalidArgumentException>(*this, "DCA request for %#016llx/%u (dev %u, type %d) crosses over cache line boundary", 
-                                                    (unsigned long long)req.address, (unsigned)req.size, (unsigned)req.client, (int)req.type);
+            throw exceptf<InvalidArgumentException>(*this, "DCA request for %#016llx/%u (dev %u, type %d) is larger than %u bytes", 
+                                                    (unsigned long long)req.address, (unsigned)req.size, (unsigned)req.client, (int)req.type,
+                                                    (unsigned)MAX_IO_OPERATION_SIZE);
         }
 
         if (req.type != FLUSH && !m_cpu.CheckPermissions(req.address, req.size, (req.type == WRITE) ? IMemory::PERM_DCA_WRITE : IMemory::PERM_DCA_READ))
@@ -103,7 +206,6 @@ namespace Simulator
     {
         const Response& res = m_responses.Front();
 
-
         if (!p_service.Invoke())
         {
             DeadlockWrite("Unable to acquire port for DCA read response (%#016llx, %u)",
@@ -119,35 +221,67 @@ namespace Simulator
             
             if (m_pending_writes == 1 && m_flushing == true)
             { 
-                COMMIT { 
-                    --m_pending_writes;
-                    m_flushing = false; 
-                }
-                // the flush response will be sent below.
-            }
-            else
-            {
-                COMMIT { 
-                    --m_pending_writes; 
+                // last outstanding write, send the flush response.
+                IOBusInterface::IORequest req;
+                req.device = m_flush_client;
+                req.type = IOBusInterface::REQ_READRESPONSE;
+                req.address = 0;
+                req.data.size = 0;
+
+                if (!m_busif.SendRequest(req))
+                {
+                    DeadlockWrite("Unable to send DCA flush response to client %u", (unsigned)req.device);
+                    return FAILED;
                 }
-                // one or more outstanding write left, no flush response needed
-                m_responses.Pop();
-                return SUCCESS;
+
+                DebugIOWrite("Sent DCA flush response to client %u", (unsigned)req.device);
+
+                COMMIT { m_flushing = false; }
             }
+
+            COMMIT { --m_pending_writes; }
+            m_responses.Pop();
+            return SUCCESS;
         }
 
-        if (m_has_outstanding_request 
-            && res.address <= m_outstanding_address
-            && res.address + res.size >= m_outstanding_address + m_outstanding_size)
+        // Read response: find the first read that is still waiting for
+        // this line. If several reads wait for the same line, the
+        // response stays in the queue until all have been served.
+        const MemAddr line = res.address / m_lineSize;
+        size_t i, next;
+        unsigned long long bit = 0;
+        for (i = 0; i < m_reads.size(); ++i)
         {
+            bit = GetLineBit(m_reads[i], line);
+            if (bit != 0 && !(m_reads[i].received & bit))
+                break;
+        }
+
+        if (i == m_reads.size())
+        {
+            // No read waiting for this line, e.g. a response to a read
+            // from another client on the same cache
+            m_responses.Pop();
+            return SUCCESS;
+        }
+
+        OutstandingRead& r = m_reads[i];
+
+        if ((r.received | bit) == r.lines)
+        {
+            // This was the last line of the request, send the response
             IOBusInterface::IORequest req;
-            req.device = m_outstanding_client;
+            req.device = r.client;
             req.type = IOBusInterface::REQ_READRESPONSE;
-            req.address = m_outstanding_address;
-            req.data.size = m_outstanding_size;
+            req.address = r.address;
+            req.data.size = r.size;
+
+            // Copy the lines that arrived earlier, then this line
+            memcpy(req.data.data, r.data, r.size);
+            MemAddr begin = std::max(r.address, res.address);
+            MemAddr end   = std::min(r.address + r.size, res.address + res.size);
+            memcpy(req.data.data + (begin - r.address), res.data + (begin - res.address), end - begin);
 
-            memcpy(req.data.data, res.data + (m_outstanding_address - res.address), m_outstanding_size);
-            
             if (!m_busif.SendRequest(req))
             {
                 DeadlockWrite("Unable to send DCA read response to client %u for %#016llx/%u",
@@ -157,14 +291,36 @@ namespace Simulator
 
             DebugIOWrite("Sent DCA read response to client %u for %#016llx/%u",
                          (unsigned)req.device, (unsigned long long)req.address, (unsigned)req.data.size);
-            
+
             COMMIT {
-                m_has_outstanding_request = false;
+                CountTransfer(r.client, READ, r.size);
+                m_totalReadLatency += GetCycleNo() - r.issued;
+                r.used = false;
+                --m_numReads;
+            }
+        }
+        else
+        {
+            COMMIT {
+                MemAddr begin = std::max(r.address, res.address);
+                MemAddr end   = std::min(r.address + r.size, res.address + res.size);
+                memcpy(r.data + (begin - r.address), res.data + (begin - res.address), end - begin);
+                r.received |= bit;
             }
         }
 
-        m_responses.Pop();
+        // Check whether any other read also waits for this line
+        for (next = i + 1; next < m_reads.size(); ++next)
+        {
+            unsigned long long obit = GetLineBit(m_reads[next], line);
+            if (obit != 0 && !(m_reads[next].received & obit))
+                break;
+        }
 
+        if (next == m_reads.size())
+        {
+            m_responses.Pop();
+        }
         return SUCCESS;
     }
 
@@ -182,11 +338,11 @@ namespace Simulator
                 return FAILED;
             }
 
-            if (m_has_outstanding_request)
+            if (m_numReads > 0 || m_flushing)
             {
-                // some request is already queued, so we just stall
-                DeadlockWrite("Will not send additional DCA flush request from client %u, already waiting for request for dev %u",
-                              (unsigned)req.client, (unsigned)m_outstanding_client);
+                // wait for earlier requests to complete
+                DeadlockWrite("Will not send DCA flush request from client %u, still waiting for %u read(s)%s",
+                              (unsigned)req.client, (unsigned)m_numReads, m_flushing ? " and a flush" : "");
                 return FAILED;
             }
 
@@ -209,10 +365,7 @@ namespace Simulator
 
             COMMIT {
                 m_flushing = true;
-                m_has_outstanding_request = true;
-                m_outstanding_client = req.client;
-                m_outstanding_address = 0;
-                m_outstanding_size = 0;
+                m_flush_client = req.client;
             }
             
             break;
@@ -220,18 +373,13 @@ namespace Simulator
         case READ:
         {
             // this is a read request coming from the bus.
-
-            if (req.size > m_lineSize || req.size > MAX_MEMORY_OPERATION_SIZE)
-            {
-                throw InvalidArgumentException("Read size is too big");
-            }
+            // One line is requested from memory per cycle.
             
-            if (req.address / m_lineSize != (req.address + req.size - 1) / m_lineSize)
+            if (req.size == 0)
             {
-                throw InvalidArgumentException("Read request straddles cache-line boundary");
+                throw InvalidArgumentException(*this, "Empty DCA read request");
             }
 
-            
             if (!p_service.Invoke())
             {
                 DeadlockWrite("Unable to acquire port for DCA read (%#016llx, %u)",
@@ -240,44 +388,66 @@ namespace Simulator
                 return FAILED;
             }
 
-            if (m_has_outstanding_request)
+            size_t slot = m_issueSlot;
+            if (m_issueOffset == 0)
             {
-                // some request is already queued, so we just stall
-                DeadlockWrite("Will not send additional DCA read request from client %u for %#016llx/%u, already waiting for %#016llx/%u, dev %u",
-                              (unsigned)req.client, (unsigned long long)req.address, (unsigned)req.size, 
-                              (unsigned long long)m_outstanding_address, (unsigned)m_outstanding_size, (unsigned)m_outstanding_client);
-                return FAILED;
+                // First line of the request, find a free entry
+                for (slot = 0; slot < m_reads.size() && m_reads[slot].used; ++slot) {}
+                if (slot == m_reads.size())
+                {
+                    DeadlockWrite("Will not send additional DCA read request from client %u for %#016llx/%u, already %u reads outstanding",
+                                  (unsigned)req.client, (unsigned long long)req.address, (unsigned)req.size, (unsigned)m_numReads);
+                    if (IsAcquiring()) {
+                        ++m_nReadStalls;
+                    }
+                    return FAILED;
+                }
             }
-            
+
             // send the request to the memory
-            MemAddr line_address  = req.address & -m_lineSize;
+            MemAddr address      = req.address + m_issueOffset;
+            MemAddr line_address = address & -m_lineSize;
+            MemSize size         = std::min((MemSize)(req.size - m_issueOffset), (MemSize)(line_address + m_lineSize - address));
             if (!m_memory.Read(m_mcid, line_address))
             {
-                DeadlockWrite("Unable to send DCA read from %#016llx/%u, dev %u to memory", (unsigned long long)req.address, (unsigned)req.size, (unsigned)req.client);
+                DeadlockWrite("Unable to send DCA read from %#016llx/%u, dev %u to memory", (unsigned long long)address, (unsigned)size, (unsigned)req.client);
                 return FAILED;
             }
 
+            const bool last = (m_issueOffset + size >= req.size);
+
             COMMIT {
-                m_has_outstanding_request = true;
-                m_outstanding_client = req.client;
-                m_outstanding_address = req.address;
-                m_outstanding_size = req.size;
+                ++m_nReadLines;
+                if (m_issueOffset == 0)
+                {
+                    OutstandingRead& r = m_reads[slot];
+                    r.used     = true;
+                    r.client   = req.client;
+                    r.address  = req.address;
+                    r.size     = req.size;
+                    r.lines    = GetLineMask(req.address, req.size);
+                    r.received = 0;
+                    r.issued   = GetCycleNo();
+                    m_issueSlot = slot;
+                    ++m_numReads;
+                }
+                m_issueOffset = last ? 0 : m_issueOffset + size;
             }
 
+            if (!last)
+            {
+                // more lines to go for this request
+                return SUCCESS;
+            }
             break;
         }
         case WRITE:
         {
-            // write operation
+            // write operation, one line per cycle.
 
-            if (req.size > m_lineSize || req.size > MAX_MEMORY_OPERATION_SIZE)
-            {
-                throw InvalidArgumentException("Write size is too big");
-            }
-            
-            if (req.address / m_lineSize != (req.address + req.size - 1) / m_lineSize)
+            if (req.size == 0)
             {
-                throw InvalidArgumentException("Write request straddles cache-line boundary");
+                throw InvalidArgumentException(*this, "Empty DCA write request");
             }
 
             if (!p_service.Invoke())
@@ -288,25 +458,40 @@ namespace Simulator
                 return FAILED;
             }
 
-            MemAddr line_address  = req.address & -m_lineSize;
-            size_t offset = req.address - line_address;
+            MemAddr address      = req.address + m_issueOffset;
+            MemAddr line_address = address & -m_lineSize;
+            size_t  offset       = address - line_address;
+            MemSize size         = std::min((MemSize)(req.size - m_issueOffset), (MemSize)(m_lineSize - offset));
 
             MemData mdata;
             COMMIT{
-                std::copy(req.data, req.data + req.size, mdata.data + offset);
+                std::copy(req.data + m_issueOffset, req.data + m_issueOffset + size, mdata.data + offset);
                 std::fill(mdata.mask, mdata.mask + offset, false);
-                std::fill(mdata.mask + offset, mdata.mask + offset + req.size, true);
-                std::fill(mdata.mask + offset + req.size, mdata.mask + m_lineSize, false);
+                std::fill(mdata.mask + offset, mdata.mask + offset + size, true);
+                std::fill(mdata.mask + offset + size, mdata.mask + m_lineSize, false);
             }
 
             if (!m_memory.Write(m_mcid, line_address, mdata, INVALID_WCLIENTID))
             {
-                DeadlockWrite("Unable to send DCA write to %#016llx/%u to memory", (unsigned long long)req.address, (unsigned)req.size);
+                DeadlockWrite("Unable to send DCA write to %#016llx/%u to memory", (unsigned long long)address, (unsigned)size);
                 return FAILED;
             }
 
-            COMMIT { ++m_pending_writes; }
+            const bool last = (m_issueOffset + size >= req.size);
 
+            COMMIT {
+                ++m_pending_writes;
+                ++m_nWriteLines;
+                m_issueOffset = last ? 0 : m_issueOffset + size;
+            }
+
+            if (!last)
+            {
+                // more lines to go for this request
+                return SUCCESS;
+            }
+
+            COMMIT { CountTransfer(req.client, WRITE, req.size); }
             break;
         }
         }
@@ -316,5 +501,75 @@ namespace Simulator
 
     }
 
+    void Processor::IODirectCacheAccess::Cmd_Info(std::ostream& out, const std::vector<std::string>& /*arguments*/) const
+    {
+        out <<
+        "The Direct Cache Access unit lets I/O devices read and write memory through\n"
+        "the core's memory interface. Requests larger than a cache line are split\n"
+        "into lines, and several reads can be outstanding at the same time.\n\n"
+        "Supported operations:\n"
+        "- inspect <component>\n"
+        "  Displays the outstanding requests and the transfer statistics per device.\n";
+    }
+
+    void Processor::IODirectCacheAccess::Cmd_Read(std::ostream& out, const std::vector<std::string>& /*arguments*/) const
+    {
+        out << "Outstanding reads: " << std::dec << m_numReads << " of " << m_reads.size() << std::endl;
+        if (m_numReads > 0)
+        {
+            out << std::endl
+                << "Slot | Device | Address            | Size | Lines received | Since" << std::endl
+                << "-----+--------+--------------------+------+----------------+----------" << std::endl;
+            for (size_t i = 0; i < m_reads.size(); ++i)
+            {
+                const OutstandingRead& r = m_reads[i];
+                if (!r.used)
+                    continue;
+                size_t nlines = 0, nreceived = 0;
+                for (unsigned long long m = r.lines; m != 0; m >>= 1)
+                    ++nlines;
+                for (unsigned long long m = r.received; m != 0; m >>= 1)
+                    nreceived += (m & 1);
+                out << std::setw(4) << std::setfill(' ') << i << " | "
+                    << std::setw(6) << r.client << " | "
+                    << "0x" << std::hex << std::setw(16) << std::setfill('0') << r.address << " | "
+                    << std::dec << std::setw(4) << std::setfill(' ') << r.size << " | "
+                    << std::setw(6) << nreceived << " of " << std::setw(6) << nlines << " | "
+                    << r.issued << std::endl;
+            }
+        }
+        if (m_flushing)
+        {
+            out << "Flushing for device " << m_flush_client << ", " << m_pending_writes << " write(s) pending" << std::endl;
+        }
+        else
+        {
+            out << "Pending writes: " << m_pending_writes << std::endl;
+        }
+
+        out << std::endl
+            << "Device | Reads      | Bytes read   | Writes     | Bytes written" << std::endl
+            << "-------+------------+--------------+------------+--------------" << std::endl;
+        for (size_t i = 0; i < m_devstats.size(); ++i)
+        {
+            const DeviceStats& s = m_devstats[i];
+            if (s.nReads == 0 && s.nWrites == 0)
+                continue;
+            out << std::setw(6) << i << " | "
+                << std::setw(10) << s.nReads << " | "
+                << std::setw(12) << s.nBytesRead << " | "
+                << std::setw(10) << s.nWrites << " | "
+                << s.nBytesWritten << std::endl;
+        }
+        if (m_numReads == 0 && m_nReadLines > 0)
+        {
+            size_t nreads = 0;
+            for (size_t i = 0; i < m_devstats.size(); ++i)
+                nreads += m_devstats[i].nReads;
+            if (nreads > 0)
+                out << std::endl << "Average read latency: " << std::fixed << std::setprecision(1)
+                    << (double)m_totalReadLatency / nreads << " cycles" << std::endl;
+        }
+    }
 
 }
@@ -5,7 +5,7 @@
 #error This file should be included in Processor.h
 #endif
 
-class IODirectCacheAccess : public Object, public IMemoryCallback
+class IODirectCacheAccess : public Object, public IMemoryCallback, public Inspect::Interface<Inspect::Read>
 {
 public:
 
@@ -22,7 +22,7 @@ public:
         RequestType type;
         MemAddr     address;
         MemSize     size;
-        char        data[MAX_MEMORY_OPERATION_SIZE];
+        char        data[MAX_IO_OPERATION_SIZE];
     };
 
 private:
@@ -34,6 +34,30 @@ private:
         char        data[MAX_MEMORY_OPERATION_SIZE];
     };
 
+    // A read request from a device that is waiting for its lines.
+    // A burst read covers several cache lines; the response is sent
+    // to the device when all of them have arrived.
+    struct OutstandingRead
+    {
+        bool               used;
+        IODeviceID         client;
+        MemAddr            address;
+        MemSize            size;
+        unsigned long long received;  ///< Bit mask of the lines that have arrived
+        unsigned long long lines;     ///< Bit mask of the lines covered by the request
+        CycleNo            issued;
+        char               data[MAX_IO_OPERATION_SIZE];
+    };
+
+    // Per-device transfer statistics
+    struct DeviceStats
+    {
+        uint64_t nReads;
+        uint64_t nWrites;
+        uint64_t nBytesRead;
+        uint64_t nBytesWritten;
+    };
+
     Processor&           m_cpu;
     IMemory&             m_memory;
     MCID                 m_mcid;
@@ -46,20 +70,36 @@ public:
 private:
     Buffer<Response>     m_responses; // from memory
 
-    bool                 m_has_outstanding_request;
-    IODeviceID           m_outstanding_client;
-    MemAddr              m_outstanding_address;
-    MemSize              m_outstanding_size;
+    std::vector<OutstandingRead> m_reads;  ///< Read requests in flight to memory
+    size_t               m_numReads;        ///< Number of used entries in m_reads
+    MemSize              m_issueOffset;     ///< Offset in the front request of the next line to issue
+    size_t               m_issueSlot;       ///< Entry in m_reads of the read being issued
 
     bool                 m_flushing;
+    IODeviceID           m_flush_client;
     size_t               m_pending_writes;
 
+    // Statistics
+    std::vector<DeviceStats> m_devstats;
+    uint64_t             m_nReadLines;
+    uint64_t             m_nWriteLines;
+    uint64_t             m_nReadStalls;      ///< Cycles a read waited for a free entry
+    uint64_t             m_totalReadLatency; ///< Cycles from first line issue to response, summed
+
+    unsigned long long GetLineMask(MemAddr address, MemSize size) const;
+    unsigned long long GetLineBit(const OutstandingRead& r, MemAddr line) const;
+    void CountTransfer(IODeviceID client, RequestType type, MemSize size);
+
 public:
     IODirectCacheAccess(const std::string& name, Object& parent, Clock& clock, Processor& proc, IMemory& memory, IOBusInterface& busif, Config& config);
     ~IODirectCacheAccess();
 
     bool QueueRequest(const Request& req);
-    
+
+    // Debugging
+    void Cmd_Info(std::ostream& out, const std::vector<std::string>& arguments) const;
+    void Cmd_Read(std::ostream& out, const std::vector<std::string>& arguments) const;
+
     Process p_MemoryOutgoing;
     Process p_BusOutgoing;
 
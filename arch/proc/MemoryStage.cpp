@@ -220,6 +220,14 @@ Processor::Pipeline::PipeAction Processor::Pipeline::MemoryStage::OnCycle()
                                           (int)(sizeof(MemAddr)*2), (unsigned long long)m_input.address, (size_t)m_input.size,
                                           m_input.Rc.str().c_str());
 
+                            COMMIT
+                            {
+                                if (m_parent.m_profiler != NULL)
+                                {
+                                    m_parent.m_profiler->OnDCacheMiss(m_input.pc_dbg);
+                                }
+                            }
+
                             break;
                         case SUCCESS:
                             break;
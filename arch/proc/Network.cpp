@@ -33,10 +33,15 @@ Processor::Network::Network(
     m_grid(grid),
     
     m_loadBalanceThreshold(config.getValue<unsigned>(*this, "LoadBalanceThreshold")),
+    m_placement(IPlacementPolicy::makePolicy(*this, config.getValueOrDefault<string>(*this, "PlacementPolicy", "CONTEXTS"), config)),
 
     m_numAllocates(0),
     m_numBundles(0),
     m_numCreates(0),
+    m_numPlacements(0),
+    m_numPlacementsLocal(0),
+    m_numPlacementsThreshold(0),
+    m_totalPlacementDistance(0),
 
 #define CONSTRUCT_REGISTER(name) name(*this, #name)
     CONSTRUCT_REGISTER(m_delegateOut),
@@ -55,6 +60,10 @@ Processor::Network::Network(
     RegisterSampleVariableInObject(m_numAllocates, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numBundles, SVC_CUMULATIVE);
     RegisterSampleVariableInObject(m_numCreates, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_numPlacements, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_numPlacementsLocal, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_numPlacementsThreshold, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_totalPlacementDistance, SVC_CUMULATIVE);
 
     m_delegateOut.Sensitive(p_DelegationOut);
     m_delegateIn .Sensitive(p_DelegationIn);
@@ -65,6 +74,30 @@ Processor::Network::Network(
     m_allocResponse.in.Sensitive(p_AllocResponse);
 }
 
+Processor::Network::~Network()
+{
+    delete m_placement;
+}
+
+unsigned int Processor::Network::GetPlacementCost(PID parent_pid) const
+{
+    PlacementLoad load;
+    m_allocator.GetPlacementLoad(parent_pid, load);
+    return m_placement->GetCost(load);
+}
+
+void Processor::Network::OnPlacement(PID target_pid, PID parent_pid, bool threshold)
+{
+    // Statistics on the decisions of the balanced allocation
+    COMMIT
+    {
+        ++m_numPlacements;
+        if (target_pid == m_parent.GetPID()) ++m_numPlacementsLocal;
+        if (threshold) ++m_numPlacementsThreshold;
+        m_totalPlacementDistance += (target_pid > parent_pid) ? target_pid - parent_pid : parent_pid - target_pid;
+    }
+}
+
 void Processor::Network::Initialize(Network* prev, Network* next)
 {
     m_prev = prev;
@@ -210,6 +243,8 @@ Result Processor::Network::DoSyncs()
                   (unsigned)info.fid, (unsigned)info.broken,
                   (unsigned)info.pid, (unsigned)info.reg);
 
+    COMMIT{ m_parent.RecordTimeline(Timeline::SYNC_WRITEBACK, info.fid, info.pid); }
+
     m_syncs.Pop();
     return SUCCESS;
 }
@@ -388,6 +423,8 @@ bool Processor::Network::WriteRegister(LFID fid, RemoteRegType kind, const RegAd
 bool Processor::Network::OnSync(LFID fid, PID completion_pid, RegIndex completion_reg)
 {
     Family& family = m_familyTable[fid];
+    COMMIT{ m_parent.RecordTimeline(Timeline::SYNC_REQUEST, fid, completion_pid); }
+
     if (family.link != INVALID_LFID)
     {
         // Forward the sync to the last core
@@ -539,7 +576,7 @@ Result Processor::Network::DoDelegationIn()
                 // Forward on link network
                 LinkMessage fwd;
                 fwd.type = LinkMessage::MSG_BALLOCATE;
-                fwd.ballocate.min_contexts   = used_contexts;
+                fwd.ballocate.min_cost       = GetPlacementCost(msg.allocate.completion_pid);
                 fwd.ballocate.min_pid        = m_parent.GetPID();
                 fwd.ballocate.size           = msg.allocate.place.size;
                 fwd.ballocate.suspend        = msg.allocate.suspend;
@@ -555,6 +592,7 @@ Result Processor::Network::DoDelegationIn()
             
             // We're below the threshold; allocate here as a place of one
             msg.allocate.type = ALLOCATE_SINGLE;
+            OnPlacement(m_parent.GetPID(), msg.allocate.completion_pid, true);
         }
 
         if (!m_allocator.QueueFamilyAllocation(msg, false))
@@ -765,15 +803,17 @@ Result Processor::Network::DoLink()
         unsigned used_contexts = m_familyTable.GetNumUsedFamilies(CONTEXT_NORMAL);
         if (used_contexts >= m_loadBalanceThreshold)
         {
+            // The placement policy decides which core is the minimum
+            unsigned cost = GetPlacementCost(msg.ballocate.completion_pid);
             if ((m_parent.GetPID() + 1) % msg.ballocate.size != 0)
             {
                 // Not the last core yet; forward the message
                 LinkMessage fwd(msg);
-                if (used_contexts <= fwd.ballocate.min_contexts)
+                if (cost <= fwd.ballocate.min_cost)
                 {
                     // This core's the new minimum
-                    fwd.ballocate.min_contexts = used_contexts;
-                    fwd.ballocate.min_pid      = m_parent.GetPID();
+                    fwd.ballocate.min_cost = cost;
+                    fwd.ballocate.min_pid  = m_parent.GetPID();
                 }
                 
                 if (!SendMessage(fwd))
@@ -784,11 +824,16 @@ Result Processor::Network::DoLink()
             }
             
             // Last core and we haven't met threshold, allocate on minimum
-            if (used_contexts > msg.ballocate.min_contexts)
+            if (cost > msg.ballocate.min_cost)
             {
                 // Minimum is not on this core, send it to the minimum
                 rmsg.allocate.place.pid = msg.ballocate.min_pid;
             }
+            OnPlacement(rmsg.allocate.place.pid, msg.ballocate.completion_pid, false);
+        }
+        else
+        {
+            OnPlacement(m_parent.GetPID(), msg.ballocate.completion_pid, true);
         }
         
         // Send a remote allocate as a place of one
@@ -1112,7 +1157,7 @@ string Processor::LinkMessage::str() const
         break;
     case MSG_BALLOCATE: 
         ss << "[ballocate"
-           << " minc " << ballocate.min_contexts
+           << " mcost " << ballocate.min_cost
            << " minp " << ballocate.min_pid
            << " psz " << ballocate.size
            << " susp " << ballocate.suspend
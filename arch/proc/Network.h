@@ -123,7 +123,7 @@ struct LinkMessage
 
         struct
         {
-            unsigned min_contexts;   ///< Minimum of contexts found so far
+            unsigned min_cost;       ///< Minimum placement cost found so far
             PID      min_pid;        ///< Core where the minimum was found
             PSize    size;           ///< Size of the place
             bool     suspend;        ///< Suspend until we get a context (only if exact)
@@ -287,6 +287,7 @@ public:
     };
     
     Network(const std::string& name, Processor& parent, Clock& clock, const std::vector<Processor*>& grid, Allocator& allocator, RegisterFile& regFile, FamilyTable& familyTable, Config& config);
+    ~Network();
     void Initialize(Network* prev, Network* next);
 
     bool SendMessage(const RemoteMessage& msg);
@@ -325,11 +326,19 @@ private:
     Network*                       m_next;
     const std::vector<Processor*>& m_grid;
     unsigned int                   m_loadBalanceThreshold;
+    IPlacementPolicy*              m_placement;     ///< Policy for balanced allocations
+
+    unsigned int GetPlacementCost(PID parent_pid) const;
+    void         OnPlacement(PID target_pid, PID parent_pid, bool threshold);
 
     // Statistics
     uint64_t                       m_numAllocates;
     uint64_t                       m_numBundles;
     uint64_t                       m_numCreates;
+    uint64_t                       m_numPlacements;          ///< Balanced allocations decided on this core
+    uint64_t                       m_numPlacementsLocal;     ///< ... that stayed on this core
+    uint64_t                       m_numPlacementsThreshold; ///< ... that were placed below the load balance threshold
+    uint64_t                       m_totalPlacementDistance; ///< Sum of the distances between parent and chosen core
 
 public:
     // Delegation network
@@ -36,6 +36,7 @@ Processor::Pipeline::Pipeline(
     Object(name, parent, clock),
     p_Pipeline(*this, "pipeline", delegate::create<Pipeline, &Processor::Pipeline::DoPipeline>(*this)),
     m_parent(parent),
+    m_profiler(parent.GetProfiler()),
     
     m_active("f_active", *this, clock),
     
@@ -170,6 +171,11 @@ Result Processor::Pipeline::DoPipeline()
                 // will never get executed now.
                 if (action == PIPE_STALL)
                 {
+                    if (m_profiler != NULL && IsChecking() && stage->input != NULL)
+                    {
+                        // Count the stall once per cycle, on the stalled instruction
+                        m_profiler->OnStall(stage->input->pc_dbg);
+                    }
                     stage->status = FAILED;
                     m_nStalls++;
                     DeadlockWrite("%s stage stalled", stage->stage->GetName().c_str());
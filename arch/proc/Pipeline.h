@@ -471,6 +471,7 @@ private:
     };
     
     Processor& m_parent;
+    Profiler*  m_profiler;  ///< The profiler of the core, or NULL
     
     FetchDecodeLatch                  m_fdLatch;
     DecodeReadLatch                   m_drLatch;
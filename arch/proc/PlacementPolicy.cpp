@@ -0,0 +1,128 @@
+#include "PlacementPolicy.h"
+#include "sim/config.h"
+#include "sim/except.h"
+#include <algorithm>
+
+/*
+  Selection of the core for a balanced family allocation.
+
+  A balanced allocation (ALLOCATE_BALANCED) walks the cores of the
+  place over the link network. Every core computes its cost with the
+  configured policy, and the family is allocated on the core with the
+  lowest cost, ties going to the later core. Cores below the
+  LoadBalanceThreshold still accept the family immediately.
+
+  The policies trade off how quickly a family can start against where
+  its threads will run:
+
+  - CONTEXTS spreads families over the cores with the fewest families;
+  - HEADROOM looks at the scarcest of the family table, thread table
+    and register file, so that families do not land on a core that has
+    a free family entry but no threads or registers to run them;
+  - ROUNDROBIN spreads families evenly over time, by the number of
+    families already created on each core;
+  - AFFINITY keeps families close to the core that created them, so
+    that with COMA they share the L2 cache of their parent, and only
+    moves them further away when the nearby cores are loaded.
+*/
+
+namespace Simulator
+{
+    class PolicyBase : public IPlacementPolicy
+    {
+    protected:
+        std::string m_name;
+    public:
+        PolicyBase(const std::string& name)
+            : m_name(name)
+        {}
+        std::string GetName() const { return m_name; }
+    };
+
+    // ContextsPolicy: the core with the fewest families in use
+    class ContextsPolicy : public PolicyBase
+    {
+    public:
+        ContextsPolicy()
+            : PolicyBase("fewest family contexts")
+        {}
+        unsigned int GetCost(const PlacementLoad& load) const
+        {
+            return load.used_families;
+        }
+    };
+
+    // HeadroomPolicy: the core with the lowest occupancy, in percent,
+    // of its most occupied resource
+    class HeadroomPolicy : public PolicyBase
+    {
+        static unsigned int Occupancy(size_t free, size_t total)
+        {
+            return (total == 0 || free >= total) ? 0 : (unsigned int)(100 * (total - free) / total);
+        }
+    public:
+        HeadroomPolicy()
+            : PolicyBase("most family/thread/register headroom")
+        {}
+        unsigned int GetCost(const PlacementLoad& load) const
+        {
+            unsigned int cost = Occupancy(load.num_families - load.used_families, load.num_families);
+            cost = std::max(cost, Occupancy(load.free_threads,  load.num_threads));
+            cost = std::max(cost, Occupancy(load.free_contexts, load.num_contexts));
+            return cost;
+        }
+    };
+
+    // RoundRobinPolicy: the core that has created the fewest families
+    class RoundRobinPolicy : public PolicyBase
+    {
+    public:
+        RoundRobinPolicy()
+            : PolicyBase("round-robin by families created")
+        {}
+        unsigned int GetCost(const PlacementLoad& load) const
+        {
+            return load.num_created;
+        }
+    };
+
+    // AffinityPolicy: the core in the nearest group of cores that share
+    // an L2 cache with the parent, then the fewest families in use
+    class AffinityPolicy : public PolicyBase
+    {
+        size_t m_groupSize;
+    public:
+        AffinityPolicy(size_t groupSize)
+            : PolicyBase("nearest to parent's cache group"),
+              m_groupSize(groupSize)
+        {}
+        unsigned int GetCost(const PlacementLoad& load) const
+        {
+            const size_t group  = load.pid / m_groupSize;
+            const size_t parent = load.parent_pid / m_groupSize;
+            const size_t distance = (group > parent) ? group - parent : parent - group;
+            return distance * (load.num_families + 1) + load.used_families;
+        }
+    };
+
+    IPlacementPolicy* IPlacementPolicy::makePolicy(Object& parent, const std::string& name, Config& config)
+    {
+        if (name == "CONTEXTS")        { return new ContextsPolicy(); }
+        else if (name == "HEADROOM")   { return new HeadroomPolicy(); }
+        else if (name == "ROUNDROBIN") { return new RoundRobinPolicy(); }
+        else if (name == "AFFINITY")
+        {
+            size_t groupSize = config.getValueOrDefault<size_t>(parent, "PlacementGroupSize", config.getValueOrDefault<size_t>("NumClientsPerL2Cache", 1));
+            if (groupSize == 0)
+            {
+                throw exceptf<InvalidArgumentException>(parent, "PlacementGroupSize must be at least 1");
+            }
+            return new AffinityPolicy(groupSize);
+        }
+        else
+        {
+            throw exceptf<InvalidArgumentException>(parent, "Unknown placement policy: %s", name.c_str());
+        }
+    }
+
+}
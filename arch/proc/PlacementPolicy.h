@@ -0,0 +1,41 @@
+#ifndef PLACEMENT_POLICY_H
+#define PLACEMENT_POLICY_H
+
+#include "sim/kernel.h"
+#include "arch/simtypes.h"
+
+class Config;
+
+namespace Simulator
+{
+
+    /// The state of a core as seen by the balanced family allocation
+    struct PlacementLoad
+    {
+        PID     pid;            ///< The core being considered
+        PID     parent_pid;     ///< The core that issued the allocation
+        FSize   used_families;  ///< Number of family contexts in use
+        FSize   num_families;   ///< Number of normal family contexts
+        TSize   free_threads;   ///< Number of free thread entries
+        TSize   num_threads;    ///< Size of the thread table
+        RegSize free_contexts;  ///< Number of free register contexts
+        RegSize num_contexts;   ///< Number of register contexts
+        FSize   num_created;    ///< Number of families created on this core so far
+    };
+
+    class IPlacementPolicy {
+    public:
+
+        // Cost of placing a family on the core with the given load.
+        // A balanced allocation goes to the core with the lowest cost in the place.
+        virtual unsigned int GetCost(const PlacementLoad& load) const = 0;
+
+        virtual std::string GetName() const = 0;
+        virtual ~IPlacementPolicy() {};
+
+        static IPlacementPolicy* makePolicy(Object& parent, const std::string& name, Config& config);
+    };
+
+}
+
+#endif
@@ -18,6 +18,8 @@ namespace Simulator
 Processor::Processor(const std::string& name, Object& parent, Clock& clock, PID pid, const vector<Processor*>& grid, IMemory& memory, IMemoryAdmin& admin, FPU& fpu, IIOBus *iobus, Config& config)
 :   Object(name, parent, clock),
     m_pid(pid), m_memory(memory), m_memadmin(admin), m_grid(grid), m_fpu(fpu),
+    m_profiler(config.getValueOrDefault<bool>(*this, "EnableProfiler", false) ? new Profiler(*this) : NULL),
+    m_timeline(NULL),
     m_familyTable ("families",      *this, clock, config),
     m_threadTable ("threads",       *this, clock, config),
     m_registerFile("registers",     *this, clock, m_allocator, config),
@@ -79,6 +81,7 @@ Processor::Processor(const std::string& name, Object& parent, Clock& clock, PID
 Processor::~Processor()
 {
     delete m_io_if;
+    delete m_profiler;
 }
 
 void Processor::Initialize(Processor* prev, Processor* next)
@@ -2,11 +2,20 @@
 #define PROCESSOR_H
 
 #include "sim/inspect.h"
+#include "sim/histogram.h"
 #include "arch/IOBus.h"
 #include "arch/Memory.h"
 #include "arch/BankSelector.h"
+#include "arch/CacheTags.h"
+#include "arch/MissClassifier.h"
+#include "arch/Timeline.h"
+#include "PlacementPolicy.h"
+
+#include <deque>
+#include <map>
 
 class Config;
+class SymbolTable;
 
 namespace Simulator
 {
@@ -17,6 +26,7 @@ class Processor : public Object
 {
 public:
     class Allocator;
+    class Profiler;
 
 #include "FamilyTable.h"
 #include "ThreadTable.h"
@@ -32,6 +42,7 @@ public:
 #include "RAUnit.h"
 #include "Allocator.h"
 #include "PerfCounters.h"
+#include "Profiler.h"
 
     Processor(const std::string& name, Object& parent, Clock& clock, PID pid, const std::vector<Processor*>& grid, IMemory& memory, IMemoryAdmin& admin, FPU& fpu, IIOBus *iobus, Config& config);
     ~Processor();
@@ -95,6 +106,18 @@ public:
     RegisterFile& GetRegisterFile() { return m_registerFile; }
     ICache& GetICache() { return m_icache; }
     DCache& GetDCache() { return m_dcache; }
+    Profiler* GetProfiler() const { return m_profiler; }
+
+    void SetTimeline(Timeline* timeline) { m_timeline = timeline; }
+
+    // Records an event of the core on the timeline, if there is one
+    void RecordTimeline(Timeline::EventType type, unsigned int id, uint64_t arg = 0)
+    {
+        if (m_timeline != NULL)
+        {
+            m_timeline->Record(GetCycleNo(), m_pid, type, id, arg);
+        }
+    }
 
 private:
     PID                            m_pid;
@@ -111,6 +134,10 @@ private:
         unsigned int tid_bits;  ///< Number of bits for a TID (Thread ID)
     } m_bits;
     
+    // The profiler, if enabled; before the components that use it
+    Profiler*             m_profiler;
+    Timeline*             m_timeline;   ///< The timeline of the system, or NULL
+
     // The components on the core
     FamilyTable           m_familyTable;
     ThreadTable           m_threadTable;
@@ -0,0 +1,111 @@
+#include "Processor.h"
+#include "symtable.h"
+
+#include <iomanip>
+
+using namespace std;
+
+namespace Simulator
+{
+
+Processor::Profiler::Costs& Processor::Profiler::Costs::operator+=(const Costs& c)
+{
+    instructions += c.instructions;
+    stalls       += c.stalls;
+    dmisses      += c.dmisses;
+    suspended    += c.suspended;
+    return *this;
+}
+
+static ostream& operator<<(ostream& out, const Processor::Profiler::Costs& c)
+{
+    return out << c.instructions << ' ' << c.stalls << ' ' << c.dmisses << ' ' << c.suspended;
+}
+
+void Processor::Profiler::OnSuspend(TID tid, MemAddr pc, CycleNo now)
+{
+    if (tid >= m_suspended.size())
+    {
+        const Suspension none = {false, 0, 0};
+        m_suspended.resize(tid + 1, none);
+    }
+
+    Suspension& s = m_suspended[tid];
+    s.valid = true;
+    s.pc    = pc;
+    s.since = now;
+}
+
+// Called for every thread that becomes ready; only threads that were
+// suspended on a register have a suspension in progress
+void Processor::Profiler::OnActivate(TID tid, CycleNo now)
+{
+    if (tid < m_suspended.size() && m_suspended[tid].valid)
+    {
+        Suspension& s = m_suspended[tid];
+        m_costs[s.pc].suspended += now - s.since;
+        s.valid = false;
+    }
+}
+
+Processor::Profiler::Costs Processor::Profiler::GetTotals() const
+{
+    Costs totals;
+    for (CostMap::const_iterator p = m_costs.begin(); p != m_costs.end(); ++p)
+    {
+        totals += p->second;
+    }
+    return totals;
+}
+
+/*static*/ void Processor::Profiler::WriteHeader(ostream& out, const Costs& totals)
+{
+    out << "# callgrind format" << endl
+        << "version: 1" << endl
+        << "creator: " << PACKAGE_STRING << endl
+        << "positions: instr" << endl
+        << "event: Instr : Instructions executed" << endl
+        << "event: Stall : Pipeline stall cycles" << endl
+        << "event: DMiss : D-cache read misses" << endl
+        << "event: Susp : Cycles suspended on registers" << endl
+        << "events: Instr Stall DMiss Susp" << endl
+        << "summary: " << totals << endl;
+}
+
+void Processor::Profiler::Write(ostream& out, const SymbolTable& symtable) const
+{
+    if (m_costs.empty())
+    {
+        // The core did nothing
+        return;
+    }
+
+    out << endl << "ob=" << m_parent.GetFQN() << endl
+        << "fl=???" << endl;
+
+    // The PCs are in order, so the PCs of a function are together
+    bool    first = true;
+    MemAddr start = 0;
+    string  name;
+    for (CostMap::const_iterator p = m_costs.begin(); p != m_costs.end(); ++p)
+    {
+        MemAddr sym_start;
+        string  sym;
+        if (!symtable.FindEnclosing(p->first, sym_start, sym))
+        {
+            sym_start = 0;
+            sym       = "???";
+        }
+
+        if (first || sym_start != start || sym != name)
+        {
+            out << "fn=" << sym << endl;
+            first = false;
+            start = sym_start;
+            name  = sym;
+        }
+        out << "0x" << hex << p->first << dec << ' ' << p->second << endl;
+    }
+}
+
+}
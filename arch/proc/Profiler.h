@@ -0,0 +1,60 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifndef PROCESSOR_H
+#error This file should be included in Processor.h
+#endif
+
+/// Profiler: counts, per PC, the instructions that the pipeline
+/// executed, the cycles that it stalled on them, their D-cache read
+/// misses and the cycles that their threads were suspended on a
+/// register they read. The core only has one when EnableProfiler is
+/// set; the components check for it, so otherwise it costs nothing.
+/// At the end of the simulation the costs of all cores are written
+/// in the callgrind format, with one object per core.
+class Profiler
+{
+public:
+    struct Costs
+    {
+        uint64_t instructions; ///< Instructions executed
+        uint64_t stalls;       ///< Cycles the pipeline stalled on the instruction
+        uint64_t dmisses;      ///< D-cache read misses
+        uint64_t suspended;    ///< Cycles the thread was suspended on a register
+
+        Costs& operator+=(const Costs& c);
+        Costs() : instructions(0), stalls(0), dmisses(0), suspended(0) {}
+    };
+
+    void OnExecute(MemAddr pc)     { ++m_costs[pc].instructions; }
+    void OnStall(MemAddr pc)       { ++m_costs[pc].stalls; }
+    void OnDCacheMiss(MemAddr pc)  { ++m_costs[pc].dmisses; }
+    void OnSuspend(TID tid, MemAddr pc, CycleNo now);
+    void OnActivate(TID tid, CycleNo now);
+
+    Costs GetTotals() const;
+
+    /// Writes the callgrind header for the totals of all cores
+    static void WriteHeader(std::ostream& out, const Costs& totals);
+
+    /// Writes the costs of this core, by function
+    void Write(std::ostream& out, const SymbolTable& symtable) const;
+
+    Profiler(const Processor& parent) : m_parent(parent) {}
+
+private:
+    struct Suspension
+    {
+        bool    valid;
+        MemAddr pc;     ///< Instruction that read the register
+        CycleNo since;
+    };
+
+    typedef std::map<MemAddr, Costs> CostMap;
+
+    const Processor&        m_parent;
+    CostMap                 m_costs;
+    std::vector<Suspension> m_suspended;  ///< Per thread; the suspension in progress
+};
+
+#endif
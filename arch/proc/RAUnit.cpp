@@ -3,14 +3,23 @@
 #include "sim/log2.h"
 #include <cassert>
 #include <iomanip>
+#include <algorithm>
 using namespace std;
 
 namespace Simulator
 {
 
 Processor::RAUnit::RAUnit(const std::string& name, Processor& parent, Clock& clock, const RegisterFile& regFile, Config& config)
-    : Object(name, parent, clock)
+    : Object(name, parent, clock),
+      m_numFailedAllocs(0),
+      m_numFragmentedAllocs(0)
 {
+    const string strategy = config.getValueOrDefault<string>(*this, "AllocationStrategy", "FIRSTFIT");
+    if      (strategy == "FIRSTFIT") m_strategy = STRATEGY_FIRSTFIT;
+    else if (strategy == "BESTFIT")  m_strategy = STRATEGY_BESTFIT;
+    else if (strategy == "BUDDY")    m_strategy = STRATEGY_BUDDY;
+    else throw exceptf<InvalidArgumentException>(*this, "Unknown register allocation strategy: %s", strategy.c_str());
+
     static struct RegTypeInfo {
         const char* blocksize_name;
         RegSize     context_size;
@@ -56,7 +65,162 @@ Processor::RAUnit::RAUnit(const std::string& name, Processor& parent, Clock& clo
         type.free[CONTEXT_EXCLUSIVE] = 1;
         
         type.list.resize(free_blocks, List::value_type(0, INVALID_LFID));
+        UpdateFragmentation(type);
     }
+
+    RegisterSampleVariableInObjectWithName(m_types[RT_INTEGER].largestFree,   "intLargestFree",   SVC_LEVEL);
+    RegisterSampleVariableInObjectWithName(m_types[RT_INTEGER].fragmentation, "intFragmentation", SVC_LEVEL);
+    RegisterSampleVariableInObjectWithName(m_types[RT_FLOAT].largestFree,     "fltLargestFree",   SVC_LEVEL);
+    RegisterSampleVariableInObjectWithName(m_types[RT_FLOAT].fragmentation,   "fltFragmentation", SVC_LEVEL);
+    RegisterSampleVariableInObject(m_numFailedAllocs, SVC_CUMULATIVE);
+    RegisterSampleVariableInObject(m_numFragmentedAllocs, SVC_CUMULATIVE);
+}
+
+// Returns the number of consecutive free blocks starting at pos,
+// which must not lie inside an allocated area
+Processor::RAUnit::BlockSize Processor::RAUnit::GetFreeRun(const TypeInfo& type, BlockIndex pos) const
+{
+    BlockIndex end = pos;
+    while (end < type.list.size() && type.list[end].first == 0)
+    {
+        ++end;
+    }
+    return end - pos;
+}
+
+// Returns the block index of a free area of size blocks, or
+// INVALID_REG_INDEX if no such area exists.
+Processor::RAUnit::BlockIndex Processor::RAUnit::FindFreeArea(const TypeInfo& type, BlockSize size) const
+{
+    const BlockSize num_blocks = type.list.size();
+    switch (m_strategy)
+    {
+    case STRATEGY_FIRSTFIT:
+        for (BlockIndex pos = 0; pos < num_blocks;)
+        {
+            if (type.list[pos].first != 0)
+            {
+                // Used area, skip past it
+                pos += type.list[pos].first;
+            }
+            else
+            {
+                // Free area, check size
+                BlockSize run = GetFreeRun(type, pos);
+                if (run >= size)
+                {
+                    return pos;
+                }
+                pos += run;
+            }
+        }
+        break;
+
+    case STRATEGY_BESTFIT:
+    {
+        BlockIndex best     = INVALID_REG_INDEX;
+        BlockSize  best_run = 0;
+        for (BlockIndex pos = 0; pos < num_blocks;)
+        {
+            if (type.list[pos].first != 0)
+            {
+                pos += type.list[pos].first;
+            }
+            else
+            {
+                BlockSize run = GetFreeRun(type, pos);
+                if (run >= size && (best == INVALID_REG_INDEX || run < best_run))
+                {
+                    best     = pos;
+                    best_run = run;
+                    if (run == size)
+                    {
+                        // Can't do better than an exact fit
+                        break;
+                    }
+                }
+                pos += run;
+            }
+        }
+        return best;
+    }
+
+    case STRATEGY_BUDDY:
+    {
+        // The size has been rounded up to a power of two. Of all free
+        // aligned areas of that size, take the one in the smallest free
+        // buddy, so that larger buddies are kept whole.
+        assert(IsPowerOfTwo(size));
+
+        // Only the first block of an allocated area is marked in the
+        // list, so expand the list into a per-block map first.
+        std::vector<bool>& used = m_used;
+        used.assign(num_blocks, false);
+        for (BlockIndex pos = 0; pos < num_blocks; ++pos)
+        {
+            for (BlockSize j = 0; j < type.list[pos].first; ++j)
+            {
+                used[pos + j] = true;
+            }
+        }
+
+        BlockIndex best       = INVALID_REG_INDEX;
+        BlockSize  best_buddy = 0;
+        for (BlockIndex pos = 0; pos + size <= num_blocks; pos += size)
+        {
+            if (std::find(used.begin() + pos, used.begin() + pos + size, true) != used.begin() + pos + size)
+            {
+                continue;
+            }
+
+            // Grow the buddy while it stays free and aligned
+            BlockSize buddy = size;
+            while (buddy * 2 <= num_blocks)
+            {
+                BlockIndex base = pos & ~(buddy * 2 - 1);
+                if (base + buddy * 2 > num_blocks ||
+                    std::find(used.begin() + base, used.begin() + base + buddy * 2, true) != used.begin() + base + buddy * 2)
+                {
+                    break;
+                }
+                buddy *= 2;
+            }
+
+            if (best == INVALID_REG_INDEX || buddy < best_buddy)
+            {
+                best       = pos;
+                best_buddy = buddy;
+                if (buddy == size)
+                {
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+    }
+    return INVALID_REG_INDEX;
+}
+
+void Processor::RAUnit::UpdateFragmentation(TypeInfo& type)
+{
+    BlockSize total = 0, largest = 0;
+    for (BlockIndex pos = 0; pos < type.list.size();)
+    {
+        if (type.list[pos].first != 0)
+        {
+            pos += type.list[pos].first;
+        }
+        else
+        {
+            BlockSize run = GetFreeRun(type, pos);
+            total  += run;
+            largest = std::max(largest, run);
+            pos    += run;
+        }
+    }
+    type.largestFree   = largest;
+    type.fragmentation = (total == 0) ? 0.0f : 1.0f - (float)largest / (float)total;
 }
 
 Processor::RAUnit::BlockSize Processor::RAUnit::GetNumFreeContexts(ContextType type) const
@@ -70,6 +234,17 @@ Processor::RAUnit::BlockSize Processor::RAUnit::GetNumFreeContexts(ContextType t
     return free;
 }
 
+Processor::RAUnit::BlockSize Processor::RAUnit::GetNumContexts() const
+{
+    // One block of each type is set aside for the exclusive context
+    BlockSize num = m_types[0].list.size() - 1;
+    for (size_t i = 1; i < NUM_REG_TYPES; ++i)
+    {
+        num = std::min<BlockSize>(num, m_types[i].list.size() - 1);
+    }
+    return num;
+}
+
 void Processor::RAUnit::ReserveContext()
 {
     // Move a normal context to reserved
@@ -96,9 +271,10 @@ void Processor::RAUnit::UnreserveContext()
     }
 }
 
-bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, ContextType context, RegIndex indices[NUM_REG_TYPES])
+bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, ContextType context, RegIndex indices[NUM_REG_TYPES], bool& fragmented)
 {
     BlockSize blocksizes[NUM_REG_TYPES];
+    fragmented = false;
     
     for (size_t i = 0; i < NUM_REG_TYPES; ++i)
     {
@@ -108,7 +284,13 @@ bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, Cont
         if (sizes[i] != 0)
         {
             // Get number of blocks (round up to nearest block size)
-            BlockSize size = blocksizes[i] = (sizes[i] + type.blockSize - 1) / type.blockSize;
+            BlockSize size = (sizes[i] + type.blockSize - 1) / type.blockSize;
+            if (m_strategy == STRATEGY_BUDDY)
+            {
+                // Buddies come in powers of two
+                size = (BlockSize)1 << ilog2(size);
+            }
+            blocksizes[i] = size;
 
             // Check if have enough blocks free to even start looking
             BlockSize free = type.free[CONTEXT_NORMAL];
@@ -122,32 +304,18 @@ bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, Cont
             if (free >= size)
             {
                 // We have enough free space, find a contiguous free area of specified size
-                for (RegIndex pos = 0; pos < type.list.size() && indices[i] == INVALID_REG_INDEX;)
+                BlockIndex pos = FindFreeArea(type, size);
+                if (pos != INVALID_REG_INDEX)
                 {
-                    if (type.list[pos].first != 0)
-                    {
-                        // Used area, skip past it
-                        pos += type.list[pos].first;
-                    }
-                    else
-                    {
-                        // Free area, check size
-                        for (RegIndex start = pos; pos < type.list.size() && type.list[pos].first == 0; ++pos)
-                        {
-                            if (pos - start + 1 == size)
-                            {
-                                // We found a free area, store it's base register index
-                                indices[i] = start * type.blockSize;
-                                break;
-                            }
-                        }
-                    }
+                    indices[i] = pos * type.blockSize;
                 }
             }
             
             if (indices[i] == INVALID_REG_INDEX)
             {
-                // Couldn't get a block for this type
+                // Couldn't get a block for this type.
+                // The caller may retry with fewer registers, so it counts the failure.
+                fragmented = (free >= size);
                 return false;
             }
         }
@@ -177,6 +345,7 @@ bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, Cont
                 }
                 assert(type.free[CONTEXT_NORMAL] >= size);
                 type.free[CONTEXT_NORMAL] -= size;
+                UpdateFragmentation(type);
             }
             else if (context == CONTEXT_RESERVED)
             {
@@ -190,6 +359,15 @@ bool Processor::RAUnit::Alloc(const RegSize sizes[NUM_REG_TYPES], LFID fid, Cont
     return true;
 }
 
+void Processor::RAUnit::OnAllocFailed(bool fragmented)
+{
+    ++m_numFailedAllocs;
+    if (fragmented)
+    {
+        ++m_numFragmentedAllocs;
+    }
+}
+
 void Processor::RAUnit::Free(RegIndex indices[NUM_REG_TYPES], ContextType context)
 {
     for (size_t i = 0; i < NUM_REG_TYPES; ++i)
@@ -215,6 +393,7 @@ void Processor::RAUnit::Free(RegIndex indices[NUM_REG_TYPES], ContextType contex
                 }
                 type.free[CONTEXT_NORMAL] += size;
                 type.list[index].first = 0;
+                UpdateFragmentation(type);
             }
         }
     }
@@ -269,8 +448,17 @@ void Processor::RAUnit::Cmd_Read(ostream& out, const vector<string>& /*arguments
             << type.free[CONTEXT_NORMAL] << " normal, "
             << type.free[CONTEXT_RESERVED] << " reserved, "
             << type.free[CONTEXT_EXCLUSIVE] << " exclusive"
+            << endl
+            << "Largest free " << TypeName[i] << " area: " << type.largestFree << " blocks"
+            << " (fragmentation " << setprecision(2) << fixed << type.fragmentation << ")"
             << endl;
     }
+
+    static const char* StrategyNames[] = {"first-fit", "best-fit", "buddy"};
+    out << endl
+        << "Allocation strategy: " << StrategyNames[m_strategy] << endl
+        << "Failed allocations: " << m_numFailedAllocs
+        << " (" << m_numFragmentedAllocs << " with enough free blocks)" << endl;
 }
 
 }
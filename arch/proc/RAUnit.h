@@ -22,12 +22,16 @@ public:
      * \param fid[in]      Family that makes the request. For debugging purposes only.
      * \param reserved[in] Whether we're allocating a reserved context at least.
      * \param indices[out] Array that will receive the base indices of the allocated registers.
+     * \param fragmented[out] On failure, whether enough blocks were free but not contiguous.
      * \return false if not enough register were available
      * \details A context can be reserved with ReserveContext. Allocating registers with reserved false will
      *      only allocate the registers if all reserved contexts can remain available. If reserved is true,
      *      at least one reserved context worth of register is considered for allocation as well.
      */
-    bool Alloc(const RegSize size[NUM_REG_TYPES], LFID fid, ContextType context, RegIndex indices[NUM_REG_TYPES]);
+    bool Alloc(const RegSize size[NUM_REG_TYPES], LFID fid, ContextType context, RegIndex indices[NUM_REG_TYPES], bool& fragmented);
+
+    /// Counts a family that got no registers, once per family
+    void OnAllocFailed(bool fragmented);
     
     /**
      * \brief Frees the allocated registers
@@ -37,6 +41,9 @@ public:
     
     /// Returns the maximum number of contexts still available
     BlockSize GetNumFreeContexts(ContextType type) const;
+
+    /// Returns the number of normal contexts when all registers are free
+    BlockSize GetNumContexts() const;
     
     /// Reserves a context for future allocation
     void ReserveContext();
@@ -49,13 +56,36 @@ public:
     void Cmd_Read(std::ostream& out, const std::vector<std::string>& arguments) const;
 
 private:
+    /// How a free area is chosen for an allocation
+    enum Strategy
+    {
+        STRATEGY_FIRSTFIT,  ///< First free area that fits
+        STRATEGY_BESTFIT,   ///< Smallest free area that fits
+        STRATEGY_BUDDY,     ///< Power-of-two sizes at aligned positions, smallest buddy first
+    };
+
     struct TypeInfo
     {
         List      list;                     ///< The list of blocks for administration
         RegSize   blockSize;                ///< Blocksize for this register type
         BlockSize free[NUM_CONTEXT_TYPES];  ///< Number of free blocks
+
+        // Statistics
+        BlockSize largestFree;              ///< Largest contiguous free area, in blocks
+        float     fragmentation;            ///< 1 - largest free area / total free blocks
     };
+
+    BlockIndex FindFreeArea(const TypeInfo& type, BlockSize size) const;
+    BlockSize  GetFreeRun(const TypeInfo& type, BlockIndex pos) const;
+    void       UpdateFragmentation(TypeInfo& type);
+
     TypeInfo m_types[NUM_REG_TYPES];
+    Strategy m_strategy;
+    mutable std::vector<bool> m_used;   ///< Scratch per-block map for FindFreeArea with BUDDY
+
+    // Statistics
+    uint64_t m_numFailedAllocs;     ///< Families that did not get registers at the first attempt
+    uint64_t m_numFragmentedAllocs; ///< ... while enough blocks were free
 };
 
 #endif
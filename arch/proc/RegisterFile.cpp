@@ -2,12 +2,81 @@
 #include "sim/config.h"
 #include "sim/range.h"
 #include <cassert>
+#include <algorithm>
 #include <iomanip>
 using namespace std;
 
 namespace Simulator
 {
 
+//
+// Register storage
+//
+
+void Processor::RegisterFile::Metadata::Clear()
+{
+    // Same as MAKE_EMPTY_REG(), but without undefined fields
+    waiting.head       = INVALID_TID;
+    waiting.tail       = INVALID_TID;
+    memory.fid         = INVALID_LFID;
+    memory.offset      = 0;
+    memory.size        = 0;
+    memory.sign_extend = false;
+    memory.next        = INVALID_REG;
+}
+
+void Processor::RegisterFile::File::Resize(RegSize size)
+{
+    Metadata empty;
+    empty.Clear();
+
+    // Initialize all registers to empty
+    values.clear();
+    values.resize(size, 0);
+    states.clear();
+    states.resize(size, RST_EMPTY);
+    metadata.clear();
+    metadata.resize(size, empty);
+}
+
+void Processor::RegisterFile::File::Load(RegType type, RegIndex index, RegValue& value) const
+{
+    value.m_state = (RegState)states[index];
+    if (value.m_state == RST_FULL)
+    {
+        if (type == RT_FLOAT) {
+            value.m_float.integer = values[index];
+        } else {
+            value.m_integer = values[index];
+        }
+    }
+    else
+    {
+        value.m_waiting = metadata[index].waiting;
+        value.m_memory  = metadata[index].memory;
+    }
+}
+
+void Processor::RegisterFile::File::Store(RegType type, RegIndex index, const RegValue& value)
+{
+    states[index] = (unsigned char)value.m_state;
+    if (value.m_state == RST_FULL)
+    {
+        values[index] = (type == RT_FLOAT) ? (Integer)value.m_float.integer : value.m_integer;
+    }
+    else if (value.m_waiting.head != INVALID_TID || value.m_memory.size != 0)
+    {
+        Metadata& meta = metadata[index];
+        meta.waiting = value.m_waiting;
+        meta.memory  = value.m_memory;
+    }
+    else
+    {
+        // MAKE_EMPTY_REG() leaves the other fields undefined
+        metadata[index].Clear();
+    }
+}
+
 //
 // RegisterFile implementation
 //
@@ -22,21 +91,11 @@ Processor::RegisterFile::RegisterFile(const std::string& name, Processor& parent
     p_asyncR    (*this, "p_asyncR"),
     p_asyncW    (*this, "p_asyncW"),
     m_parent(parent), m_allocator(alloc),
-    m_nUpdates(0),
-    m_integers(config.getValue<size_t>(*this, "NumIntRegisters")),
-    m_floats  (config.getValue<size_t>(*this, "NumFltRegisters"))
+    m_nUpdates(0)
 {
-    // Initialize all registers to empty
-    for (RegSize i = 0; i < m_integers.size(); ++i)
-    {
-        m_integers[i] = MAKE_EMPTY_REG();
-    }
+    m_integers.Resize(config.getValue<size_t>(*this, "NumIntRegisters"));
+    m_floats  .Resize(config.getValue<size_t>(*this, "NumFltRegisters"));
 
-    for (RegSize i = 0; i < m_floats.size(); ++i)
-    {
-        m_floats[i] = MAKE_EMPTY_REG();
-    }
-    
     // Set port priorities; first port has highest priority
     AddPort(p_pipelineW);
     AddPort(p_asyncW);
@@ -44,18 +103,17 @@ Processor::RegisterFile::RegisterFile(const std::string& name, Processor& parent
 
 RegSize Processor::RegisterFile::GetSize(RegType type) const
 {
-    const vector<RegValue>& regs = PickFile(type);
-    return regs.size();
+    return PickFile(type).size();
 }
 
 bool Processor::RegisterFile::ReadRegister(const RegAddr& addr, RegValue& data, bool quiet) const
 {
-    const vector<RegValue>& regs = PickFile(addr.type);
+    const File& regs = PickFile(addr.type);
     if (addr.index >= regs.size())
     {
         throw SimulationException("A component attempted to read from a non-existing register", *this);
     }
-    data = regs[addr.index];
+    regs.Load(addr.type, addr.index, data);
 
     if (!quiet)
         DebugRegWrite("read  %s -> %s", addr.str().c_str(), data.str(addr.type).c_str());
@@ -66,13 +124,18 @@ bool Processor::RegisterFile::ReadRegister(const RegAddr& addr, RegValue& data,
 // Admin version
 bool Processor::RegisterFile::WriteRegister(const RegAddr& addr, const RegValue& data)
 {
-    vector<RegValue>& regs = PickFile(addr.type);
+    File& regs = PickFile(addr.type);
     if (addr.index < regs.size())
     {
-        DebugRegWrite("write %s <- %s (was %s, ADMIN)", addr.str().c_str(), 
-                      data.str(addr.type).c_str(),
-                      regs[ addr.index ].str(addr.type).c_str());
-        regs[addr.index] = data;
+        if (GetKernel()->GetDebugMode() & Kernel::DEBUG_REG)
+        {
+            RegValue old;
+            regs.Load(addr.type, addr.index, old);
+            DebugRegWrite("write %s <- %s (was %s, ADMIN)", addr.str().c_str(),
+                          data.str(addr.type).c_str(),
+                          old.str(addr.type).c_str());
+        }
+        regs.Store(addr.type, addr.index, data);
         return true;
     }
     return false;
@@ -80,7 +143,7 @@ bool Processor::RegisterFile::WriteRegister(const RegAddr& addr, const RegValue&
 
 bool Processor::RegisterFile::Clear(const RegAddr& addr, RegSize size)
 {
-    std::vector<RegValue>& regs = PickFile(addr.type);
+    File& regs = PickFile(addr.type);
     if (addr.index + size > regs.size())
     {
         throw SimulationException("A component attempted to clear a non-existing register", *this);
@@ -88,10 +151,10 @@ bool Processor::RegisterFile::Clear(const RegAddr& addr, RegSize size)
 
     COMMIT
     {
-        const RegValue value = MAKE_EMPTY_REG();
+        std::fill(regs.states.begin() + addr.index, regs.states.begin() + addr.index + size, (unsigned char)RST_EMPTY);
         for (RegSize i = 0; i < size; ++i)
         {
-            regs[addr.index + i] = value;
+            regs.metadata[addr.index + i].Clear();
         }
     }
 
@@ -100,7 +163,7 @@ bool Processor::RegisterFile::Clear(const RegAddr& addr, RegSize size)
 
 bool Processor::RegisterFile::WriteRegister(const RegAddr& addr, const RegValue& data, bool from_memory)
 {
-    std::vector<RegValue>& regs = PickFile(addr.type);
+    const File& regs = PickFile(addr.type);
     if (addr.index >= regs.size())
     {
         throw SimulationException("A component attempted to write to a non-existing register", *this);
@@ -113,7 +176,8 @@ bool Processor::RegisterFile::WriteRegister(const RegAddr& addr, const RegValue&
         assert(data.m_waiting.head == INVALID_TID);
     }
 
-    const RegValue& value = regs[addr.index];
+    RegValue value;
+    regs.Load(addr.type, addr.index, value);
     if (value.m_state != RST_FULL)
     {
         if (value.m_state == RST_WAITING && data.m_state == RST_EMPTY)
@@ -183,13 +247,18 @@ void Processor::RegisterFile::Update()
     {
         RegAddr& addr = m_updates[i].first;
         RegType type = addr.type;
-        vector<RegValue>& regs = PickFile(type);
+        File& regs = PickFile(type);
 
-        DebugRegWrite("write %s <- %s (was %s)", addr.str().c_str(), 
-                      m_updates[i].second.str(type).c_str(),
-                      regs[ addr.index ].str(type).c_str());
+        if (GetKernel()->GetDebugMode() & Kernel::DEBUG_REG)
+        {
+            RegValue old;
+            regs.Load(type, addr.index, old);
+            DebugRegWrite("write %s <- %s (was %s)", addr.str().c_str(),
+                          m_updates[i].second.str(type).c_str(),
+                          old.str(type).c_str());
+        }
 
-        regs[ addr.index ] = m_updates[i].second;
+        regs.Store(type, addr.index, m_updates[i].second);
     }
     m_nUpdates = 0;
 }
@@ -105,8 +105,35 @@ private:
 
     // Applies the queued updates
     void Update();
-    
-    std::vector<RegValue>& PickFile(RegType t)
+
+    // Waiting and memory information of a register that is not full
+    struct Metadata
+    {
+        ThreadQueue   waiting;
+        MemoryRequest memory;
+
+        void Clear();
+    };
+
+    /*
+     * A register file is stored as separate arrays of value bits, states
+     * and waiting/memory information, instead of an array of RegValues,
+     * so that the pipeline's reads of full registers only touch the
+     * value and state arrays.
+     */
+    struct File
+    {
+        std::vector<Integer>       values;   ///< Value bits of full registers
+        std::vector<unsigned char> states;   ///< RegState of every register
+        std::vector<Metadata>      metadata; ///< Waiting and memory information of non-full registers
+
+        RegSize size() const { return states.size(); }
+        void    Load (RegType type, RegIndex index, RegValue& value) const;
+        void    Store(RegType type, RegIndex index, const RegValue& value);
+        void    Resize(RegSize size);
+    };
+
+    File& PickFile(RegType t)
     {
         switch(t)
         {
@@ -115,7 +142,7 @@ private:
         default: assert(0);
         }
     }
-    const std::vector<RegValue>& PickFile(RegType t) const
+    const File& PickFile(RegType t) const
     {
         switch(t)
         {
@@ -125,8 +152,8 @@ private:
         }
     }
 
-    std::vector<RegValue> m_integers; ///< Integer register file
-    std::vector<RegValue> m_floats;   ///< Floating point register file    
+    File m_integers; ///< Integer register file
+    File m_floats;   ///< Floating point register file
 };
 
 #endif
@@ -270,6 +270,15 @@ Processor::Pipeline::PipeAction Processor::Pipeline::WritebackStage::OnCycle()
                                   m_input.pc_sym);
                     return PIPE_STALL;
                 }
+
+                COMMIT
+                {
+                    if (m_parent.m_profiler != NULL && m_input.suspend == SUSPEND_MISSING_DATA)
+                    {
+                        // Until a register write wakes up the thread again
+                        m_parent.m_profiler->OnSuspend(m_input.tid, m_input.pc_dbg, GetCycleNo());
+                    }
+                }
             }
             // Reschedule thread
             else if (allow_reschedule)
@@ -169,6 +169,35 @@ bool SymbolTable::LookUp(const std::string& sym, MemAddr &addr, bool recurse) co
     return false;
 }
 
+bool SymbolTable::FindEnclosing(MemAddr addr, MemAddr& start, std::string& sym) const
+{
+    /* find the first entry above the address */
+    size_t len = m_entries.size();
+    size_t cursor = 0;
+    while (len > 0)
+    {
+        size_t half = len / 2;
+        if (entry_addr(m_entries[cursor + half]) <= addr)
+        {
+            cursor = cursor + half + 1;
+            len = len - half - 1;
+        }
+        else
+            len = half;
+    }
+
+    if (cursor == 0)
+        return false;
+
+    const entry_t & below = m_entries[cursor-1];
+    if (entry_sz(below) && addr >= entry_addr(below) + entry_sz(below))
+        return false;
+
+    start = entry_addr(below);
+    sym = entry_sym(below);
+    return true;
+}
+
 void SymbolTable::AddSymbol(MemAddr addr, const std::string& name, size_t sz)
 {
     m_entries.push_back(make_pair(addr, make_pair(sz, name)));
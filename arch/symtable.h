@@ -23,6 +23,10 @@ public:
     void Write(std::ostream& o, const std::string& pat = "*") const;
 
     bool LookUp(const std::string& sym, Simulator::MemAddr &addr, bool recurse = true) const;
+
+    // Finds the last symbol at or below the address, unless the address
+    // is beyond its size; returns false if there is none
+    bool FindEnclosing(Simulator::MemAddr addr, Simulator::MemAddr& start, std::string& sym) const;
     
     const std::string& operator[](Simulator::MemAddr addr);
     const std::string operator[](Simulator::MemAddr addr) const;
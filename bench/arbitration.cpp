@@ -0,0 +1,192 @@
+/*
+ * Microbenchmark for the arbitrated ports.
+ *
+ * Measures the host cost of one arbitration round (requests followed
+ * by Arbitrate()) for the priority, cyclic and priority-cyclic ports
+ * with 2, 8 and 32 requestors.
+ */
+#ifdef HAVE_CONFIG_H
+#include "sys_config.h"
+#endif
+
+#include "sim/ports.h"
+#include "sim/breakpoints.h"
+#include "arch/symtable.h"
+
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+using namespace Simulator;
+using namespace std;
+
+namespace
+{
+    // Number of distinct request patterns cycled through
+    static const size_t NUM_PATTERNS = 1024;
+
+    // Number of arbitration rounds per measurement
+    static const size_t NUM_ROUNDS = 4000000;
+
+    static unsigned int g_instance = 0;
+
+    class Requestors : public Object
+    {
+    public:
+        std::vector<Process*> m_processes;
+
+        Result DoNothing() { return SUCCESS; }
+
+        Requestors(const std::string& name, Clock& clock, size_t count)
+            : Object(name, clock)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::stringstream ss;
+                ss << "p" << i;
+                m_processes.push_back(new Process(*this, ss.str(), delegate::create<Requestors, &Requestors::DoNothing>(*this)));
+            }
+        }
+
+        ~Requestors()
+        {
+            for (size_t i = 0; i < m_processes.size(); ++i)
+                delete m_processes[i];
+        }
+    };
+
+    // Exposes the protected request interface of a port
+    template <typename Base>
+    class BenchPort : public Base
+    {
+    public:
+        using Base::AddRequest;
+        using Base::GetSelectedProcess;
+
+        BenchPort(const Object& object, const std::string& name)
+            : Base(object, name) {}
+    };
+
+    void AddProcesses(BenchPort<PriorityArbitratedPort>& port, const Requestors& r)
+    {
+        for (size_t i = 0; i < r.m_processes.size(); ++i)
+            port.AddProcess(*r.m_processes[i]);
+    }
+
+    void AddProcesses(BenchPort<CyclicArbitratedPort>& port, const Requestors& r)
+    {
+        for (size_t i = 0; i < r.m_processes.size(); ++i)
+            port.AddProcess(*r.m_processes[i]);
+    }
+
+    void AddProcesses(BenchPort<PriorityCyclicArbitratedPort>& port, const Requestors& r)
+    {
+        // One quarter of the requestors have priority, the rest is cyclic,
+        // which mimics the bus arbitration in the COMA caches.
+        size_t npriority = std::max<size_t>(1, r.m_processes.size() / 4);
+        for (size_t i = 0; i < r.m_processes.size(); ++i)
+        {
+            if (i < npriority)
+                port.AddPriorityProcess(*r.m_processes[i]);
+            else
+                port.AddCyclicProcess(*r.m_processes[i]);
+        }
+    }
+
+    // Same construction order as MGSystem: the kernel only keeps
+    // references to the symbol table and breakpoints.
+    struct BenchSystem
+    {
+        Kernel      kernel;
+        SymbolTable symtable;
+        BreakPoints breakpoints;
+
+        BenchSystem() : kernel(symtable, breakpoints), breakpoints(kernel) {}
+    };
+
+    template <typename Port>
+    double Measure(Clock& clock, size_t count, const std::vector<std::vector<size_t> >& patterns)
+    {
+        // Sample variable names must be unique, so give every
+        // measurement its own component name.
+        std::stringstream name;
+        name << "bench" << g_instance++;
+
+        Requestors requestors(name.str(), clock, count);
+        BenchPort<Port> port(requestors, "port");
+        AddProcesses(port, requestors);
+
+        // Pre-resolve the request patterns to processes
+        std::vector<std::vector<const Process*> > reqs(patterns.size());
+        for (size_t i = 0; i < patterns.size(); ++i)
+            for (size_t j = 0; j < patterns[i].size(); ++j)
+                reqs[i].push_back(requestors.m_processes[patterns[i][j]]);
+
+        size_t check = 0;
+        struct timeval tv_begin, tv_end;
+        gettimeofday(&tv_begin, 0);
+        for (size_t n = 0; n < NUM_ROUNDS; ++n)
+        {
+            const std::vector<const Process*>& r = reqs[n % reqs.size()];
+            for (size_t j = 0; j < r.size(); ++j)
+                port.AddRequest(*r[j]);
+            port.Arbitrate();
+            check += (size_t)port.GetSelectedProcess();
+        }
+        gettimeofday(&tv_end, 0);
+
+        if (check == 0)
+            cerr << "no process was ever selected" << endl;
+
+        double usecs = (tv_end.tv_sec - tv_begin.tv_sec) * 1e6 + (tv_end.tv_usec - tv_begin.tv_usec);
+        return usecs * 1000. / NUM_ROUNDS;
+    }
+}
+
+int main()
+{
+    BenchSystem sys;
+    Clock& clock = sys.kernel.CreateClock(1000);
+
+    static const size_t counts[] = { 2, 8, 32 };
+
+    cout << "# ns per arbitration round" << endl
+         << "# requestors  reqs/round  priority  cyclic    prio-cyclic" << endl;
+
+    for (size_t c = 0; c < sizeof counts / sizeof counts[0]; ++c)
+    {
+        // Draw request patterns of increasing density: a single request
+        // (the common case), a few requests, and all requestors at once.
+        static const size_t densities[] = { 1, 2, 0 };
+        size_t last = 0;
+        for (size_t d = 0; d < sizeof densities / sizeof densities[0]; ++d)
+        {
+            size_t nreqs = (densities[d] == 0) ? counts[c] : std::min(densities[d], counts[c]);
+            if (nreqs == last)
+                continue;
+            last = nreqs;
+
+            std::vector<std::vector<size_t> > patterns(NUM_PATTERNS);
+            unsigned long long seed = 12345;
+            for (size_t i = 0; i < NUM_PATTERNS; ++i)
+                while (patterns[i].size() < nreqs)
+                {
+                    // A process requests at most once per cycle
+                    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                    size_t p = (densities[d] == 0) ? patterns[i].size() : (size_t)(seed >> 33) % counts[c];
+                    if (std::find(patterns[i].begin(), patterns[i].end(), p) == patterns[i].end())
+                        patterns[i].push_back(p);
+                }
+
+            cout << setw(12) << counts[c] << "  " << setw(10) << nreqs << fixed << setprecision(1)
+                 << "  " << setw(8) << Measure<PriorityArbitratedPort>(clock, counts[c], patterns)
+                 << "  " << setw(8) << Measure<CyclicArbitratedPort>(clock, counts[c], patterns)
+                 << "  " << setw(11) << Measure<PriorityCyclicArbitratedPort>(clock, counts[c], patterns)
+                 << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Microbenchmark for the cache tag lookups.
+ *
+ * Measures the host cost of finding a line in a set with 4, 8 and 16
+ * ways. The lookup in CacheTags, which scans the contiguous tags of a
+ * set, is compared against scanning the line structures of the set,
+ * as the D-Cache and the COMA caches did before their tags were split
+ * off. The caches of a whole grid do not fit in the host caches, so
+ * the lines are spread over many simulated caches.
+ */
+#ifdef HAVE_CONFIG_H
+#include "sys_config.h"
+#endif
+
+#include "arch/CacheTags.h"
+#include "arch/Memory.h"
+
+#include <sys/time.h>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace Simulator;
+using namespace std;
+
+namespace
+{
+    // Total number of lines of all caches, e.g. 256 D-Caches of 4KiB
+    static const size_t NUM_LINES = 256 * 64;
+
+    // Number of lookups per measurement
+    static const size_t NUM_LOOKUPS = 8000000;
+
+    // Fraction of lookups that hit, in percent
+    static const unsigned int HIT_RATE = 90;
+
+    enum LineState { LINE_EMPTY, LINE_LOADING, LINE_INVALID, LINE_FULL };
+
+    // The former D-Cache line
+    struct DCacheLine
+    {
+        LineState   state;
+        bool        processing;
+        MemAddr     tag;
+        char*       data;
+        bool*       valid;
+        CycleNo     access;
+        RegAddr     waiting;
+        bool        create;
+    };
+
+    // The former COMA cache line
+    struct COMALine
+    {
+        LineState    state;
+        MemAddr      tag;
+        char*        data;
+        CycleNo      access;
+        unsigned int tokens;
+        bool         dirty;
+        unsigned int updating;
+        bool         valid[MAX_MEMORY_OPERATION_SIZE];
+    };
+
+    template <typename Line>
+    size_t FindLine(const std::vector<Line>& lines, size_t assoc, size_t set, MemAddr tag)
+    {
+        for (size_t i = set * assoc; i < (set + 1) * assoc; ++i)
+        {
+            if (lines[i].state != LINE_EMPTY && lines[i].tag == tag)
+            {
+                return i;
+            }
+        }
+        return lines.size();
+    }
+
+    struct Lookup
+    {
+        size_t  set;
+        MemAddr tag;
+    };
+
+    double Elapsed(const struct timeval& tv_begin, const struct timeval& tv_end)
+    {
+        double usecs = (tv_end.tv_sec - tv_begin.tv_sec) * 1e6 + (tv_end.tv_usec - tv_begin.tv_usec);
+        return usecs * 1000. / NUM_LOOKUPS;
+    }
+}
+
+int main()
+{
+    static const size_t assocs[] = { 4, 8, 16 };
+
+    cout << "# ns per lookup, " << NUM_LINES << " lines, " << HIT_RATE << "% hits" << endl
+         << "# assoc  dcache-lines  coma-lines  tags  tags vs coma-lines" << endl;
+
+    for (size_t a = 0; a < sizeof assocs / sizeof assocs[0]; ++a)
+    {
+        const size_t assoc = assocs[a];
+        const size_t sets  = NUM_LINES / assoc;
+
+        // Fill all caches; one line in eight is empty
+        std::vector<DCacheLine> dlines(NUM_LINES);
+        std::vector<COMALine>   clines(NUM_LINES);
+        CacheTags               tags;
+        tags.Resize(sets, assoc);
+
+        srand(42);
+        for (size_t i = 0; i < NUM_LINES; ++i)
+        {
+            const MemAddr   tag   = i % assoc + 1;
+            const LineState state = (rand() % 8 == 0) ? LINE_EMPTY : LINE_FULL;
+            dlines[i].state = clines[i].state = state;
+            dlines[i].tag   = clines[i].tag   = tag;
+            if (state != LINE_EMPTY)
+            {
+                tags.Set(i, tag);
+            }
+        }
+
+        std::vector<Lookup> lookups(NUM_LOOKUPS);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            lookups[i].set = rand() % sets;
+            lookups[i].tag = (rand() % 100 < (int)HIT_RATE) ? rand() % assoc + 1 : assoc + 1;
+        }
+
+        // The sums keep the lookups from being optimized away, and
+        // must agree between the layouts
+        size_t sum[3] = {0, 0, 0};
+        struct timeval tv[4];
+        gettimeofday(&tv[0], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+            sum[0] += FindLine(dlines, assoc, lookups[i].set, lookups[i].tag);
+        gettimeofday(&tv[1], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+            sum[1] += FindLine(clines, assoc, lookups[i].set, lookups[i].tag);
+        gettimeofday(&tv[2], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+            sum[2] += tags.Find(lookups[i].set, lookups[i].tag);
+        gettimeofday(&tv[3], 0);
+
+        if (sum[0] != sum[1] || sum[0] != sum[2])
+        {
+            cerr << "lookup mismatch for associativity " << assoc << endl;
+            return 1;
+        }
+
+        const double dcache = Elapsed(tv[0], tv[1]), coma = Elapsed(tv[1], tv[2]), found = Elapsed(tv[2], tv[3]);
+        cout << setw(7) << assoc
+             << fixed << setprecision(2)
+             << "  " << setw(12) << dcache
+             << "  " << setw(10) << coma
+             << "  " << setw(4) << found
+             << "  " << setw(17) << coma / found << "x"
+             << endl;
+    }
+    return 0;
+}
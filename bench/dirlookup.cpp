@@ -0,0 +1,205 @@
+/*
+ * Microbenchmark for the COMA directory lookups.
+ *
+ * Measures the host cost of looking up a line in a directory, which
+ * happens for nearly every message that a directory receives. The
+ * directories have as many ways per set as all caches below them: 32
+ * for a directory of a ring of 8 caches with 4 ways, and 128 and 512
+ * for the root directory of a system with 4 and 16 such rings. The
+ * linear scan of the ways that the directories did before is compared
+ * against CacheTagIndex; both include the mapping of the address to a
+ * set with the default XORFOLD selector, which is given on its own as
+ * well. The directories are three quarters full and half of the
+ * lookups miss, as for requests for lines that are not below a
+ * directory. The last column is the cost of keeping the index in sync
+ * when a line is evicted and allocated again, including a lookup.
+ */
+#ifdef HAVE_CONFIG_H
+#include "sys_config.h"
+#endif
+
+#include "arch/CacheTagIndex.h"
+#include "arch/BankSelector.h"
+#include "sim/breakpoints.h"
+#include "arch/symtable.h"
+
+#include <sys/time.h>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace Simulator;
+using namespace std;
+
+namespace
+{
+    // Number of sets, as L2CacheNumSets in the default configuration
+    static const size_t NUM_SETS = 512;
+
+    // Number of lookups per measurement
+    static const size_t NUM_LOOKUPS = 4000000;
+
+    // Size of a cache line
+    static const size_t LINE_SIZE = 64;
+
+    // The directory line
+    struct Line
+    {
+        bool         valid;
+        MemAddr      tag;
+        unsigned int tokens;
+    };
+
+    size_t FindLine(const std::vector<Line>& lines, size_t assoc, size_t set, MemAddr tag)
+    {
+        for (size_t i = set * assoc; i < (set + 1) * assoc; ++i)
+        {
+            if (lines[i].valid && lines[i].tag == tag)
+            {
+                return i;
+            }
+        }
+        return lines.size();
+    }
+
+    // Same construction order as MGSystem: the kernel only keeps
+    // references to the symbol table and breakpoints.
+    struct BenchSystem
+    {
+        Kernel      kernel;
+        SymbolTable symtable;
+        BreakPoints breakpoints;
+
+        BenchSystem() : kernel(symtable, breakpoints), breakpoints(kernel) {}
+    };
+
+    MemAddr RandomLine()
+    {
+        return (((MemAddr)rand() << 16) ^ rand()) * LINE_SIZE;
+    }
+
+    double Elapsed(const struct timeval& tv_begin, const struct timeval& tv_end, size_t count)
+    {
+        double usecs = (tv_end.tv_sec - tv_begin.tv_sec) * 1e6 + (tv_end.tv_usec - tv_begin.tv_usec);
+        return usecs * 1000. / count;
+    }
+}
+
+int main()
+{
+    BenchSystem sys;
+    Clock& clock = sys.kernel.CreateClock(1000);
+    Object root("bench", clock);
+    IBankSelector* selector = IBankSelector::makeSelector(root, "XORFOLD", NUM_SETS);
+
+    static const size_t assocs[] = { 32, 128, 512 };
+
+    cout << "# ns per lookup, " << NUM_SETS << " sets, 75% full, 50% hits" << endl
+         << "# assoc  map  scan    indexed  speedup  evict+allocate" << endl;
+
+    for (size_t a = 0; a < sizeof assocs / sizeof assocs[0]; ++a)
+    {
+        const size_t assoc = assocs[a];
+
+        std::vector<Line> lines(NUM_SETS * assoc);
+        CacheTagIndex     index;
+        index.Resize(NUM_SETS, assoc);
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            lines[i].valid = false;
+        }
+
+        // Allocate lines in the first free way, as the directories do
+        srand(42);
+        std::vector<MemAddr> present;
+        for (size_t n = 0; n < lines.size() * 3 / 4; )
+        {
+            const MemAddr address = RandomLine();
+            MemAddr tag;
+            size_t  set;
+            selector->Map(address / LINE_SIZE, tag, set);
+            if (FindLine(lines, assoc, set, tag) != lines.size())
+                continue;
+            for (size_t i = set * assoc; i < (set + 1) * assoc; ++i)
+            {
+                if (!lines[i].valid)
+                {
+                    lines[i].valid = true;
+                    lines[i].tag   = tag;
+                    index.Insert(i, tag);
+                    present.push_back(address);
+                    ++n;
+                    break;
+                }
+            }
+        }
+
+        std::vector<MemAddr> lookups(NUM_LOOKUPS);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            lookups[i] = (rand() % 2) ? present[rand() % present.size()] : RandomLine();
+        }
+
+        // The sums keep the lookups from being optimized away, and
+        // must agree between the scan and the index
+        size_t sum[3] = {0, 0, 0};
+        struct timeval tv[5];
+        gettimeofday(&tv[0], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            MemAddr tag;
+            size_t  set;
+            selector->Map(lookups[i] / LINE_SIZE, tag, set);
+            sum[0] += set + tag;
+        }
+        gettimeofday(&tv[1], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            MemAddr tag;
+            size_t  set;
+            selector->Map(lookups[i] / LINE_SIZE, tag, set);
+            sum[1] += FindLine(lines, assoc, set, tag);
+        }
+        gettimeofday(&tv[2], 0);
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i)
+        {
+            MemAddr tag;
+            size_t  set;
+            selector->Map(lookups[i] / LINE_SIZE, tag, set);
+            sum[2] += index.Find(set, tag);
+        }
+        gettimeofday(&tv[3], 0);
+
+        if (sum[1] != sum[2])
+        {
+            cerr << "lookup mismatch for associativity " << assoc << endl;
+            return 1;
+        }
+
+        // Evict a present line and allocate it again
+        const size_t nchurn = NUM_LOOKUPS / 4;
+        for (size_t i = 0; i < nchurn; ++i)
+        {
+            MemAddr tag;
+            size_t  set;
+            selector->Map(present[i % present.size()] / LINE_SIZE, tag, set);
+            const size_t line = index.Find(set, tag);
+            index.Erase(line, tag);
+            index.Insert(line, tag);
+        }
+        gettimeofday(&tv[4], 0);
+
+        const double map = Elapsed(tv[0], tv[1], NUM_LOOKUPS), scan = Elapsed(tv[1], tv[2], NUM_LOOKUPS), found = Elapsed(tv[2], tv[3], NUM_LOOKUPS);
+        cout << setw(7) << assoc
+             << fixed << setprecision(1)
+             << "  " << setw(3) << map
+             << "  " << setw(6) << scan
+             << "  " << setw(7) << found
+             << "  " << setw(6) << scan / found << "x"
+             << "  " << setw(14) << Elapsed(tv[3], tv[4], nchurn)
+             << endl;
+    }
+    delete selector;
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Microbenchmark for the display refresh.
+ *
+ * Measures the host cost of converting a 1024x768 framebuffer to a
+ * 32-bit screen for each pixel format, unscaled and with the default
+ * 2x magnification. The conversion by PixelConverter is compared
+ * against the per-pixel conversion that Display::Refresh used before,
+ * both for a full redraw and for a refresh where 1 row in 64 changed.
+ */
+#ifdef HAVE_CONFIG_H
+#include "sys_config.h"
+#endif
+
+#include "arch/dev/Display.h"
+
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace Simulator;
+using namespace std;
+
+namespace
+{
+    static const unsigned int WIDTH  = 1024;
+    static const unsigned int HEIGHT = 768;
+
+    // Number of full frames per measurement
+    static const size_t NUM_FRAMES = 20;
+
+    // The host screen layout, as SDL usually provides it
+    static const unsigned int Rshift = 16, Gshift = 8, Bshift = 0;
+
+    struct Mode
+    {
+        const char*  name;
+        unsigned int bpp;
+        bool         indexed;
+    };
+
+    // The per-pixel conversion of the original Display::Refresh
+    void Reference(const Mode& mode, const std::vector<uint8_t>& fb, const std::vector<uint32_t>& palette,
+                   uint32_t* pixels, unsigned int dest_w, unsigned int dest_h, float scalex, float scaley,
+                   const std::vector<uint8_t>* dirty)
+    {
+        for (unsigned int dy = 0; dy < dest_h; ++dy)
+        {
+            uint32_t*    dest = pixels + dy * dest_w;
+            unsigned int sy   = dy * scaley;
+            if (dirty != NULL && !(*dirty)[sy])
+                continue;
+
+            for (unsigned int dx = 0; dx < dest_w; ++dx)
+            {
+                unsigned int sx = dx * scalex;
+                if (mode.indexed)
+                {
+                    uint32_t color = palette[fb[sy * WIDTH + sx]];
+                    dest[dx] = (((color & 0xff0000) >> 16) << Rshift)
+                        | (((color & 0x00ff00) >> 8) << Gshift)
+                        | (((color & 0x0000ff)     ) << Bshift);
+                }
+                else switch (mode.bpp)
+                {
+                case 8:
+                {
+                    static const float Rf = 0xff / (float)0xe0;
+                    static const float Gf = Rf;
+                    static const float Bf = 0xff / (float)0xc0;
+                    uint8_t color = fb[sy * WIDTH + sx];
+                    dest[dx] =
+                        (((uint32_t)((color & 0xe0) * Rf)) << Rshift)
+                        | (((uint32_t)(((color & 0x1c) << 3) * Gf)) << Gshift)
+                        | (((uint32_t)(((color & 0x03) << 6) * Bf)) << Bshift);
+                    break;
+                }
+                case 16:
+                {
+                    static const float Rf = 0xff / (float)0xf8;
+                    static const float Gf = 0xff / (float)0xfc;
+                    static const float Bf = Rf;
+                    uint16_t color = ((const uint16_t*)(const void*)&fb[0])[sy * WIDTH + sx];
+                    dest[dx] =
+                        (((uint32_t)(((color & 0xf800) >> 8) * Rf)) << Rshift)
+                        | (((uint32_t)(((color & 0x07e0) >> 3) * Gf)) << Gshift)
+                        | (((uint32_t)(((color & 0x001f) << 3) * Bf)) << Bshift);
+                    break;
+                }
+                case 24:
+                {
+                    const uint8_t* base = &fb[sy * WIDTH * 3 + sx * 3];
+                    dest[dx] = (base[0] << Rshift)
+                        | (base[1] << Gshift)
+                        | (base[2] << Bshift);
+                    break;
+                }
+                case 32:
+                {
+                    uint32_t color = ((const uint32_t*)(const void*)&fb[0])[sy * WIDTH + sx];
+                    dest[dx] = (((color & 0xff0000) >> 16) << Rshift)
+                        | (((color & 0x00ff00) >> 8) << Gshift)
+                        | (((color & 0x0000ff)     ) << Bshift);
+                    break;
+                }
+                }
+            }
+        }
+    }
+
+    // The conversion as done by Display::Refresh
+    void Convert(const PixelConverter& conv, const std::vector<uint8_t>& fb,
+                 uint32_t* pixels, unsigned int dest_w, unsigned int dest_h,
+                 const std::vector<uint8_t>* dirty)
+    {
+        for (unsigned int dy = 0; dy < dest_h; ++dy)
+        {
+            if (dirty == NULL || (*dirty)[conv.GetSourceRow(dy)])
+                conv.ConvertRow(pixels + dy * dest_w, &fb[0], dy);
+        }
+    }
+
+    double Elapsed(const struct timeval& tv_begin, const struct timeval& tv_end)
+    {
+        double usecs = (tv_end.tv_sec - tv_begin.tv_sec) * 1e6 + (tv_end.tv_usec - tv_begin.tv_usec);
+        return usecs / 1000. / NUM_FRAMES;
+    }
+}
+
+int main()
+{
+    static const Mode modes[] = {
+        { "8/idx",  8, true  },
+        { "8/332",  8, false },
+        { "16/565", 16, false },
+        { "24",     24, false },
+        { "32",     32, false },
+    };
+    static const unsigned int scales[] = { 1, 2 };
+
+    std::vector<uint8_t> fb(WIDTH * HEIGHT * 4);
+    std::vector<uint32_t> palette(256);
+    unsigned long long seed = 12345;
+    for (size_t i = 0; i < fb.size(); ++i)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        fb[i] = (uint8_t)(seed >> 33);
+    }
+    for (size_t i = 0; i < palette.size(); ++i)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        palette[i] = (uint32_t)(seed >> 33) & 0xffffff;
+    }
+
+    // 1 row in 64 changed since the last refresh
+    std::vector<uint8_t> dirty(HEIGHT, 0);
+    for (size_t i = 0; i < HEIGHT; i += 64)
+        dirty[i] = 1;
+
+    cout << "# ms per " << WIDTH << "x" << HEIGHT << " frame" << endl
+         << "# mode    scale  per-pixel  tables  speedup  per-pixel/dirty  tables/dirty" << endl;
+
+    for (size_t m = 0; m < sizeof modes / sizeof modes[0]; ++m)
+    {
+        for (size_t s = 0; s < sizeof scales / sizeof scales[0]; ++s)
+        {
+            const Mode& mode = modes[m];
+            const unsigned int dest_w = WIDTH * scales[s], dest_h = HEIGHT * scales[s];
+            const float scale = 1.0f / scales[s];
+            std::vector<uint32_t> ref(dest_w * dest_h), out(dest_w * dest_h);
+
+            PixelConverter conv;
+            conv.SetFormat(mode.bpp, mode.indexed, palette, Rshift, Gshift, Bshift);
+            conv.SetScale(WIDTH, HEIGHT, dest_w, dest_h, scale, scale);
+
+            struct timeval tv[5];
+            gettimeofday(&tv[0], 0);
+            for (size_t n = 0; n < NUM_FRAMES; ++n)
+                Reference(mode, fb, palette, &ref[0], dest_w, dest_h, scale, scale, NULL);
+            gettimeofday(&tv[1], 0);
+            for (size_t n = 0; n < NUM_FRAMES; ++n)
+                Convert(conv, fb, &out[0], dest_w, dest_h, NULL);
+            gettimeofday(&tv[2], 0);
+            for (size_t n = 0; n < NUM_FRAMES; ++n)
+                Reference(mode, fb, palette, &ref[0], dest_w, dest_h, scale, scale, &dirty);
+            gettimeofday(&tv[3], 0);
+            for (size_t n = 0; n < NUM_FRAMES; ++n)
+                Convert(conv, fb, &out[0], dest_w, dest_h, &dirty);
+            gettimeofday(&tv[4], 0);
+
+            if (ref != out)
+            {
+                cerr << "conversion mismatch for mode " << mode.name << ", scale " << scales[s] << endl;
+                return 1;
+            }
+
+            const double full = Elapsed(tv[0], tv[1]), fast = Elapsed(tv[1], tv[2]);
+            cout << left << setw(8) << mode.name << right << "  " << setw(5) << scales[s]
+                 << fixed << setprecision(2)
+                 << "  " << setw(9) << full
+                 << "  " << setw(6) << fast
+                 << "  " << setw(6) << full / fast << "x"
+                 << "  " << setw(15) << Elapsed(tv[2], tv[3])
+                 << "  " << setw(12) << Elapsed(tv[3], tv[4])
+                 << endl;
+        }
+    }
+    return 0;
+}
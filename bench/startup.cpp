@@ -0,0 +1,198 @@
+/*
+ * Microbenchmark for the configuration lookups at startup.
+ *
+ * Measures the host cost of the configuration lookups done while a
+ * grid of 64, 256 and 1024 cores is constructed. The keys are those
+ * that MGSystem looks up for every core and FPU, with the patterns of
+ * the default configuration file. The linear scan with fnmatch that
+ * InputConfigRegistry::lookup used before is compared against
+ * ConfigPatternIndex, and the cost of the lookups through the registry,
+ * including its cache, is given as well.
+ */
+#ifdef HAVE_CONFIG_H
+#include "sys_config.h"
+#endif
+
+#include "sim/config.h"
+
+#include <sys/time.h>
+#include <fnmatch.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // The keys looked up for every core, after "cpuN."
+    static const char* const core_keys[] = {
+        ":enableio", "threads:numentries", "families:numentries",
+        "registers:numintregisters", "registers:numfltregisters",
+        "rau:intregistersblocksize", "rau:fltregistersblocksize", "rau:allocationstrategy",
+        "pipeline:numdummystages", "perfcounters:mmio_baseaddr",
+        "network:placementpolicy", "network:loadbalancethreshold",
+        "icache:outgoingbuffersize", "icache:incomingbuffersize", "icache:numsets",
+        "icache:bankselector", "icache:associativity",
+        "dcache:outgoingbuffersize", "dcache:incomingbuffersize", "dcache:numsets",
+        "dcache:bankselector", "dcache:associativity",
+        "debug_stdout:mmio_baseaddr", "debug_stderr:mmio_baseaddr",
+        "aprs:numancillaryregisters",
+        "alloc:threadcleanupqueuesize", "alloc:initialthreadallocatequeuesize",
+        "alloc:indirectcreatequeuesize", "alloc:familyallocationsuspendqueuesize",
+        "alloc:familyallocationnosuspendqueuesize", "alloc:familyallocationexclusivequeuesize",
+        "alloc:createqueuesize",
+    };
+
+    // Every FPU is shared by two cores and has five units
+    static const size_t CORES_PER_FPU = 2;
+    static const size_t UNITS_PER_FPU = 5;
+
+    // Number of times the lookups are repeated per measurement
+    static const size_t NUM_RUNS = 5;
+
+    std::vector<std::string> MakeKeys(size_t cores)
+    {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < cores; ++i)
+            for (size_t k = 0; k < sizeof core_keys / sizeof core_keys[0]; ++k)
+            {
+                std::stringstream ss;
+                ss << "cpu" << i << (core_keys[k][0] == ':' ? "" : ".") << core_keys[k];
+                keys.push_back(ss.str());
+            }
+
+        for (size_t f = 0; f < cores / CORES_PER_FPU; ++f)
+        {
+            std::stringstream ss;
+            ss << "fpu" << f << ":numunits";
+            keys.push_back(ss.str());
+            for (size_t u = 0; u < UNITS_PER_FPU; ++u)
+            {
+                static const char* const unit_keys[] = { "ops", "latency", "pipelined" };
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    std::stringstream ss;
+                    ss << "fpu" << f << ":unit" << u << unit_keys[k];
+                    keys.push_back(ss.str());
+                }
+            }
+            for (size_t s = 0; s < CORES_PER_FPU; ++s)
+            {
+                std::stringstream ss;
+                ss << "fpu" << f << ".source" << s << ":inputqueuesize";
+                keys.push_back(ss.str());
+            }
+        }
+        return keys;
+    }
+
+    // The patterns in the order they are tried, as printed by
+    // dumpConfiguration: first the overrides, then the file.
+    void GetPatterns(const InputConfigRegistry& registry, ConfigMap& patterns)
+    {
+        std::stringstream dump;
+        registry.dumpConfiguration(dump, "");
+        std::string line;
+        while (getline(dump, line))
+        {
+            if (line.compare(0, 5, "# -o ") != 0)
+                continue;
+            std::string::size_type eq = line.find(" = ");
+            patterns.append(line.substr(5, eq - 5), line.substr(eq + 3));
+        }
+    }
+
+    // The lookup of the original InputConfigRegistry::lookup
+    const std::pair<std::string, std::string>* Reference(const ConfigMap& patterns, const std::string& name, size_t& matches)
+    {
+        for (ConfigMap::const_iterator p = patterns.begin(); p != patterns.end(); ++p)
+        {
+            ++matches;
+            if (FNM_NOMATCH != fnmatch(p->first.c_str(), name.c_str(), 0))
+                return &*p;
+        }
+        return NULL;
+    }
+
+    double Elapsed(const struct timeval& tv_begin, const struct timeval& tv_end)
+    {
+        double usecs = (tv_end.tv_sec - tv_begin.tv_sec) * 1e6 + (tv_end.tv_usec - tv_begin.tv_usec);
+        return usecs / 1000. / NUM_RUNS;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string filename = (argc > 1) ? argv[1] : BENCH_CONFIG_FILE;
+    static const size_t sizes[] = { 64, 256, 1024 };
+
+    cout << "# ms for all lookups of a grid, configuration: " << filename << endl
+         << "# cores   keys  patterns  linear  indexed  speedup  registry  fnmatch/key linear  indexed" << endl;
+
+    for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; ++s)
+    {
+        // The overrides given on the command line for such a run
+        ConfigMap overrides;
+        std::stringstream ncores;
+        ncores << sizes[s];
+        overrides.append("NumProcessors", ncores.str());
+        overrides.append("*:ROMFileName", "a.out");
+
+        const std::vector<std::string> args;
+        const std::vector<std::string> keys = MakeKeys(sizes[s]);
+
+        ConfigMap patterns;
+        {
+            InputConfigRegistry registry(filename, overrides, args);
+            GetPatterns(registry, patterns);
+        }
+
+        ConfigPatternIndex index;
+        index.build(patterns);
+
+        std::vector<const std::pair<std::string, std::string>*> ref(keys.size()), out(keys.size());
+        size_t ref_matches = 0;
+
+        struct timeval tv[4];
+        gettimeofday(&tv[0], 0);
+        for (size_t n = 0; n < NUM_RUNS; ++n)
+            for (size_t i = 0; i < keys.size(); ++i)
+                ref[i] = Reference(patterns, keys[i], ref_matches);
+        gettimeofday(&tv[1], 0);
+        for (size_t n = 0; n < NUM_RUNS; ++n)
+            for (size_t i = 0; i < keys.size(); ++i)
+                out[i] = index.find(keys[i]);
+        gettimeofday(&tv[2], 0);
+        for (size_t n = 0; n < NUM_RUNS; ++n)
+        {
+            // A new registry every time, so that its cache starts empty
+            InputConfigRegistry registry(filename, overrides, args);
+            for (size_t i = 0; i < keys.size(); ++i)
+                registry.getValueOrDefault<std::string>(keys[i], "");
+        }
+        gettimeofday(&tv[3], 0);
+
+        // Both must find the same pattern. The index refers to the
+        // same ConfigMap, so the entries can be compared by address.
+        if (ref != out)
+        {
+            cerr << "lookup mismatch for " << sizes[s] << " cores" << endl;
+            return 1;
+        }
+
+        const double linear = Elapsed(tv[0], tv[1]), indexed = Elapsed(tv[1], tv[2]);
+        const double nlookups = (double)keys.size() * NUM_RUNS;
+        cout << setw(7) << sizes[s] << "  " << setw(5) << keys.size() << "  " << setw(8) << index.size()
+             << fixed << setprecision(2)
+             << "  " << setw(6) << linear
+             << "  " << setw(7) << indexed
+             << "  " << setw(6) << linear / indexed << "x"
+             << "  " << setw(8) << Elapsed(tv[2], tv[3])
+             << "  " << setw(18) << ref_matches / nlookups
+             << "  " << setw(7) << index.getNumMatches() / nlookups
+             << endl;
+    }
+    return 0;
+}
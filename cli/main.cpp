@@ -43,6 +43,7 @@ struct ProgramConfig
     string                           m_topofile;
     bool                             m_dumpnodeprops;
     bool                             m_dumpedgeprops;
+    bool                             m_startupReport;
     vector<string>                   m_argv;
 };
 
@@ -60,6 +61,7 @@ static void ParseArguments(int argc, const char ** argv, ProgramConfig& config)
     config.m_dumptopo = false;
     config.m_dumpnodeprops = true;
     config.m_dumpedgeprops = true;
+    config.m_startupReport = false;
 
     bool ignore_args = false;
 
@@ -130,6 +132,7 @@ static void ParseArguments(int argc, const char ** argv, ProgramConfig& config)
         }
         else if (arg == "--no-node-properties") config.m_dumpnodeprops = false;
         else if (arg == "--no-edge-properties") config.m_dumpedgeprops = false;
+        else if (arg == "--startup-report")     config.m_startupReport = true;
         else if (arg == "-n" || arg == "--do-nothing")  config.m_earlyquit     = true;
         else if (arg == "-o" || arg == "--override")
         {
@@ -270,6 +273,11 @@ int main(int argc, char** argv)
                      !config.m_interactive, 
                      !config.m_earlyquit);
 
+        if (config.m_startupReport)
+        {
+            sys.PrintStartupReport(std::clog);
+        }
+
 #ifdef ENABLE_MONITOR
         string mo_mdfile = configfile.getValueOrDefault<string>("MonitorMetadataFile", "mgtrace.md");
         string mo_tfile = configfile.getValueOrDefault<string>("MonitorTraceFile", "mgtrace.out");
@@ -277,6 +285,14 @@ int main(int argc, char** argv)
                    mo_mdfile, config.m_earlyquit ? "" : mo_tfile, !config.m_interactive);
 #endif
 
+        // Optional statistics are only maintained when they can be read:
+        // at the end of the simulation (-p) or at any time interactively.
+        // The monitor enables the variables it samples itself.
+        if (config.m_interactive)
+            EnableSampleVariables();
+        for (size_t i = 0; i < config.m_printvars.size(); ++i)
+            EnableSampleVariables(config.m_printvars[i]);
+
         if (config.m_dumpconf)
         {
             // we also print the cache, which expands all effectively
@@ -349,8 +365,10 @@ int main(int argc, char** argv)
                 PrintException(cerr, e);
                 
                 // When we get an exception in non-interactive mode,
-                // jump into interactive mode
+                // jump into interactive mode. Optional statistics that
+                // were not enabled only count from here on.
                 interactive = true;
+                EnableSampleVariables();
             }
         }
         
@@ -40,6 +40,7 @@ void StepSystem(Simulator::MGSystem& system, Simulator::CycleNo cycles)
     {
         sigaction(SIGINT, &old_handler, NULL);
         active_system = NULL;
+        Simulator::Selector::GetSelector().Disable();
         throw;
     }
     sigaction(SIGINT, &old_handler, NULL);
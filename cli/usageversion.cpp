@@ -33,6 +33,7 @@ void PrintUsage(std::ostream& out, const char* cmd)
         "  -T, --dump-topology FILE     Dump the grid topology to FILE prior to program startup.\n"
         "  --no-node-properties         Do not print component properties in the topology output.\n"
         "  --no-edge-properties         Do not print link properties in the topology output.\n"
+        "  --startup-report             Print the construction time and heap use per component.\n"
         "  -R<X> VALUE                  Store the integer VALUE in the specified register.\n"
         "  -F<X> VALUE                  Store the float VALUE in the specified FP register.\n"
         "  -L<X> FILE                   Create an ActiveROM component with the contents of FILE\n"
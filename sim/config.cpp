@@ -24,6 +24,79 @@ void ConfigMap::append(const string& key_, const string& val)
     m_map.push_back(make_pair(key, val));
 }
 
+// Characters with a special meaning for fnmatch
+static const char* const PATTERN_SPECIALS = "*?[]\\";
+
+void ConfigPatternIndex::build(const ConfigMap& map)
+{
+    m_nodes.clear();
+    m_patterns.clear();
+    m_nodes.push_back(Node());
+
+    for (ConfigMap::const_iterator p = map.begin(); p != map.end(); ++p)
+    {
+        const string& pat = p->first;
+        Pattern pattern;
+        pattern.entry  = p;
+        pattern.prefix = min(pat.find_first_of(PATTERN_SPECIALS), pat.size());
+
+        // Insert the literal suffix, last character first
+        string::size_type last = pat.find_last_of(PATTERN_SPECIALS);
+        string::size_type begin = (last == string::npos) ? 0 : last + 1;
+        size_t node = 0;
+        for (string::size_type i = pat.size(); i > begin; --i)
+        {
+            std::map<char, size_t>::const_iterator n = m_nodes[node].next.find(pat[i - 1]);
+            if (n == m_nodes[node].next.end())
+            {
+                m_nodes.push_back(Node());
+                node = m_nodes[node].next[pat[i - 1]] = m_nodes.size() - 1;
+            }
+            else
+            {
+                node = n->second;
+            }
+        }
+        m_nodes[node].patterns.push_back(m_patterns.size());
+        m_patterns.push_back(pattern);
+    }
+}
+
+const pair<string,string>* ConfigPatternIndex::find(const string& name)
+{
+    // Collect the patterns whose literal suffix the name ends with
+    vector<size_t> candidates(m_nodes[0].patterns);
+    size_t node = 0;
+    for (string::size_type i = name.size(); i > 0; --i)
+    {
+        std::map<char, size_t>::const_iterator n = m_nodes[node].next.find(name[i - 1]);
+        if (n == m_nodes[node].next.end())
+        {
+            break;
+        }
+        node = n->second;
+        candidates.insert(candidates.end(), m_nodes[node].patterns.begin(), m_nodes[node].patterns.end());
+    }
+
+    // Try them in the order of the map, so that the first match wins as before
+    sort(candidates.begin(), candidates.end());
+    for (vector<size_t>::const_iterator c = candidates.begin(); c != candidates.end(); ++c)
+    {
+        const Pattern& pattern = m_patterns[*c];
+        const string& pat = pattern.entry->first;
+        if (name.compare(0, pattern.prefix, pat, 0, pattern.prefix) != 0)
+        {
+            continue;
+        }
+        ++m_matches;
+        if (FNM_NOMATCH != fnmatch(pat.c_str(), name.c_str(), 0))
+        {
+            return &*pattern.entry;
+        }
+    }
+    return NULL;
+}
+
 template <>
 string InputConfigRegistry::lookupValue<string>(const string& name, const string& def, bool fail_if_not_found)
 {
@@ -89,33 +162,30 @@ bool InputConfigRegistry::lookup(const string& name_, string& result, const stri
         return true;
     }
 
+    // The overrides can still change until the first lookup
+    if (m_overridesIndex.empty() || m_overridesIndex.size() != (size_t)distance(m_overrides.begin(), m_overrides.end()))
+    {
+        m_overridesIndex.build(m_overrides);
+    }
+    if (m_dataIndex.empty())
+    {
+        m_dataIndex.build(m_data);
+    }
+
     bool found = false;
-    for (ConfigMap::const_iterator p = m_overrides.begin(); p != m_overrides.end(); ++p)
+    const pair<string,string>* match = m_overridesIndex.find(name);
+    if (match == NULL)
     {
-        pat = p->first;
-        if (FNM_NOMATCH != fnmatch(pat.c_str(), name.c_str(), 0))
-        {
-            // Return the overriden value
-            result = p->second;
-            found = true;
-            break;
-        }
+        match = m_dataIndex.find(name);
     }
-    
-    if (!found)
+    if (match != NULL)
     {
-        for (ConfigMap::const_iterator p = m_data.begin(); p != m_data.end(); ++p)
-        {
-            pat = p->first;
-            if (FNM_NOMATCH != fnmatch(pat.c_str(), name.c_str(), 0))
-            {
-                // Return the configuration value
-                result = p->second;
-                found = true;
-                break;
-            }
-        }
+        // Return the overriden or configuration value
+        pat    = match->first;
+        result = match->second;
+        found  = true;
     }
+    
     if (!found && allow_default)
     {
         pat = "default";
@@ -32,6 +32,44 @@ private:
     map_t m_map;
 };
 
+/// ConfigPatternIndex: finds the first pattern of a ConfigMap that
+/// matches a key, without calling fnmatch for every pattern in turn.
+/// The patterns are indexed by their literal suffix, i.e. the part
+/// after the last wildcard, in a trie over the reversed suffixes.
+/// Most patterns end with a literal key name (e.g. "*:NumSets"), so
+/// a lookup only tries the few patterns whose suffix the key ends with.
+
+class ConfigPatternIndex
+{
+    struct Node
+    {
+        std::map<char, size_t> next;      ///< Child per preceding character
+        std::vector<size_t>    patterns;  ///< Positions of the patterns with this suffix
+    };
+
+    struct Pattern
+    {
+        ConfigMap::const_iterator entry;
+        size_t                    prefix;  ///< Length of the literal prefix
+    };
+
+    std::vector<Node>    m_nodes;     ///< Trie nodes; the root has the patterns without literal suffix
+    std::vector<Pattern> m_patterns;  ///< Patterns in the order of the map
+    size_t               m_matches;   ///< Number of fnmatch calls, for statistics
+
+public:
+    void build(const ConfigMap& map);
+    bool empty() const { return m_nodes.empty(); }
+    size_t size() const { return m_patterns.size(); }
+    size_t getNumMatches() const { return m_matches; }
+
+    /// Returns the first pattern that matches the lower-case name,
+    /// or NULL if there is none.
+    const std::pair<std::string,std::string>* find(const std::string& name);
+
+    ConfigPatternIndex() : m_matches(0) {}
+};
+
 class InputConfigRegistry
 {
 private:
@@ -40,6 +78,8 @@ private:
     ConfigMap                m_data;
     const ConfigMap&         m_overrides;
     ConfigCache              m_cache;
+    ConfigPatternIndex       m_dataIndex;
+    ConfigPatternIndex       m_overridesIndex;
     std::vector<std::string> m_argv;
 
     template<typename T>
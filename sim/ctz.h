@@ -6,6 +6,7 @@
 
 #ifdef __GNUC__
 # define ctz(N) __builtin_ctz(N)
+# define ctzll(N) __builtin_ctzll(N)
 #else
 static inline int ctz(unsigned int x)
 {
@@ -14,6 +15,15 @@ static inline int ctz(unsigned int x)
         ;
     return p;
 }
+
+static inline int ctzll(unsigned long long x)
+{
+    int p;
+    unsigned long long b;
+    for (p = 0, b = 1; !(b & x); b <<= 1, ++p)
+        ;
+    return p;
+}
 #endif
 
 #endif
@@ -0,0 +1,77 @@
+#include "histogram.h"
+#include "sampling.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace Simulator
+{
+
+LatencyHistogram::LatencyHistogram()
+    : m_count(0), m_total(0), m_max(0)
+{
+    std::fill(m_buckets, m_buckets + NUM_BUCKETS, 0);
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& h)
+{
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        m_buckets[i] += h.m_buckets[i];
+    }
+    m_count += h.m_count;
+    m_total += h.m_total;
+    m_max    = std::max(m_max, h.m_max);
+    return *this;
+}
+
+void LatencyHistogram::RegisterSampleVariables(const std::string& name)
+{
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        ostringstream s;
+        s << name << '_' << (i == 0 ? 0 : (uint64_t)1 << i);
+        RegisterSampleVariable(m_buckets[i], s.str(), SVC_CUMULATIVE);
+    }
+    RegisterSampleVariable(m_count, name + "_count", SVC_CUMULATIVE);
+    RegisterSampleVariable(m_total, name + "_total", SVC_CUMULATIVE);
+    RegisterSampleVariable(m_max,   name + "_max",   SVC_WATERMARK);
+}
+
+/*static*/ void LatencyHistogram::PrintHeader(std::ostream& out)
+{
+    // Each bucket is named by its lowest latency
+    out << "# name\tcount\tmean\tmax";
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        out << '\t' << (i == 0 ? 0 : (uint64_t)1 << i);
+        if (i + 1 == NUM_BUCKETS)
+        {
+            out << '+';
+        }
+    }
+    out << endl;
+}
+
+void LatencyHistogram::Print(std::ostream& out, const std::string& name) const
+{
+    const ios::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+
+    out << name << '\t' << m_count << '\t'
+        << fixed << setprecision(1) << (m_count == 0 ? 0.0 : (double)m_total / m_count) << '\t'
+        << m_max;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        out << '\t' << m_buckets[i];
+    }
+    out << endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}
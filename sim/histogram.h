@@ -0,0 +1,62 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "sim/kernel.h"
+
+#include <iostream>
+#include <string>
+
+namespace Simulator
+{
+
+/// LatencyHistogram: the distribution of a latency, in cycles, over
+/// buckets of powers of two. Bucket 0 holds latencies 0 and 1, bucket n
+/// holds latencies from 2^n up to 2^(n+1) - 1, and the last bucket holds
+/// everything above. The histograms of several components can be added
+/// up for a total over the system.
+class LatencyHistogram
+{
+public:
+    static const unsigned int NUM_BUCKETS = 16;
+
+    void Add(CycleNo latency)
+    {
+        unsigned int b = 0;
+        while (b + 1 < NUM_BUCKETS && (latency >> (b + 1)) != 0)
+        {
+            ++b;
+        }
+        ++m_buckets[b];
+        ++m_count;
+        m_total += latency;
+        if (latency > m_max)
+        {
+            m_max = latency;
+        }
+    }
+
+    uint64_t GetCount() const { return m_count; }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& h);
+
+    /// Registers the buckets, count, total and maximum as sample variables
+    /// whose names start with name, e.g. name_16 for the bucket from 16
+    void RegisterSampleVariables(const std::string& name);
+
+    /// Prints the column names of a table of histograms
+    static void PrintHeader(std::ostream& out);
+
+    /// Prints the histogram as a row of the table
+    void Print(std::ostream& out, const std::string& name) const;
+
+    LatencyHistogram();
+
+private:
+    uint64_t m_buckets[NUM_BUCKETS];
+    uint64_t m_count;
+    uint64_t m_total;
+    CycleNo  m_max;
+};
+
+}
+#endif
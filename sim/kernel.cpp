@@ -1,6 +1,5 @@
 #include "kernel.h"
 #include "storage.h"
-#include "arch/dev/Display.h"
 #include "sampling.h"
 
 #include <cassert>
@@ -12,6 +11,7 @@
 #include <set>
 #include <map>
 #include <cstdio>
+#include <sys/time.h>
 
 using namespace std;
 
@@ -247,150 +247,170 @@ RunState Kernel::Step(CycleNo cycles)
         
         m_aborted = m_suspended = false;
         bool idle = false;
-        while (!m_aborted && (!m_suspended || (m_lastsuspend == m_cycle)) && !idle && (endcycle == INFINITE_CYCLES || m_cycle < endcycle))
+        for (;;)
         {
-            // We start each cycle being idle, and see if we did something this cycle
-            idle = true;
-
-            //
-            // Acquire phase
-            //
-            m_phase = PHASE_ACQUIRE;
-            for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
+            // Run the cycles up to the end, or up to the next host hook check.
+            // The hooks are checked when this loop stops, so the loop itself
+            // does not test for them.
+            const CycleNo stopcycle = std::min(endcycle, m_nextHostHook);
+            while (!m_aborted && (!m_suspended || (m_lastsuspend == m_cycle)) && !idle && m_cycle < stopcycle)
             {
-                for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+                // We start each cycle being idle, and see if we did something this cycle
+                idle = true;
+
+                //
+                // Acquire phase
+                //
+                m_phase = PHASE_ACQUIRE;
+                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
                 {
-                    m_process   = process;
+                    for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+                    {
+                        m_process   = process;
                     
-                    // This process begins the cycle
-                    // This is a purely administrative function and has no simulation effect.
-                    process->OnBeginCycle();
+                        // This process begins the cycle
+                        // This is a purely administrative function and has no simulation effect.
+                        process->OnBeginCycle();
                             
-                    // If we fail in the acquire stage, don't bother with the check and commit stages
-                    Result result = process->m_delegate();
-                    if (result == SUCCESS)
-                    {
-                        process->m_state = STATE_RUNNING;
-                    }
-                    else
-                    {
-                        assert(result == FAILED);
-                        process->m_state = STATE_DEADLOCK;
-                        ++process->m_stalls;
+                        // If we fail in the acquire stage, don't bother with the check and commit stages
+                        Result result = process->m_delegate();
+                        if (result == SUCCESS)
+                        {
+                            process->m_state = STATE_RUNNING;
+                        }
+                        else
+                        {
+                            assert(result == FAILED);
+                            process->m_state = STATE_DEADLOCK;
+                            ++process->m_stalls;
+                        }
                     }
                 }
-            }
             
-            //
-            // Arbitrate phase
-            //
-            for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
-            {
-                for (Arbitrator* arbitrator = clock->m_activeArbitrators; arbitrator != NULL; arbitrator = arbitrator->m_next)
+                //
+                // Arbitrate phase
+                //
+                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
                 {
-                    arbitrator->OnArbitrate();
-                    arbitrator->m_activated = false;
+                    for (Arbitrator* arbitrator = clock->m_activeArbitrators; arbitrator != NULL; arbitrator = arbitrator->m_next)
+                    {
+                        arbitrator->OnArbitrate();
+                        arbitrator->m_activated = false;
+                    }
+                    clock->m_activeArbitrators = NULL;
                 }
-                clock->m_activeArbitrators = NULL;
-            }
             
-            //
-            // Commit phase
-            //
-            for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
-            {
-                for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
+                //
+                // Commit phase
+                //
+                for (Clock* clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = clock->m_next)
                 {
-                    if (process->m_state != STATE_DEADLOCK)
+                    for (Process* process = clock->m_activeProcesses; process != NULL; process = process->m_next)
                     {
-                        m_process   = process;
-                        m_phase     = PHASE_CHECK;
-                
-                        Result result = process->m_delegate();
-                        if (result == SUCCESS)
+                        if (process->m_state != STATE_DEADLOCK)
                         {
-                            // This process is done this cycle.
-                            // This is a purely administrative function and has no simulation effect.
-                            // We call this before the COMMIT phase, so that if this produces an error,
-                            // we can still inspect the state that caused it.
-                            process->OnEndCycle();
+                            m_process   = process;
+                            m_phase     = PHASE_CHECK;
+                
+                            Result result = process->m_delegate();
+                            if (result == SUCCESS)
+                            {
+                                // This process is done this cycle.
+                                // This is a purely administrative function and has no simulation effect.
+                                // We call this before the COMMIT phase, so that if this produces an error,
+                                // we can still inspect the state that caused it.
+                                process->OnEndCycle();
                             
-                            m_phase = PHASE_COMMIT;
-                            result = process->m_delegate();
+                                m_phase = PHASE_COMMIT;
+                                result = process->m_delegate();
                             
-                            // If the CHECK succeeded, the COMMIT cannot fail
-                            assert(result == SUCCESS);
-                            process->m_state = STATE_RUNNING;
+                                // If the CHECK succeeded, the COMMIT cannot fail
+                                assert(result == SUCCESS);
+                                process->m_state = STATE_RUNNING;
                     
-                            // We've done something -- we're not idle
-                            idle = false;
-                        }
-                        else
-                        {
-                            // If a process has nothing to do (DELAYED) it shouldn't have been
-                            // called in the first place.
-                            assert(result == FAILED);
-                            process->m_state = STATE_DEADLOCK;
+                                // We've done something -- we're not idle
+                                idle = false;
+                            }
+                            else
+                            {
+                                // If a process has nothing to do (DELAYED) it shouldn't have been
+                                // called in the first place.
+                                assert(result == FAILED);
+                                process->m_state = STATE_DEADLOCK;
+                            }
                         }
                     }
                 }
-            }
 
-            // Process the requested storage updates
-            // This can activate or deactivate processes due to changes in storages
-            // made by processes run in this cycle.
-            if (UpdateStorages())
-            {
-                // We've update at least one storage
-                idle = false;
-            }
+                // Process the requested storage updates
+                // This can activate or deactivate processes due to changes in storages
+                // made by processes run in this cycle.
+                if (UpdateStorages())
+                {
+                    // We've update at least one storage
+                    idle = false;
+                }
                 
-            if (idle)
-            {
-                // We haven't done anything this cycle. Check if there are clocks scheduled
-                // for cycles in the future. If so, we want to still advance the simulation.
-                for (Clock* clock = m_activeClocks; clock != NULL; clock = clock->m_next)
+                if (idle)
                 {
-                    if (clock->m_cycle > m_cycle)
+                    // We haven't done anything this cycle. Check if there are clocks scheduled
+                    // for cycles in the future. If so, we want to still advance the simulation.
+                    for (Clock* clock = m_activeClocks; clock != NULL; clock = clock->m_next)
                     {
-                        idle = false;
-                        break;
+                        if (clock->m_cycle > m_cycle)
+                        {
+                            idle = false;
+                            break;
+                        }
                     }
                 }
-            }
             
-            if (Display::GetDisplay())
-                Display::GetDisplay()->OnCycle(m_cycle);
-
-            if (!idle)
-            {
-                // Advance the simulation
-                
-                // Update the clocks
-                for (Clock *next, *clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = next)
+                if (!idle)
                 {
-                    next = clock->m_next;
+                    // Advance the simulation
+                
+                    // Update the clocks
+                    for (Clock *next, *clock = m_activeClocks; clock != NULL && m_cycle == clock->m_cycle; clock = next)
+                    {
+                        next = clock->m_next;
 
-                    // We ran this clock, remove it from the queue
-                    m_activeClocks = clock->m_next;
-                    clock->m_activated = false;
+                        // We ran this clock, remove it from the queue
+                        m_activeClocks = clock->m_next;
+                        clock->m_activated = false;
 
-                    assert(clock->m_activeArbitrators == NULL);
+                        assert(clock->m_activeArbitrators == NULL);
 
-                    if (clock->m_activeProcesses != NULL || clock->m_activeStorages != NULL)
-                    {
-                        // This clock still has active components, reschedule it
-                        ActivateClock(*clock);
+                        if (clock->m_activeProcesses != NULL || clock->m_activeStorages != NULL)
+                        {
+                            // This clock still has active components, reschedule it
+                            ActivateClock(*clock);
+                        }
                     }
-                }
                 
-                // Advance time to first clock to run
-                if (m_activeClocks != NULL)
-                {
-                    assert(m_activeClocks->m_cycle > m_cycle);
-                    m_cycle = m_activeClocks->m_cycle;
+                    // Advance time to first clock to run
+                    if (m_activeClocks != NULL)
+                    {
+                        assert(m_activeClocks->m_cycle > m_cycle);
+                        m_cycle = m_activeClocks->m_cycle;
+                    }
                 }
             }
+
+            if (m_cycle >= m_nextHostHook)
+            {
+                RunHostHooks();
+            }
+
+            if (idle && !IsStopRequested() && WaitForHost())
+            {
+                // A host hook woke up the simulation
+                idle = false;
+            }
+
+            if (m_aborted || (m_suspended && m_lastsuspend != m_cycle) || idle || m_cycle >= endcycle)
+            {
+                break;
+            }
         }
         
         // In case we overshot the end with the last update
@@ -416,6 +436,162 @@ RunState Kernel::Step(CycleNo cycles)
     }
 }
 
+static uint64_t GetHostTime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void Kernel::RegisterHostHook(IHostHook& hook, CycleNo cycles, uint64_t us)
+{
+    assert(cycles != 0 || us != 0);
+
+    const uint64_t now = GetHostTime();
+    HostHook h;
+    h.hook       = &hook;
+    h.period     = cycles;
+    h.interval   = us;
+    h.next_cycle = m_cycle + cycles;
+    h.next_time  = now + us;
+    m_hostHooks.push_back(h);
+    ScheduleHostHooks(now);
+}
+
+void Kernel::SetHostHookPeriod(IHostHook& hook, CycleNo cycles, uint64_t us)
+{
+    assert(cycles != 0 || us != 0);
+
+    const uint64_t now = GetHostTime();
+    for (std::vector<HostHook>::iterator p = m_hostHooks.begin(); p != m_hostHooks.end(); ++p)
+    {
+        if (p->hook == &hook)
+        {
+            p->period     = cycles;
+            p->interval   = us;
+            p->next_cycle = m_cycle + cycles;
+            p->next_time  = now + us;
+        }
+    }
+    ScheduleHostHooks(now);
+}
+
+void Kernel::UnregisterHostHook(IHostHook& hook)
+{
+    for (std::vector<HostHook>::iterator p = m_hostHooks.begin(); p != m_hostHooks.end(); ++p)
+    {
+        if (p->hook == &hook)
+        {
+            // The next check is left as it is; a check with nothing
+            // due only reschedules the remaining hooks.
+            m_hostHooks.erase(p);
+            break;
+        }
+    }
+}
+
+void Kernel::RunHostHooks()
+{
+    const uint64_t now = GetHostTime();
+    
+    // A hook can register or unregister hooks, so we copy the
+    // ones that are due before running them.
+    std::vector<IHostHook*> due;
+    for (std::vector<HostHook>::iterator p = m_hostHooks.begin(); p != m_hostHooks.end(); ++p)
+    {
+        if (p->period != 0 ? (m_cycle >= p->next_cycle) : (now >= p->next_time))
+        {
+            p->next_cycle = m_cycle + p->period;
+            p->next_time  = now + p->interval;
+            due.push_back(p->hook);
+        }
+    }
+    
+    ScheduleHostHooks(now);
+    
+    // Hooks may set flags to activate processes, as if committing
+    const CyclePhase phase = m_phase;
+    m_phase = PHASE_COMMIT;
+    for (std::vector<IHostHook*>::const_iterator p = due.begin(); p != due.end(); ++p)
+    {
+        (*p)->OnHostHook(m_cycle);
+    }
+    m_phase = phase;
+}
+
+bool Kernel::WaitForHost()
+{
+    std::vector<IHostHook*> hooks;
+    for (std::vector<HostHook>::const_iterator p = m_hostHooks.begin(); p != m_hostHooks.end(); ++p)
+    {
+        hooks.push_back(p->hook);
+    }
+
+    const CyclePhase phase = m_phase;
+    m_phase = PHASE_COMMIT;
+    bool woken = false;
+    for (std::vector<IHostHook*>::const_iterator p = hooks.begin(); p != hooks.end() && !woken; ++p)
+    {
+        woken = (*p)->OnHostIdle();
+    }
+    m_phase = phase;
+
+    if (woken)
+    {
+        // The time spent waiting says nothing about the simulation
+        // speed, so it does not count for the host time estimate.
+        m_lastHostTime = GetHostTime();
+    }
+    return woken;
+}
+
+void Kernel::ScheduleHostHooks(uint64_t now)
+{
+    CycleNo  next      = INFINITE_CYCLES;
+    uint64_t next_time = (uint64_t)-1;
+    for (std::vector<HostHook>::const_iterator p = m_hostHooks.begin(); p != m_hostHooks.end(); ++p)
+    {
+        if (p->period != 0) {
+            next = std::min(next, p->next_cycle);
+        } else {
+            next_time = std::min(next_time, p->next_time);
+        }
+    }
+    
+    if (next_time != (uint64_t)-1)
+    {
+        /*
+         The cycle loop does not look at the host clock, so host time hooks
+         are checked at the master cycle where the earliest one is estimated
+         to become due, from the simulation speed since the last check.
+         The distance between checks at most doubles from one check to the
+         next, so that a sudden increase in simulation speed does not make
+         us overshoot much.
+        */
+        const CycleNo  cycles  = m_cycle - m_lastHostCheck;
+        const uint64_t elapsed = now - m_lastHostTime;
+        CycleNo distance = m_hostCheckCycles * 2 + 1;
+        if (elapsed > 0 && next_time > now)
+        {
+            const double estimate = (double)cycles * (next_time - now) / elapsed;
+            if (estimate < distance) {
+                distance = (CycleNo)estimate;
+            }
+        }
+        else if (next_time <= now)
+        {
+            distance = 1;
+        }
+        distance = std::max<CycleNo>(distance, 1);
+        
+        m_lastHostCheck   = m_cycle;
+        m_lastHostTime    = now;
+        m_hostCheckCycles = distance;
+        next = std::min(next, m_cycle + distance);
+    }
+    m_nextHostHook = next;
+}
+
 void Kernel::ActivateClock(Clock& clock)
 {
     if (!clock.m_activated)
@@ -488,7 +664,11 @@ Kernel::Kernel(SymbolTable& symtable, BreakPoints& breakpoints)
    m_phase(PHASE_COMMIT),
    m_master_freq(0),
    m_process(NULL),
-   m_activeClocks(NULL)
+   m_activeClocks(NULL),
+   m_nextHostHook(INFINITE_CYCLES),
+   m_lastHostCheck(0),
+   m_lastHostTime(0),
+   m_hostCheckCycles(0)
 {
     RegisterSampleVariable(m_cycle, "kernel.cycle", SVC_CUMULATIVE);
     RegisterSampleVariable(m_phase, "kernel.phase", SVC_STATE);
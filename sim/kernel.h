@@ -217,6 +217,31 @@ enum CyclePhase {
 #define DeadlockWrite(msg, ...)  do { if (GetKernel()->GetDebugMode() & Kernel::DEBUG_DEADLOCK) DeadlockWrite_((msg), ##__VA_ARGS__); } while(false)
 #define OutputWrite(msg, ...)    do { if (GetKernel()->GetCyclePhase() == PHASE_COMMIT) OutputWrite_((msg), ##__VA_ARGS__); } while(false)
 
+/**
+ * @brief Interface for periodic host-side work.
+ * Host hooks are run by the kernel between cycles, either every number of
+ * master cycles or every interval of host time. They are meant for work
+ * outside the simulated system, such as refreshing the display, polling
+ * host file descriptors or sampling statistics. They must not access
+ * storages, except to set the flag that activates the process
+ * handling the host-side work; the change takes effect on the next cycle.
+ */
+class IHostHook
+{
+public:
+    virtual void OnHostHook(CycleNo cycle) = 0;
+
+    /**
+     * @brief Called when the simulation has become idle.
+     * A hook that can still activate a process because of something on the
+     * host, such as input on a file descriptor, may wait for it here.
+     * @return true if a process was activated and the simulation continues.
+     */
+    virtual bool OnHostIdle() { return false; }
+
+    virtual ~IHostHook() {}
+};
+
 /**
  * @brief Component-manager class
  * The kernel class is the manager for all components in the simulation. It advances
@@ -257,7 +282,24 @@ private:
     std::vector<Clock*> m_clocks;       ///< All clocks in the system.
     Clock*              m_activeClocks; ///< The clocks that have active components
 
+    struct HostHook
+    {
+        IHostHook*   hook;
+        CycleNo      period;     ///< Period in master cycles, or 0 for a host time hook
+        uint64_t     interval;   ///< Period in host microseconds, for a host time hook
+        CycleNo      next_cycle; ///< Master cycle at which the cycle hook is due
+        uint64_t     next_time;  ///< Host time at which the host time hook is due
+    };
+    std::vector<HostHook> m_hostHooks;      ///< All registered host hooks.
+    CycleNo             m_nextHostHook;     ///< Master cycle of the next host hook check.
+    CycleNo             m_lastHostCheck;    ///< Master cycle of the last host time check.
+    uint64_t            m_lastHostTime;     ///< Host time of the last host time check.
+    CycleNo             m_hostCheckCycles;  ///< Master cycles between the last two host time checks.
+
     bool UpdateStorages();
+    void RunHostHooks();
+    bool WaitForHost();
+    void ScheduleHostHooks(uint64_t now);
     
 public:
     Kernel(SymbolTable& symtable, BreakPoints& breakpoints);
@@ -269,6 +311,25 @@ public:
      * @brief Creates a clock at the specified frequency (in MHz).
      */    
     Simulator::Clock& CreateClock(unsigned long mhz);
+
+    /**
+     * @brief Registers a periodic host hook.
+     * The hook runs every number of master cycles if cycles is non-zero,
+     * otherwise every interval of host time. Hooks are checked between
+     * runs of the cycle loop, so they cost nothing on cycles where no
+     * hook is due; a host time hook is checked at the cycle where it is
+     * estimated to become due from the current simulation speed.
+     * @param hook the hook to run.
+     * @param cycles the period in master cycles, or 0.
+     * @param us the period in host microseconds, if cycles is 0.
+     */
+    void RegisterHostHook(IHostHook& hook, CycleNo cycles, uint64_t us);
+
+    /// Changes the period of a registered host hook, see RegisterHostHook.
+    void SetHostHookPeriod(IHostHook& hook, CycleNo cycles, uint64_t us);
+
+    /// Removes a registered host hook.
+    void UnregisterHostHook(IHostHook& hook);
     
     /**
      * @brief Returns the master frequency for the simulation, in MHz
@@ -341,6 +402,12 @@ public:
      */
     void Stop();
 
+    /**
+     * @brief Checks if the current run was asked to stop
+     * Tells hooks that wait in OnHostIdle() that Abort() or Stop() was called.
+     */
+    inline bool IsStopRequested() const { return m_aborted || (m_suspended && m_lastsuspend != m_cycle); }
+
     /**
      * @brief Get all components.
      * Gets the list of all components in the simulation.
@@ -4,33 +4,16 @@
 #include <fstream>
 #include <iomanip>
 #include <cmath>
-#include <signal.h>
+#include <algorithm>
 #include <sys/time.h>
-#include <unistd.h>
-
-#define pthread(Function, ...) do { if (pthread_ ## Function(__VA_ARGS__)) perror("pthread_" #Function); } while(0)
-
-void* runmonitor(void *arg)
-{
-    sigset_t sigset;
-    sigemptyset(&sigset);
-    sigaddset(&sigset, SIGINT);
-    sigaddset(&sigset, SIGQUIT);
-    sigaddset(&sigset, SIGHUP);
-    sigaddset(&sigset, SIGTERM);
-    pthread_sigmask(SIG_BLOCK, &sigset, 0);
-
-    Monitor *m = (Monitor*) arg;
-    m->run();
-    return 0;
-}
 
 Monitor::Monitor(Simulator::MGSystem& sys, bool enabled, const std::string& mdfile, const std::string& outfile, bool quiet)
     : m_sys(sys), 
       m_outputfile(0),
       m_quiet(quiet),
+      m_delay(0),
       m_running(false),
-      m_enabled(true),
+      m_lastCycle(0),
       m_sampler(0)
 {
     if (!enabled)
@@ -69,24 +52,21 @@ Monitor::Monitor(Simulator::MGSystem& sys, bool enabled, const std::string& mdfi
         return ;
     }
 
+    // The samples are taken by the kernel between cycles, see OnHostHook.
     float msd = sys.GetConfig().getValue<float>("MonitorSampleDelay");
-    msd = fabs(msd);
-    m_tsdelay.tv_sec = msd;
-    m_tsdelay.tv_nsec = (msd - (float)m_tsdelay.tv_sec) * 1000000000.;
+    m_delay = std::max(1.0, fabs(msd) * 1000000.);
    
     if (!m_quiet)
         std::clog << "# monitoring enabled, sampling "
                   << m_sampler->GetBufferSize()
                   << " bytes every "
-                  << m_tsdelay.tv_sec << '.'
-                  << std::setfill('0') << std::setw(9) << m_tsdelay.tv_nsec 
+                  << m_delay / 1000000 << '.'
+                  << std::setfill('0') << std::setw(6) << m_delay % 1000000
                   << "s to file " << outfile << std::endl
                   << "# metadata output to file " << mdfile << std::endl;
 
-    pthread(mutex_init, &m_runlock, 0);
-    pthread(mutex_lock, &m_runlock);
-
-    pthread(create, &m_monitorthread, 0, runmonitor, this);
+    m_buffer.resize(m_sampler->GetBufferSize() + 2 * sizeof(struct timeval));
+    m_sys.GetKernel().RegisterHostHook(*this, 0, m_delay);
 }
 
 Monitor::~Monitor()
@@ -96,10 +76,7 @@ Monitor::~Monitor()
         if (!m_quiet)
             std::clog << "# shutting down monitoring..." << std::endl;
 
-        m_enabled = false;
-        pthread(mutex_unlock, &m_runlock);
-        pthread(join, m_monitorthread, 0);
-        pthread(mutex_destroy, &m_runlock);
+        m_sys.GetKernel().UnregisterHostHook(*this);
 
         m_outputfile->close();
         delete m_outputfile;
@@ -115,7 +92,6 @@ void Monitor::start()
         if (!m_quiet)
             std::clog << "# starting monitor..." << std::endl;
         m_running = true;
-        pthread(mutex_unlock, &m_runlock);
     }
 }
 
@@ -124,50 +100,25 @@ void Monitor::stop()
     if (m_running) {
         if (!m_quiet)
             std::clog << "# stopping monitor..." << std::endl;
-        pthread(mutex_lock, &m_runlock);
         m_running = false;
     }
 }
 
-void Monitor::run()
+void Monitor::OnHostHook(Simulator::CycleNo cycle)
 {
-    if (!m_quiet)
-        std::clog << "# monitor thread started." << std::endl;
-
-    const size_t datasz = m_sampler->GetBufferSize();
-    const size_t allsz = datasz + 2 * sizeof(struct timeval);
-    char *allbuf = new char[allsz];
+    if (!m_running || cycle == m_lastCycle)
+        // nothing to do
+        return;
+    m_lastCycle = cycle;
 
+    char *allbuf = &m_buffer[0];
     struct timeval *tv_begin = (struct timeval*)(void*)allbuf;
     struct timeval *tv_end = (struct timeval*)(void*)(allbuf + sizeof(struct timeval));
     char *databuf = allbuf + 2 * sizeof(struct timeval);
 
-    Simulator::CycleNo lastCycle = 0;
+    gettimeofday(tv_begin, 0);
+    m_sampler->SampleToBuffer(databuf);
+    gettimeofday(tv_end, 0);
 
-    while (m_enabled) 
-    {
-#if defined(HAVE_NANOSLEEP)
-        nanosleep(&m_tsdelay, 0);
-#elif defined(HAVE_USLEEP)
-        usleep(m_tsdelay.tv_sec * 1000000 + m_tsdelay.tv_usec);
-#else
-#error No sub-microsecond wait available on this system.
-#endif
-
-        Simulator::CycleNo currentCycle = m_sys.GetKernel().GetCycleNo();
-        if (currentCycle == lastCycle)
-            // nothing to do
-            continue;
-        lastCycle = currentCycle;
-
-        pthread(mutex_lock, &m_runlock);
-
-        gettimeofday(tv_begin, 0);
-        m_sampler->SampleToBuffer(databuf);
-        gettimeofday(tv_end, 0);
-
-        m_outputfile->write(allbuf, allsz); 
-
-        pthread(mutex_unlock, &m_runlock);
-    }
+    m_outputfile->write(allbuf, m_buffer.size()); 
 }
@@ -5,30 +5,28 @@
 #include "sampling.h"
 
 #include <fstream>
-#include <ctime>
-#include <pthread.h>
+#include <vector>
 
-class Monitor
+class Monitor : public Simulator::IHostHook
 {
     Simulator::MGSystem&  m_sys;
     std::ofstream*        m_outputfile;
     bool                  m_quiet;
-    struct timespec       m_tsdelay;
+    uint64_t              m_delay;      ///< Host microseconds between samples
     
-    pthread_t             m_monitorthread;
-    pthread_mutex_t       m_runlock;
     bool                  m_running;
-    volatile bool         m_enabled;
+    Simulator::CycleNo    m_lastCycle;
+    std::vector<char>     m_buffer;
 
     BinarySampler*        m_sampler;
 
-    friend void* runmonitor(void*);
-    void run();
-
 public:
     Monitor(Simulator::MGSystem& sys, bool enable, const std::string& mdfile, const std::string& outfile, bool quiet);
     ~Monitor();
 
+    // From IHostHook: take a sample
+    void OnHostHook(Simulator::CycleNo cycle);
+
     void start();
     void stop();
 };
@@ -6,18 +6,76 @@
 namespace Simulator
 {
 
-void SimpleArbitratedPort::AddRequest(const Process& process)
+size_t SimpleArbitratedPort::InsertRequest(const Process& process)
 {
-    if (std::find(m_requests.begin(), m_requests.end(), &process) != m_requests.end())
+    size_t id = m_processes.Find(process);
+    assert(id != ProcessSet::NONE);
+    if (m_requests.Contains(id))
     {
         // A process can request more than once in a cycle if the requester is in a higher frequency
         // domain than the arbitrator.
         
         // But obviously the clocks should differ, or else it's a bug.
         assert(&process.GetObject()->GetClock() != &m_object.GetClock());
-        return;
+        return id;
+    }
+    m_requests.Insert(id);
+    return id;
+}
+
+void SimpleArbitratedPort::AddContendedRequest(const Process& process)
+{
+    if (m_single != NULL)
+    {
+        if (m_single == &process)
+        {
+            // See InsertRequest
+            assert(&process.GetObject()->GetClock() != &m_object.GetClock());
+            return;
+        }
+
+        // A second process requests; move the first one into the set
+        InsertRequest(*m_single);
+        m_single = NULL;
+    }
+    InsertRequest(process);
+}
+
+void PriorityCyclicArbitratedPort::AddContendedRequest(const Process& process)
+{
+    if (m_single != NULL)
+    {
+        if (m_single == &process)
+        {
+            // See SimpleArbitratedPort::InsertRequest
+            assert(&process.GetObject()->GetClock() != &m_object.GetClock());
+            return;
+        }
+
+        // A second process requests; move the first one into the sets
+        InsertRequest(*m_single);
+        m_single = NULL;
+    }
+    InsertRequest(process);
+}
+
+void PriorityCyclicArbitratedPort::InsertRequest(const Process& process)
+{
+    size_t id = m_cyclicprocesses.Find(process);
+    if (id == ProcessSet::NONE)
+    {
+        // Not a cyclic process, so it should be a priority process
+        SimpleArbitratedPort::InsertRequest(process);
+    }
+    else if (!m_cyclicrequests.Contains(id))
+    {
+        m_cyclicrequests.Insert(id);
+    }
+    else
+    {
+        // See SimpleArbitratedPort::InsertRequest
+        assert(&process.GetObject()->GetClock() != &m_object.GetClock());
     }
-    m_requests.push_back(&process);
 }
 
 ArbitratedPort::ArbitratedPort(const Object& object, const std::string& name) 
@@ -32,97 +90,60 @@ ArbitratedPort::ArbitratedPort(const Object& object, const std::string& name)
 void PriorityCyclicArbitratedPort::Arbitrate()
 {
     m_selected = NULL;
-    if (!m_requests.empty())
+    if (m_single != NULL)
     {
-        if (m_requests.size() == 1)
-        {
-            // Optimization for common case
-            m_selected = *m_requests.begin();
-            
-            size_t maybe_cyclic_last = std::find(m_cyclicprocesses.begin(), m_cyclicprocesses.end(), m_selected) - m_cyclicprocesses.begin();
-            if (maybe_cyclic_last < m_cyclicprocesses.size())
-                m_lastSelected = maybe_cyclic_last;
-        }
-        else
+        // A single request; only a cyclic process moves the round-robin point
+        const size_t id = m_cyclicprocesses.Find(*m_single);
+        if (id != ProcessSet::NONE)
         {
-            // Choose the request with the highest priority
-            unsigned int highest = std::numeric_limits<unsigned int>::max();
-            for (ProcessList::const_iterator i = m_requests.begin(); i != m_requests.end(); ++i)
-            {
-                // The position in the vector is its priority
-                size_t priority = std::find(m_processes.begin(), m_processes.end(), *i) - m_processes.begin();
-                if (priority == m_processes.size())
-                {
-                    // this request is for a cyclic process, don't use
-                    // it as a candidate.
-                    continue;
-                }
-                else if (priority < highest)
-                {
-                    highest    = priority;
-                    m_selected = *i;
-                }
-            }
-
-            if (m_selected == NULL)
-            {
-                // no priority process found, the request is for a cyclic process.
-                size_t lowest = std::numeric_limits<size_t>::max();
-                for (ProcessList::const_iterator i = m_requests.begin(); i != m_requests.end(); ++i)
-                {
-                    size_t pos = std::find(m_cyclicprocesses.begin(), m_cyclicprocesses.end(), *i) - m_cyclicprocesses.begin();
-                    assert(pos < m_cyclicprocesses.size());
-                    
-                    // Find the distance to the last selected
-                    pos = (pos + m_cyclicprocesses.size() - m_lastSelected) % m_cyclicprocesses.size();
-                    if (pos != 0 && pos < lowest)
-                    {
-                        lowest     = pos;
-                        m_selected = *i;
-                    }
-                }
-                
-                // Remember which one we selected
-                m_lastSelected = (m_lastSelected + lowest) % m_cyclicprocesses.size();
-
-            }
+            m_lastSelected = id;
         }
-
-        assert(m_selected != NULL);
-        m_requests.clear();
+        m_selected = m_single;
+        m_single   = NULL;
         m_busyCycles++;
+        return;
+    }
+
+    if (!m_requests.Empty())
+    {
+        // The ID of a priority process is its priority
+        m_selected = m_processes[m_requests.First()];
+    }
+    else if (!m_cyclicrequests.Empty())
+    {
+        // No priority process requested; choose the next cyclic
+        // process after the last selected one.
+        m_lastSelected = m_cyclicrequests.Next(m_lastSelected);
+        m_selected     = m_cyclicprocesses[m_lastSelected];
+    }
+    else
+    {
+        return;
     }
+
+    m_requests.Clear();
+    m_cyclicrequests.Clear();
+    m_busyCycles++;
 }
 
 
 void PriorityArbitratedPort::Arbitrate()
 {
-    m_selected = NULL;
-    if (!m_requests.empty())
+    m_selected   = NULL;
+    m_selectedID = ProcessSet::NONE;
+    if (m_single != NULL)
     {
-        if (m_requests.size() == 1)
-        {
-            // Optimization for common case
-            m_selected = *m_requests.begin();
-        }
-        else
-        {
-            // Choose the request with the highest priority
-            size_t highest = std::numeric_limits<size_t>::max();
-            for (ProcessList::const_iterator i = m_requests.begin(); i != m_requests.end(); ++i)
-            {
-                // The position in the vector is its priority
-                size_t priority = std::find(m_processes.begin(), m_processes.end(), *i) - m_processes.begin();
-                assert(priority < m_processes.size());
-                if (priority < highest)
-                {
-                    highest    = priority;
-                    m_selected = *i;
-                }
-            }
-        }
-        assert(m_selected != NULL);
-        m_requests.clear();
+        // A single request wins without looking up its ID
+        m_selected = m_single;
+        m_single   = NULL;
+        m_busyCycles++;
+    }
+    else if (!m_requests.Empty())
+    {
+        // The ID of a process is its priority
+        m_selectedID = m_requests.First();
+        m_selected   = m_processes[m_selectedID];
+        m_requests.Clear();
         m_busyCycles++;
     }
 }
@@ -132,36 +153,28 @@ void CyclicArbitratedPort::Arbitrate()
     assert(m_lastSelected <= m_processes.size());
     
     m_selected = NULL;
-    if (!m_requests.empty())
+    if (m_single != NULL)
     {
-        if (m_requests.size() == 1)
-        {
-            m_selected     = *m_requests.begin();
-            m_lastSelected = std::find(m_processes.begin(), m_processes.end(), m_selected) - m_processes.begin();
-            assert(m_lastSelected < m_processes.size());
-        }
-        else
+        // A single request wins; its ID is only needed
+        // by the next arbitration between several requests.
+        m_selected    = m_single;
+        m_lastProcess = m_single;
+        m_single      = NULL;
+        m_busyCycles++;
+    }
+    else if (!m_requests.Empty())
+    {
+        if (m_lastProcess != NULL)
         {
-            size_t lowest = std::numeric_limits<size_t>::max();
-            for (ProcessList::const_iterator i = m_requests.begin(); i != m_requests.end(); ++i)
-            {
-                size_t pos = std::find(m_processes.begin(), m_processes.end(), *i) - m_processes.begin();
-                assert(pos < m_processes.size());
-        
-                // Find the distance to the last selected
-                pos = (pos + m_processes.size() - m_lastSelected) % m_processes.size();
-                if (pos != 0 && pos < lowest)
-                {
-                    lowest     = pos;
-                    m_selected = *i;
-                }
-            }
-        
-            // Remember which one we selected
-            m_lastSelected = (m_lastSelected + lowest) % m_processes.size();
+            m_lastSelected = m_processes.Find(*m_lastProcess);
+            m_lastProcess  = NULL;
         }
-        assert(m_selected != NULL);
-        m_requests.clear();
+
+        // Choose the first requesting process after the last selected one;
+        // this is the last selected one only if nobody else requested.
+        m_lastSelected = m_requests.Next(m_lastSelected);
+        m_selected     = m_processes[m_lastSelected];
+        m_requests.Clear();
         m_busyCycles++;
     }
 }
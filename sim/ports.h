@@ -2,11 +2,13 @@
 #define PORTS_H
 
 #include "kernel.h"
+#include "ctz.h"
 #include <cassert>
 #include <algorithm>
 #include <map>
 #include <set>
 #include <limits>
+#include <vector>
 
 namespace Simulator
 {
@@ -15,6 +17,157 @@ template <typename I> class Structure;
 template <typename I> class ArbitratedWritePort;
 class ArbitratedReadPort;
 
+//
+// ProcessSet
+//
+// A set of small integer process IDs, stored as a bit mask. Arbitrated
+// ports record requests in such a set so that choosing the winner is a
+// find-first-set (priority) or a rotated find-first-set (cyclic).
+//
+class ProcessSet
+{
+    typedef unsigned long long Word;
+    static const size_t WORD_BITS = sizeof(Word) * 8;
+
+    std::vector<Word> m_words;
+    size_t            m_count;  ///< Number of IDs in the set
+    size_t            m_last;   ///< Last inserted ID
+
+public:
+    static const size_t NONE = (size_t)-1;
+
+    /// Makes room for IDs [0, size)
+    void Resize(size_t size) {
+        m_words.resize((size + WORD_BITS - 1) / WORD_BITS, 0);
+    }
+
+    bool   Empty() const { return m_count == 0; }
+    size_t Size()  const { return m_count; }
+
+    bool Contains(size_t id) const {
+        return (m_words[id / WORD_BITS] >> (id % WORD_BITS)) & 1;
+    }
+
+    void Insert(size_t id) {
+        m_words[id / WORD_BITS] |= (Word)1 << (id % WORD_BITS);
+        m_count++;
+        m_last = id;
+    }
+
+    void Clear() {
+        if (m_count == 1) {
+            m_words[m_last / WORD_BITS] = 0;
+        } else if (m_count > 0) {
+            std::fill(m_words.begin(), m_words.end(), 0);
+        }
+        m_count = 0;
+    }
+
+    /// Returns the lowest ID that is equal to or higher than id, or NONE.
+    size_t Find(size_t id) const
+    {
+        size_t w = id / WORD_BITS;
+        if (w >= m_words.size()) {
+            return NONE;
+        }
+        Word bits = m_words[w] & (~(Word)0 << (id % WORD_BITS));
+        while (bits == 0) {
+            if (++w == m_words.size()) {
+                return NONE;
+            }
+            bits = m_words[w];
+        }
+        return w * WORD_BITS + ctzll(bits);
+    }
+
+    /// Returns the lowest ID in the set, or NONE.
+    size_t First() const {
+        // Optimization for the common case of a single ID
+        return (m_count == 1) ? m_last : Find(0);
+    }
+
+    /// Returns the first ID after id, wrapping around, or NONE.
+    /// id itself is only returned if it is the only ID in the set.
+    size_t Next(size_t id) const
+    {
+        if (m_count == 1) {
+            return m_last;
+        }
+        size_t next = Find(id + 1);
+        return (next != NONE) ? next : First();
+    }
+
+    ProcessSet() : m_count(0), m_last(NONE) {}
+};
+
+//
+// ProcessList
+//
+// The processes that can access a port. Each process is given an ID
+// in order of registration; for priority arbitration the ID is also
+// its priority. The ID of a process is found through a small hash
+// table, since ports are accessed far more often than they are set up.
+//
+class ProcessList
+{
+    typedef std::pair<const Process*, size_t> IndexEntry;
+
+    std::vector<const Process*> m_processes;  ///< Processes, by ID
+    std::vector<IndexEntry>     m_index;      ///< Open-addressed map from process to ID
+    size_t                      m_mask;       ///< m_index.size() - 1
+
+    size_t Hash(const Process* process) const {
+        // Multiplicative hash; processes are at least pointer-aligned.
+        return (size_t)(((unsigned long long)(uintptr_t)process >> 3) * 0x9E3779B97F4A7C15ULL >> 32) & m_mask;
+    }
+
+    void Insert(const Process* process, size_t id)
+    {
+        size_t h = Hash(process);
+        while (m_index[h].first != NULL) {
+            h = (h + 1) & m_mask;
+        }
+        m_index[h] = IndexEntry(process, id);
+    }
+
+public:
+    size_t Add(const Process& process)
+    {
+        size_t id = m_processes.size();
+        m_processes.push_back(&process);
+        if (m_processes.size() * 2 > m_index.size())
+        {
+            // Keep the table at most half full
+            m_index.assign(m_index.size() * 2, IndexEntry(NULL, 0));
+            m_mask = m_index.size() - 1;
+            for (size_t i = 0; i < m_processes.size(); ++i) {
+                Insert(m_processes[i], i);
+            }
+        }
+        else
+        {
+            Insert(&process, id);
+        }
+        return id;
+    }
+
+    /// Returns the ID of the process, or ProcessSet::NONE if it was not added.
+    size_t Find(const Process& process) const
+    {
+        for (size_t h = Hash(&process); m_index[h].first != NULL; h = (h + 1) & m_mask) {
+            if (m_index[h].first == &process) {
+                return m_index[h].second;
+            }
+        }
+        return ProcessSet::NONE;
+    }
+
+    const Process* operator[](size_t id) const { return m_processes[id]; }
+    size_t         size()                const { return m_processes.size(); }
+
+    ProcessList() : m_index(2, IndexEntry(NULL, 0)), m_mask(1) {}
+};
+
 //
 // ArbitratedPort
 //
@@ -51,27 +204,43 @@ class SimpleArbitratedPort : public ArbitratedPort
 {
 public:
     void AddProcess(const Process& process) {
-        m_processes.push_back(&process);
+        m_processes.Add(process);
+        m_requests.Resize(m_processes.size());
     }
 
 protected:
     bool CanAccess(const Process& process) const {
-        return !(std::find(m_processes.begin(), m_processes.end(), &process) == m_processes.end());
+        return m_processes.Find(process) != ProcessSet::NONE;
+    }
+
+    // Records the request. Most ports see a single request per cycle,
+    // so the first request is only kept as a pointer; the IDs are
+    // looked up once a second process requests.
+    void AddRequest(const Process& process) {
+        if (m_single == NULL && m_requests.Empty()) {
+            m_single = &process;
+        } else {
+            AddContendedRequest(process);
+        }
     }
 
-    void AddRequest(const Process& process);
+    // Records the request in m_requests and returns the ID of the process
+    size_t InsertRequest(const Process& process);
     
 SimpleArbitratedPort(const Object& object, const std::string& name)
-    : ArbitratedPort(object, name)
+    : ArbitratedPort(object, name),
+      m_single(NULL)
     {}
       
     virtual ~SimpleArbitratedPort() {}
 
 protected:
-    typedef std::vector<const Process*> ProcessList;
-
     ProcessList    m_processes;
-    ProcessList    m_requests;
+    ProcessSet     m_requests;
+    const Process* m_single;    ///< The only request so far, if not in a request set
+
+private:
+    void AddContendedRequest(const Process& process);
 
 };
 
@@ -82,7 +251,15 @@ public:
 
 protected:
 PriorityArbitratedPort(const Object& object, const std::string& name)
-    : SimpleArbitratedPort(object, name) {}
+    : SimpleArbitratedPort(object, name),
+        m_selectedID(ProcessSet::NONE) {}
+
+    // ID of the process selected in the last arbitration;
+    // only known if the requests went through InsertRequest
+    size_t GetSelectedID() const { return m_selectedID; }
+
+private:
+    size_t m_selectedID;
 };
 
 class CyclicArbitratedPort : public SimpleArbitratedPort
@@ -93,10 +270,12 @@ public:
 protected:
 CyclicArbitratedPort(const Object& object, const std::string& name)
     : SimpleArbitratedPort(object, name), 
-        m_lastSelected(0) {}
+        m_lastSelected(0),
+        m_lastProcess(NULL) {}
 
     
-    size_t m_lastSelected;
+    size_t         m_lastSelected;
+    const Process* m_lastProcess;   ///< Last selected process, if m_lastSelected has not been looked up
     
 };
 
@@ -110,7 +289,8 @@ public:
         SimpleArbitratedPort::AddProcess(process);
     }
     void AddCyclicProcess(const Process& process) {
-        m_cyclicprocesses.push_back(&process);
+        m_cyclicprocesses.Add(process);
+        m_cyclicrequests.Resize(m_cyclicprocesses.size());
     }
 
 protected:
@@ -120,12 +300,26 @@ PriorityCyclicArbitratedPort(const Object& object, const std::string& name)
 
     bool CanAccess(const Process& process) const {
         return SimpleArbitratedPort::CanAccess(process) 
-            || (std::find(m_cyclicprocesses.begin(), m_cyclicprocesses.end(), &process) != m_cyclicprocesses.end());
+            || (m_cyclicprocesses.Find(process) != ProcessSet::NONE);
+    }
+
+    void AddRequest(const Process& process) {
+        if (m_single == NULL && m_requests.Empty() && m_cyclicrequests.Empty()) {
+            m_single = &process;
+        } else {
+            AddContendedRequest(process);
+        }
     }
 
+    // Records the request in the priority or cyclic request set
+    void InsertRequest(const Process& process);
+
     ProcessList m_cyclicprocesses;
+    ProcessSet  m_cyclicrequests;
 
 private:
+    void AddContendedRequest(const Process& process);
+
     // hide AddProcess from base class to force use
     // of AddPriorityProcess above.
     void AddProcess(const Process& process);
@@ -313,29 +507,29 @@ ArbitratedReadPort(IStructure& structure, const std::string& name)
 template <typename I>
     class ArbitratedWritePort : public PriorityArbitratedPort, public WritePort<I>
 {
-    typedef std::map<const Process*, I> IndexMap;
-   
-    Structure<I>& m_structure;
-    IndexMap      m_indices;
+    Structure<I>&  m_structure;
+    std::vector<I> m_indices;   ///< Requested index, by process ID
 
     void AddRequest(const Process& process, const I& index)
     {
-        PriorityArbitratedPort::AddRequest(process);
-        m_indices[&process] = index;
+        // The index is kept by ID, so skip the single-request shortcut
+        size_t id = PriorityArbitratedPort::InsertRequest(process);
+        if (id >= m_indices.size()) {
+            m_indices.resize(id + 1);
+        }
+        m_indices[id] = index;
     }
     
 public:
     void Arbitrate()
     {
         PriorityArbitratedPort::Arbitrate();
-        const Process* process = GetSelectedProcess();
-        if (process != NULL)
+        if (GetSelectedProcess() != NULL)
         {
             // A process was selected; make its index active for
             // write port arbitration
-            typename IndexMap::const_iterator p = m_indices.find(process);
-            assert(p != m_indices.end());
-            this->SetIndex(p->second);
+            assert(GetSelectedID() < m_indices.size());
+            this->SetIndex(m_indices[GetSelectedID()]);
         }
     }
 
@@ -17,6 +17,7 @@ struct VarInfo
     SampleVariableDataType type;
     SampleVariableCategory cat;
     std::vector<char>      max;
+    bool *                 enabled; // NULL if always maintained
 
     VarInfo() {};
 };
@@ -26,7 +27,7 @@ typedef std::map<std::string, VarInfo> var_registry_t;
 static
 var_registry_t registry;
 
-void _RegisterSampleVariable(void *var, size_t width, const std::string& name, SampleVariableDataType type, SampleVariableCategory cat, void *maxval)
+void _RegisterSampleVariable(void *var, size_t width, const std::string& name, SampleVariableDataType type, SampleVariableCategory cat, void *maxval, bool *enabled)
 {
     assert (registry.find(name) == registry.end()); // no duplicates allowed.
 
@@ -36,6 +37,7 @@ void _RegisterSampleVariable(void *var, size_t width, const std::string& name, S
     vinfo.width = width;
     vinfo.type = type;
     vinfo.cat = cat;
+    vinfo.enabled = enabled;
     
     const char *maxdata = (const char*)maxval;
     for (size_t i = 0; i < width; ++i)
@@ -144,6 +146,19 @@ bool ReadSampleVariables(std::ostream& os, const std::string& pat)
     return some;
 }
 
+void EnableSampleVariables(const std::string& pat)
+{
+    for (var_registry_t::const_iterator i = registry.begin();
+         i != registry.end();
+         ++i)
+    {
+        if (i->second.enabled == NULL ||
+            FNM_NOMATCH == fnmatch(pat.c_str(), i->first.c_str(), 0))
+            continue;
+        *i->second.enabled = true;
+    }
+}
+
 typedef std::pair<const std::string*, const VarInfo*> varsel_t;
 typedef std::vector<varsel_t> varvec_t;
 
@@ -172,6 +187,8 @@ BinarySampler::BinarySampler(std::ostream& os, const Config& config,
         if (FNM_NOMATCH == fnmatch(i->c_str(), j->first.c_str(), 0))
             continue;
         vars.push_back(std::make_pair(&j->first, &j->second));
+        if (j->second.enabled != NULL)
+            *j->second.enabled = true;
     }
 
     if (vars.size() >= 2)
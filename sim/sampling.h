@@ -23,11 +23,21 @@ template<typename T> struct _sv_detect_type { static const SampleVariableDataTyp
 template<> struct _sv_detect_type<float> { static const SampleVariableDataType type = SV_FLOAT; };
 template<> struct _sv_detect_type<double> { static const SampleVariableDataType type = SV_FLOAT; };
 
+extern void _RegisterSampleVariable(void*, size_t, const std::string&, SampleVariableDataType, SampleVariableCategory, void*, bool*);
+
 template<typename T>
 void RegisterSampleVariable(T& var, const std::string& name, SampleVariableCategory cat, T max = (T)0)
 {
-    extern void _RegisterSampleVariable(void*, size_t, const std::string&, SampleVariableDataType, SampleVariableCategory, void*);
-    _RegisterSampleVariable(&var, sizeof(T), name, _sv_detect_type<T>::type, cat, &max);
+    _RegisterSampleVariable(&var, sizeof(T), name, _sv_detect_type<T>::type, cat, &max, NULL);
+}
+
+// Registers a variable that is only maintained on demand. The owner
+// keeps the variable up to date only while *enabled is true; the flag
+// is raised by EnableSampleVariables() when a pattern selects the variable.
+template<typename T>
+void RegisterOptionalSampleVariable(T& var, bool& enabled, const std::string& name, SampleVariableCategory cat, T max = (T)0)
+{
+    _RegisterSampleVariable(&var, sizeof(T), name, _sv_detect_type<T>::type, cat, &max, &enabled);
 }
 
 #define RegisterSampleVariableInObject(var, cat, ...)                       \
@@ -36,8 +46,12 @@ void RegisterSampleVariable(T& var, const std::string& name, SampleVariableCateg
 #define RegisterSampleVariableInObjectWithName(var, name, cat, ...)      \
     RegisterSampleVariable(var, GetFQN() + ':' + name, cat, ##__VA_ARGS__)
 
+#define RegisterOptionalSampleVariableInObject(var, enabled, cat, ...)      \
+    RegisterOptionalSampleVariable(var, enabled, GetFQN() + ':' + (#var + 2) , cat, ##__VA_ARGS__)
+
 void ListSampleVariables(std::ostream& os, const std::string &pat = "*");
 bool ReadSampleVariables(std::ostream& os, const std::string &pat = "*"); // returns "false" if no variables match.
+void EnableSampleVariables(const std::string &pat = "*"); // starts maintaining the optional variables that match.
 
 
 class Config;
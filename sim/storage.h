@@ -251,6 +251,7 @@ class Buffer : public SensitiveStorage
     T             m_new[MAX_PUSHES]; ///< The items being pushed (when m_pushes > 0)
 
     // Statistics
+    bool          m_statistics;     ///< Maintain the occupancy statistics?
     uint64_t      m_stalls;         ///< Number of stalls so far
     CycleNo       m_lastcycle;      ///< Cycle no of last event
     uint64_t      m_totalsize;      ///< Cumulated current size * cycle no
@@ -280,7 +281,10 @@ class Buffer : public SensitiveStorage
         m_pushes = 0;
         m_popped = false;
 
-        COMMIT{
+        // The occupancy statistics are only maintained when sampled.
+        // Storages are updated after the processes have run, so the
+        // phase is that of the last process and cannot be tested here.
+        if (m_statistics) {
             // Update statistics
             CycleNo cycle = GetKernel()->GetCycleNo();
             CycleNo elapsed = cycle - m_lastcycle;
@@ -365,11 +369,11 @@ public:
           Storage(name, parent, clock),
           SensitiveStorage(name, parent, clock),
           m_maxSize(maxSize), m_maxPushes(maxPushes), m_popped(false), m_pushes(0),
-          m_stalls(0), m_lastcycle(0), m_totalsize(0), m_maxsize(0)
+          m_statistics(false), m_stalls(0), m_lastcycle(0), m_totalsize(0), m_maxsize(0), m_cursize(0)
     {
-        RegisterSampleVariableInObject(m_totalsize, SVC_CUMULATIVE);
-        RegisterSampleVariableInObject(m_maxsize, SVC_WATERMARK, maxSize);
-        RegisterSampleVariableInObject(m_cursize, SVC_LEVEL);
+        RegisterOptionalSampleVariableInObject(m_totalsize, m_statistics, SVC_CUMULATIVE);
+        RegisterOptionalSampleVariableInObject(m_maxsize, m_statistics, SVC_WATERMARK, maxSize);
+        RegisterOptionalSampleVariableInObject(m_cursize, m_statistics, SVC_LEVEL);
         RegisterSampleVariableInObject(m_stalls, SVC_CUMULATIVE);
         assert(maxPushes <= MAX_PUSHES);
     }
@@ -456,6 +460,7 @@ protected:
     bool m_new;
 
     // Statistics
+    bool          m_statistics;     ///< Maintain the occupancy statistics?
     uint64_t      m_stalls;         ///< Number of stalls so far
     CycleNo       m_lastcycle;      ///< Cycle no of last event
     uint64_t      m_totalsize;      ///< Cumulated current size * cycle no
@@ -466,7 +471,9 @@ protected:
         m_set     = m_new;
         m_updated = false;
 
-        COMMIT{
+        // The occupancy statistics are only maintained when sampled
+        // (not under COMMIT, see Buffer::Update)
+        if (m_statistics) {
             // Update statistics
             CycleNo cycle = GetKernel()->GetCycleNo();
             CycleNo elapsed = cycle - m_lastcycle;
@@ -520,9 +527,9 @@ public:
     Flag(const std::string& name, Object& parent, Clock& clock, bool set)
         : Object(name, parent, clock), Storage(name, parent, clock),
           m_set(false), m_updated(false), m_new(set),
-          m_stalls(0), m_lastcycle(0), m_totalsize(0)
+          m_statistics(false), m_stalls(0), m_lastcycle(0), m_totalsize(0)
     {
-        RegisterSampleVariableInObject(m_totalsize, SVC_CUMULATIVE);
+        RegisterOptionalSampleVariableInObject(m_totalsize, m_statistics, SVC_CUMULATIVE);
         RegisterSampleVariableInObject(m_set, SVC_LEVEL);
         RegisterSampleVariableInObject(m_stalls, SVC_CUMULATIVE);
         if (set) {